@@ -0,0 +1,47 @@
+#version 460 core
+
+//---------------------------------------------------------------
+// [SECTION] Input data & output variables
+//---------------------------------------------------------------
+
+#ifdef XE_ALPHA_CUTOUT
+in vec2 textureCoord;
+
+uniform vec4 baseColorFactor;
+uniform float alphaCutoff;
+uniform bool usingAlbedoMap;
+
+layout(binding = 0) uniform sampler2D albedoMap;
+#endif
+
+#ifdef XE_OBJECT_ID
+// Single sampled object ID pass of multisampled framebuffers
+uniform int objectID;
+
+layout(location = 1) out int fragObjectID;
+#endif
+
+// NOTE: Without XE_OBJECT_ID there are no color outputs, the depth prepass renders with the color mask disabled
+
+
+//---------------------------------------------------------------
+// [SECTION] Main program
+//---------------------------------------------------------------
+
+void main() {
+#ifdef XE_ALPHA_CUTOUT
+	// Same test as pbr.frag so both passes produce the same coverage
+	float alpha = baseColorFactor.a;
+	if(usingAlbedoMap) {
+		alpha = alpha * texture(albedoMap, textureCoord).a;
+	}
+
+	if(alpha < alphaCutoff) {
+		discard;
+	}
+#endif
+
+#ifdef XE_OBJECT_ID
+	fragObjectID = objectID;
+#endif
+}
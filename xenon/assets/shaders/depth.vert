@@ -0,0 +1,64 @@
+#version 460 core
+
+//---------------------------------------------------------------
+// [SECTION] Input data & output variables
+//---------------------------------------------------------------
+
+#ifdef XE_QUANTIZED_VERTICES
+// VertexFormat::QUANTIZED
+layout(location = 0) in vec3 in_position;		// unorm16, dequantized with positionOffset and positionScale
+layout(location = 3) in vec2 in_textureCoord;	// Half float
+
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+#else
+layout(location = 0) in vec3 in_position;
+layout(location = 3) in vec2 in_textureCoord;
+#endif
+
+#ifdef XE_ALPHA_CUTOUT
+out vec2 textureCoord;
+#endif
+
+// NOTE: Must produce bit identical depth to pbr.vert, the main pass tests against it with GL_EQUAL
+invariant gl_Position;
+
+
+//---------------------------------------------------------------
+// [SECTION] Matricies
+//---------------------------------------------------------------
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform mat4 transform;
+
+
+//---------------------------------------------------------------
+// [SECTION] Vertex decoding
+//---------------------------------------------------------------
+
+#ifdef XE_QUANTIZED_VERTICES
+vec3 decodePosition() {
+	return positionOffset + positionScale * in_position;
+}
+#else
+vec3 decodePosition() {
+	return in_position;
+}
+#endif
+
+
+//---------------------------------------------------------------
+// [SECTION] Main program
+//---------------------------------------------------------------
+
+void main() {
+	// Same operations in the same order as pbr.vert
+	vec4 fragPos = transform * vec4(decodePosition(), 1.0);
+
+#ifdef XE_ALPHA_CUTOUT
+	textureCoord = in_textureCoord;
+#endif
+
+	gl_Position = projection * view * fragPos;
+}
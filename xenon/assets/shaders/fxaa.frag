@@ -0,0 +1,73 @@
+#version 460 core
+
+//---------------------------------------------------------------
+// [SECTION] Input data & output variables
+//---------------------------------------------------------------
+
+in vec2 textureCoord;
+
+layout(location = 0) out vec4 fragColor;
+
+layout(binding = 0) uniform sampler2D sourceTexture;
+
+uniform vec2 regionSize;	// Rendered region of sourceTexture in pixels
+
+
+//---------------------------------------------------------------
+// [SECTION] Constants
+//---------------------------------------------------------------
+
+const float REDUCE_MIN = 1.0 / 128.0;
+const float REDUCE_MUL = 1.0 / 8.0;
+const float SPAN_MAX = 8.0;
+
+
+//---------------------------------------------------------------
+// [SECTION] Helpers
+//---------------------------------------------------------------
+
+vec2 texelSize;
+vec2 maxUV;
+
+vec3 fetch(vec2 uv) {
+	// Stay inside the rendered region
+	return texture(sourceTexture, clamp(uv, 0.5 * texelSize, maxUV)).rgb;
+}
+
+float luma(vec3 color) {
+	return dot(color, vec3(0.299, 0.587, 0.114));
+}
+
+
+//---------------------------------------------------------------
+// [SECTION] Main program
+//---------------------------------------------------------------
+
+void main() {
+	texelSize = 1.0 / vec2(textureSize(sourceTexture, 0));
+	maxUV = (regionSize - 0.5) * texelSize;
+	vec2 uv = gl_FragCoord.xy * texelSize;
+
+	vec3 rgbM = fetch(uv);
+	float lumaM = luma(rgbM);
+	float lumaNW = luma(fetch(uv + vec2(-1.0, -1.0) * texelSize));
+	float lumaNE = luma(fetch(uv + vec2( 1.0, -1.0) * texelSize));
+	float lumaSW = luma(fetch(uv + vec2(-1.0,  1.0) * texelSize));
+	float lumaSE = luma(fetch(uv + vec2( 1.0,  1.0) * texelSize));
+
+	float lumaMin = min(lumaM, min(min(lumaNW, lumaNE), min(lumaSW, lumaSE)));
+	float lumaMax = max(lumaM, max(max(lumaNW, lumaNE), max(lumaSW, lumaSE)));
+
+	// Blur along the edge, perpendicular to the luma gradient
+	vec2 direction = vec2(-((lumaNW + lumaNE) - (lumaSW + lumaSE)), (lumaNW + lumaSW) - (lumaNE + lumaSE));
+	float directionReduce = max((lumaNW + lumaNE + lumaSW + lumaSE) * 0.25 * REDUCE_MUL, REDUCE_MIN);
+	float inverseDirectionMin = 1.0 / (min(abs(direction.x), abs(direction.y)) + directionReduce);
+	direction = clamp(direction * inverseDirectionMin, -SPAN_MAX, SPAN_MAX) * texelSize;
+
+	vec3 rgbA = 0.5 * (fetch(uv + direction * (1.0 / 3.0 - 0.5)) + fetch(uv + direction * (2.0 / 3.0 - 0.5)));
+	vec3 rgbB = rgbA * 0.5 + 0.25 * (fetch(uv - direction * 0.5) + fetch(uv + direction * 0.5));
+
+	// The wider filter crossed another edge, fall back to the narrow one
+	float lumaB = luma(rgbB);
+	fragColor = vec4((lumaB < lumaMin || lumaB > lumaMax) ? rgbA : rgbB, 1.0);
+}
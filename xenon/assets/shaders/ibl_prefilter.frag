@@ -0,0 +1,94 @@
+#version 460 core
+
+in vec3 position;
+
+out vec4 fragColor;
+
+layout(binding = 0) uniform samplerCube iblSourceTexture;
+
+uniform float roughness;
+uniform float sourceResolution;	// Face size of mip 0 of the source
+uniform int sampleCount;
+
+const float PI = 3.14159265359;
+
+
+//---------------------------------------------------------------
+// [SECTION] Low discrepancy sequence
+//---------------------------------------------------------------
+
+float radicalInverse(uint bits) {
+	bits = (bits << 16u) | (bits >> 16u);
+	bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+	bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+	bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+	bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+	return float(bits) * 2.3283064365386963e-10;
+}
+
+vec2 hammersley(uint i, uint count) {
+	return vec2(float(i) / float(count), radicalInverse(i));
+}
+
+
+//---------------------------------------------------------------
+// [SECTION] GGX importance sampling
+//---------------------------------------------------------------
+
+vec3 importanceSampleGGX(vec2 Xi, vec3 N, float a) {
+	float phi = 2.0 * PI * Xi.x;
+	float cosTheta = sqrt((1.0 - Xi.y) / (1.0 + (a * a - 1.0) * Xi.y));
+	float sinTheta = sqrt(1.0 - cosTheta * cosTheta);
+	vec3 H = vec3(cos(phi) * sinTheta, sin(phi) * sinTheta, cosTheta);
+
+	vec3 up = abs(N.z) < 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(1.0, 0.0, 0.0);
+	vec3 tangent = normalize(cross(up, N));
+	vec3 bitangent = cross(N, tangent);
+	return normalize(tangent * H.x + bitangent * H.y + N * H.z);
+}
+
+float distributionGGX(float NdotH, float a) {
+	float a2 = a * a;
+	float denom = NdotH * NdotH * (a2 - 1.0) + 1.0;
+	return a2 / (PI * denom * denom);
+}
+
+
+//---------------------------------------------------------------
+// [SECTION] Main program
+//---------------------------------------------------------------
+
+// Split sum prefiltering with N = V = R (Karis, "Real Shading in Unreal Engine 4"). Samples read a source mip
+// matching their solid angle (filtered importance sampling) so few samples are needed without fireflies.
+void main() {
+	vec3 N = normalize(position);
+	float a = roughness * roughness;
+
+	if (roughness == 0.0) {
+		fragColor = vec4(textureLod(iblSourceTexture, N, 0.0).rgb, 1.0);
+		return;
+	}
+
+	float texelSolidAngle = 4.0 * PI / (6.0 * sourceResolution * sourceResolution);
+
+	vec3 color = vec3(0.0);
+	float totalWeight = 0.0;
+	uint count = uint(sampleCount);
+	for (uint i = 0u; i < count; ++i) {
+		vec3 H = importanceSampleGGX(hammersley(i, count), N, a);
+		vec3 L = normalize(2.0 * dot(N, H) * H - N);
+		float NdotL = dot(N, L);
+		if (NdotL > 0.0) {
+			float NdotH = max(dot(N, H), 0.0);
+			// pdf of L is D * NdotH / (4 * HdotV), with N = V the terms cancel to D / 4
+			float pdf = distributionGGX(NdotH, a) * 0.25;
+			float sampleSolidAngle = 1.0 / (float(count) * pdf + 0.0001);
+			float lod = 0.5 * log2(sampleSolidAngle / texelSolidAngle) + 1.0;
+
+			color += textureLod(iblSourceTexture, L, max(lod, 0.0)).rgb * NdotL;
+			totalWeight += NdotL;
+		}
+	}
+
+	fragColor = vec4(color / max(totalWeight, 0.0001), 1.0);
+}
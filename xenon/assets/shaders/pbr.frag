@@ -58,7 +58,6 @@ uniform bool usingAttribWeights0;  // TODO: implement
 // [SECTION] Environment
 //---------------------------------------------------------------
 
-layout(binding = 5) uniform samplerCube irradianceMap;
 layout(binding = 6) uniform samplerCube radianceMap;
 layout(binding = 7) uniform sampler2D brdfLUT;
 
@@ -89,13 +88,36 @@ uniform int objectID;
 #define MAX_POINT_LIGHTS 4
 #define EPSILON 0.0000001
 
+// NOTE: std140 layout, must match LightingBlock in renderer.h
 struct PointLight {
-	vec3 position;
-	vec3 color;
+	vec4 position;	// xyz = position
+	vec4 color;		// rgb = color
+};
+
+layout(std140, binding = 0) uniform LightingBlock {
+	PointLight pointLights[MAX_POINT_LIGHTS];
+	vec4 irradianceSH[9];	// rgb = L2 coefficient, convolved with the cosine lobe and divided by PI
+	int pointLightsUsed;
 };
 
-uniform PointLight pointLights[MAX_POINT_LIGHTS];
-uniform int pointLightsUsed;
+
+//---------------------------------------------------------------
+// [SECTION] Spherical harmonics irradiance
+//---------------------------------------------------------------
+
+vec3 evaluateIrradianceSH(vec3 n) {
+	vec3 irradiance = irradianceSH[0].rgb * 0.282095
+		+ irradianceSH[1].rgb * 0.488603 * n.y
+		+ irradianceSH[2].rgb * 0.488603 * n.z
+		+ irradianceSH[3].rgb * 0.488603 * n.x
+		+ irradianceSH[4].rgb * 1.092548 * n.x * n.y
+		+ irradianceSH[5].rgb * 1.092548 * n.y * n.z
+		+ irradianceSH[6].rgb * 0.315392 * (3.0 * n.z * n.z - 1.0)
+		+ irradianceSH[7].rgb * 1.092548 * n.x * n.z
+		+ irradianceSH[8].rgb * 0.546274 * (n.x * n.x - n.y * n.y);
+	// Ringing of the truncated expansion can go negative opposite of bright lights
+	return max(irradiance, vec3(0.0));
+}
 
 
 //---------------------------------------------------------------
@@ -153,7 +175,10 @@ vec3 getNormal() {
 	vec3 normalMapNormal = normal;
 
 	if(usingNormalMap) {
-		vec3 tangentNormal = texture(normalMap, textureCoord).rgb * 2.0 - 1.0;
+		// Z is reconstructed, block compressed normal maps only store X and Y (BC5)
+		vec3 tangentNormal;
+		tangentNormal.xy = texture(normalMap, textureCoord).rg * 2.0 - 1.0;
+		tangentNormal.z = sqrt(max(1.0 - dot(tangentNormal.xy, tangentNormal.xy), 0.0));
 		
 		if(!usingAttribTangent) {
 			// TODO: Deprecate
@@ -191,7 +216,8 @@ void main() {
 		albedo = albedo * texture(albedoMap, textureCoord);
 	}
 
-	if(albedo.a < alphaCutoff) {
+	// Opaque materials ignore alpha (glTF), the depth prepass relies on this
+	if(alphaMode != 0 && albedo.a < alphaCutoff) {
 		discard;
 	}
 
@@ -223,11 +249,11 @@ void main() {
 		PointLight light = pointLights[i];
 		
 		// calculate per-light radiance
-		vec3 L = normalize(light.position - position.xyz);
+		vec3 L = normalize(light.position.xyz - position.xyz);
 		vec3 H = normalize(V + L);
-		float dist = length(light.position - position.xyz);
+		float dist = length(light.position.xyz - position.xyz);
 		float attenuation = 1.0 / (dist * dist);
-		vec3 radiance = light.color * attenuation;
+		vec3 radiance = light.color.rgb * attenuation;
 
 		// Cook-Torrance BRDF
 		float NdotL = max(dot(N, L), EPSILON);
@@ -260,7 +286,7 @@ void main() {
 	vec3 F = fresnelSchlickRoughness(NdotV, baseReflectivity, roughness);
 	vec3 kD = (1.0 - F) * (1.0 - metallic);
 
-	vec3 irradiance = texture(irradianceMap, N).rgb;
+	vec3 irradiance = evaluateIrradianceSH(N);
 	vec3 diffuse = irradiance * albedo.rgb;
 
 
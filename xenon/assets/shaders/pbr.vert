@@ -4,10 +4,21 @@
 // [SECTION] Input data & output variables
 //---------------------------------------------------------------
 
+#ifdef XE_QUANTIZED_VERTICES
+// VertexFormat::QUANTIZED
+layout(location = 0) in vec3 in_position;		// unorm16, dequantized with positionOffset and positionScale
+layout(location = 1) in ivec2 in_tangent;		// Octahedral, handedness in the lowest bit of y
+layout(location = 2) in vec2 in_normal;			// Octahedral snorm16
+layout(location = 3) in vec2 in_textureCoord;	// Half float
+
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+#else
 layout(location = 0) in vec3 in_position;
 layout(location = 1) in vec4 in_tangent;
 layout(location = 2) in vec3 in_normal;
 layout(location = 3) in vec2 in_textureCoord;
+#endif
 
 out vec4 position;
 out vec3 tangent;
@@ -16,6 +27,9 @@ out vec2 textureCoord;
 
 out mat3 TBN;
 
+// NOTE: Must produce bit identical depth to depth.vert, used by the depth prepass
+invariant gl_Position;
+
 
 //---------------------------------------------------------------
 // [SECTION] Matricies
@@ -24,6 +38,46 @@ out mat3 TBN;
 uniform mat4 projection;
 uniform mat4 view;
 uniform mat4 transform;
+uniform mat3 normalMatrix;	// Inverse transpose of the upper 3x3 of transform, computed on the CPU
+
+
+//---------------------------------------------------------------
+// [SECTION] Vertex decoding
+//---------------------------------------------------------------
+
+#ifdef XE_QUANTIZED_VERTICES
+vec3 decodeOctahedral(vec2 e) {
+	vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-v.z, 0.0);
+	v.xy += vec2(v.x >= 0.0 ? -t : t, v.y >= 0.0 ? -t : t);
+	return normalize(v);
+}
+
+vec3 decodePosition() {
+	return positionOffset + positionScale * in_position;
+}
+
+vec3 decodeNormal() {
+	return decodeOctahedral(in_normal);
+}
+
+vec4 decodeTangent() {
+	vec2 e = vec2(max(float(in_tangent.x) / 32767.0, -1.0), float(in_tangent.y >> 1) / 16383.0);
+	return vec4(decodeOctahedral(e), (in_tangent.y & 1) != 0 ? -1.0 : 1.0);
+}
+#else
+vec3 decodePosition() {
+	return in_position;
+}
+
+vec3 decodeNormal() {
+	return in_normal;
+}
+
+vec4 decodeTangent() {
+	return in_tangent;
+}
+#endif
 
 
 //---------------------------------------------------------------
@@ -31,22 +85,22 @@ uniform mat4 transform;
 //---------------------------------------------------------------
 
 void main() {
-	// Apply transformation on normal
-	mat3 vectorTransform =  mat3(transpose(inverse(transform)));
+	vec4 vertexTangent = decodeTangent();
 
-	normal = normalize(vectorTransform * in_normal);
+	// Apply transformation on normal
+	normal = normalize(normalMatrix * decodeNormal());
 	// Calculate fragment position
-	vec4 fragPos = transform * vec4(in_position, 1.0);
+	vec4 fragPos = transform * vec4(decodePosition(), 1.0);
 	
 	// Pass values to fragment shader
 	position = fragPos;
 	textureCoord = in_textureCoord;
 
 	// Calculate Tangent to object space matrix
-	vec3 T = normalize(vectorTransform * in_tangent.xyz);
+	vec3 T = normalize(normalMatrix * vertexTangent.xyz);
 	vec3 N = normal;
 	T = normalize(T - dot(T, N) * N); // re-orthogonalize T with respect to N
-	vec3 B = normalize(cross(N, T) * in_tangent.w);
+	vec3 B = normalize(cross(N, T) * vertexTangent.w);
 	TBN = mat3(T, B, N);
 
 	tangent = T;
@@ -0,0 +1,40 @@
+#version 460 core
+
+//---------------------------------------------------------------
+// [SECTION] Input data & output variables
+//---------------------------------------------------------------
+
+in vec2 textureCoord;
+
+layout(location = 0) out vec4 fragColor;
+
+layout(binding = 0) uniform sampler2D sourceTexture;
+
+uniform vec2 sourceScale;		// Rendered region / texture size
+uniform vec2 sourceTexelSize;
+uniform float sharpness;		// [0, 1]
+
+
+//---------------------------------------------------------------
+// [SECTION] Main program
+//---------------------------------------------------------------
+
+void main() {
+	// Keep the bilinear footprint inside the rendered region
+	vec2 uv = min(textureCoord * sourceScale, sourceScale - 0.5 * sourceTexelSize);
+
+	vec3 center = texture(sourceTexture, uv).rgb;
+	vec3 north = texture(sourceTexture, uv + vec2(0.0, sourceTexelSize.y)).rgb;
+	vec3 south = texture(sourceTexture, uv - vec2(0.0, sourceTexelSize.y)).rgb;
+	vec3 east = texture(sourceTexture, uv + vec2(sourceTexelSize.x, 0.0)).rgb;
+	vec3 west = texture(sourceTexture, uv - vec2(sourceTexelSize.x, 0.0)).rgb;
+
+	// Contrast adaptive: sharpen less where the neighborhood already has a high contrast
+	vec3 minColor = min(center, min(min(north, south), min(east, west)));
+	vec3 maxColor = max(center, max(max(north, south), max(east, west)));
+	vec3 amount = sqrt(clamp(min(minColor, 1.0 - maxColor) / max(maxColor, 1e-4), 0.0, 1.0));
+	vec3 weight = -amount * mix(0.125, 0.2, sharpness);
+
+	vec3 color = (center + (north + south + east + west) * weight) / (1.0 + 4.0 * weight);
+	fragColor = vec4(clamp(color, 0.0, 1.0), 1.0);
+}
@@ -0,0 +1,62 @@
+#version 460 core
+
+//---------------------------------------------------------------
+// [SECTION] Input data & output variables
+//---------------------------------------------------------------
+
+in vec2 textureCoord;
+
+layout(location = 0) out vec4 fragColor;
+
+layout(binding = 0) uniform sampler2D currentTexture;
+layout(binding = 1) uniform sampler2D depthTexture;
+layout(binding = 2) uniform sampler2D historyTexture;
+
+uniform mat4 reprojection;		// Current NDC to previous clip space
+uniform vec2 regionSize;		// Rendered region in pixels, same for the current frame and the history
+uniform bool historyValid;
+uniform float historyWeight;
+
+
+//---------------------------------------------------------------
+// [SECTION] Main program
+//---------------------------------------------------------------
+
+void main() {
+	ivec2 texel = ivec2(gl_FragCoord.xy);
+	ivec2 maxTexel = ivec2(regionSize) - 1;
+	vec3 current = texelFetch(currentTexture, texel, 0).rgb;
+
+	// Neighborhood of the current frame, the history is clamped to it to reject stale data
+	vec3 minColor = current;
+	vec3 maxColor = current;
+	for (int y = -1; y <= 1; ++y) {
+		for (int x = -1; x <= 1; ++x) {
+			vec3 color = texelFetch(currentTexture, clamp(texel + ivec2(x, y), ivec2(0), maxTexel), 0).rgb;
+			minColor = min(minColor, color);
+			maxColor = max(maxColor, color);
+		}
+	}
+
+	if (!historyValid) {
+		fragColor = vec4(current, 1.0);
+		return;
+	}
+
+	// Reproject with the depth of this frame, only camera movement is accounted for
+	float depth = texelFetch(depthTexture, texel, 0).r;
+	vec2 uv = (vec2(texel) + 0.5) / regionSize;
+	vec4 previous = reprojection * vec4(uv * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+	vec2 historyUV = (previous.xy / previous.w) * 0.5 + 0.5;
+
+	if (any(lessThan(historyUV, vec2(0.0))) || any(greaterThan(historyUV, vec2(1.0)))) {
+		fragColor = vec4(current, 1.0);
+		return;
+	}
+
+	vec2 historySize = vec2(textureSize(historyTexture, 0));
+	vec3 history = texture(historyTexture, historyUV * regionSize / historySize).rgb;
+	history = clamp(history, minColor, maxColor);
+
+	fragColor = vec4(mix(current, history, historyWeight), 1.0);
+}
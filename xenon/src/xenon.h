@@ -3,10 +3,22 @@
 #include "xenon/core/application.h"
 #include "xenon/core/input.h"
 #include "xenon/core/asset_manager.h"
+#include "xenon/core/frame_allocator.h"
+#include "xenon/core/profiler.h"
+#include "xenon/core/job_system.h"
 #include "xenon/graphics/renderer.h"
+#include "xenon/graphics/gl_state.h"
 #include "xenon/graphics/model_loader.h"
 #include "xenon/graphics/framebuffer.h"
+#include "xenon/graphics/dynamic_resolution.h"
+#include "xenon/graphics/anti_aliasing.h"
+#include "xenon/graphics/frame_graph.h"
 #include "xenon/graphics/primitives.h"
 #include "xenon/graphics/brdf.h"
+#include "xenon/graphics/mipmap.h"
+#include "xenon/graphics/texture_compression.h"
+#include "xenon/graphics/texture_streaming.h"
+#include "xenon/graphics/spherical_harmonics.h"
+#include "xenon/graphics/ibl_baker.h"
 #include "xenon/scene/scene.h"
 #include "xenon/scripting/script.h"
@@ -2,21 +2,58 @@
 
 #include "xenon/core/debug.h"
 #include "xenon/core/input.h"
+#include "xenon/core/frame_allocator.h"
+#include "xenon/core/profiler.h"
+#include "xenon/graphics/gl_state.h"
 
 namespace xe {
 
 	static int s_applicationCount = 0;
 
-	Application* createApplication(const std::string& title, int width, int height) {
+	GLFWwindow* createHeadlessWindow(const std::string& title, int width, int height) {
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+		// Surfaceless EGL on a GPU if there is one, software OSMesa otherwise
+		for (int contextAPI : { GLFW_EGL_CONTEXT_API, GLFW_OSMESA_CONTEXT_API }) {
+			glfwWindowHint(GLFW_CONTEXT_CREATION_API, contextAPI);
+			GLFWwindow* window = glfwCreateWindow(width, height, title.c_str(), NULL, NULL);
+			if (window) {
+				XE_LOG_INFO_F("Created headless context using {}", contextAPI == GLFW_EGL_CONTEXT_API ? "EGL" : "OSMesa");
+				return window;
+			}
+		}
+		return nullptr;
+	}
+
+	Application* createApplicationInternal(const std::string& title, int width, int height, bool headless) {
 		if (s_applicationCount == 0) {
+#ifdef GLFW_PLATFORM_NULL
+			// Null platform needs no display server, only available since GLFW 3.4
+			glfwInitHint(GLFW_PLATFORM, headless ? GLFW_PLATFORM_NULL : GLFW_ANY_PLATFORM);
+#else
+			if (headless) {
+				XE_LOG_ERROR("Headless applications need the GLFW null platform (GLFW 3.4), using the display platform instead which fails without a display");
+			}
+#endif
 			if (!glfwInit()) {
 				XE_LOG_CRITICAL("Failed to initialize GLFW");
 				return nullptr;
 			}
 		}
 
+		glfwDefaultWindowHints();
 		glfwWindowHint(GLFW_CONTEXT_DEBUG, GLFW_TRUE);
-		GLFWwindow* window = glfwCreateWindow(width, height, title.c_str(), NULL, NULL);
+		GLFWwindow* window = headless ? createHeadlessWindow(title, width, height) : glfwCreateWindow(width, height, title.c_str(), NULL, NULL);
+		if (!window) {
+			XE_LOG_CRITICAL(headless ? "Failed to create headless OpenGL context" : "Failed to create window");
+			if (s_applicationCount == 0) {
+				glfwTerminate();
+			}
+			return nullptr;
+		}
 		glfwMakeContextCurrent(window);
 
 		int version = gladLoadGL(glfwGetProcAddress);
@@ -24,24 +61,32 @@ namespace xe {
 			XE_LOG_CRITICAL("Failed to initialize OpenGL context");
 			return nullptr;
 		}
+		XE_LOG_INFO_F("OpenGL {}.{} on {}", GLAD_VERSION_MAJOR(version), GLAD_VERSION_MINOR(version), (const char*)glGetString(GL_RENDERER));
 
 		// Enable debug
 		installDebugCallback(window);
 
 		// Enable default OpenGL features
-		glEnable(GL_DEPTH_TEST);
-		glEnable(GL_CULL_FACE);
-		glEnable(GL_BLEND);
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-		glDepthFunc(GL_LEQUAL);
+		invalidateGLState();
+		setGLCapability(GL_DEPTH_TEST, true);
+		setGLCapability(GL_CULL_FACE, true);
+		setGLCapability(GL_BLEND, true);
+		setGLBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		setGLDepthFunc(GL_LEQUAL);
 
 		glViewport(0, 0, width, height);
 
-		Application* application = new Application{ window, title, width, height, true };
+		Application* application = new Application{ window, title, width, height, headless, true };
 		glfwSetWindowUserPointer(window, application);
+		++s_applicationCount;
 
-		// Input
-		Input::initializeApplicationInput(application);
+		// Input, headless applications have none
+		if (!headless) {
+			Input::initializeApplicationInput(application);
+		}
+
+		// The thread owning the context records the frames
+		setProfilerThreadName("Main");
 
 		// Install size callbacks
 		glfwSetFramebufferSizeCallback(window, [](GLFWwindow* window, int width, int height) {
@@ -54,12 +99,22 @@ namespace xe {
 		return application;
 	}
 
+	Application* createApplication(const std::string& title, int width, int height) {
+		return createApplicationInternal(title, width, height, false);
+	}
+
+	Application* createHeadlessApplication(const std::string& title, int width, int height) {
+		return createApplicationInternal(title, width, height, true);
+	}
+
 	void destroyApplication(Application* application) {
 		glfwDestroyWindow(application->window);
 		delete application;
 
 		--s_applicationCount;
 		if (s_applicationCount == 0) {
+			// The arena is shared by all applications, only the last one may release it
+			releaseFrameMemory();
 			glfwTerminate();
 		}
 	}
@@ -71,17 +126,30 @@ namespace xe {
 
 
 	Timestep updateApplication(Application* application) {
+		// Closes the previous frame before anything of this one is recorded
+		XE_PROFILE_FRAME();
+		XE_PROFILE_FUNCTION();
+
 		// Pre-input flag
 		if (application->viewportSizeChanged) {
 			// flag should only be set for one frame
 			application->viewportSizeChanged = false;
 		}
+		// Per frame GL state counters and transient memory
+		resetGLStateCounters();
+		resetFrameMemory();
+
 		// Input
 		glfwPollEvents();
-		Input::updateInput(application);
+		if (!application->headless) {
+			Input::updateInput(application);
+		}
 
 		// Rendering TODO: Move to rendering preparation
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		// Headless contexts have no default framebuffer to clear
+		if (!application->headless) {
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		}
 
 		// Time
 		float currentTime = glfwGetTime();
@@ -92,11 +160,19 @@ namespace xe {
 	}
 
 	void swapBuffers(Application* application) {
+		if (application->headless) {
+			// Nothing is presented, flush so timings and readbacks see the work of the frame
+			glFlush();
+			return;
+		}
 		glfwSwapBuffers(application->window);
 	}
 
 
 	void maximizeApplication(Application* application) {
+		if (application->headless) {
+			return;
+		}
 		glfwMaximizeWindow(application->window);
 	}
 
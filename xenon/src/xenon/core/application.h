@@ -16,6 +16,8 @@ namespace xe {
 		GLFWwindow* window;
 		std::string title;
 		int width, height;
+		// Offscreen context without a visible window, render into framebuffers
+		bool headless;
 
 		// Runtime
 		bool running;
@@ -26,6 +28,12 @@ namespace xe {
 
 	// State management
 	Application* createApplication(const std::string& title, int width, int height);
+	/*
+		Creates an offscreen GL 4.6 context without a window or input, for batch rendering and automated runs on
+		machines without a display. Uses the GLFW null platform with a surfaceless EGL context and falls back to
+		OSMesa (llvmpipe). There is no default framebuffer, width and height only size the viewport.
+	*/
+	Application* createHeadlessApplication(const std::string& title, int width, int height);
 	void destroyApplication(Application* application);
 	
 	// State feedback
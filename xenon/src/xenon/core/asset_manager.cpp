@@ -2,6 +2,7 @@
 
 #include <filesystem>
 
+#include "xenon/core/profiler.h"
 #include "xenon/graphics/texture.h"
 #include "xenon/graphics/model.h"
 
@@ -10,6 +11,7 @@ namespace xe {
 	static AssetManager* s_assetManager = nullptr;
 
 	AssetManager* createAssetManager(const std::string& projectFolder) {
+		XE_PROFILE_FUNCTION();
 		AssetManager* manager = new AssetManager();
 		manager->projectFolder = projectFolder;
 
@@ -39,6 +41,7 @@ namespace xe {
 	}
 
 	bool loadAssetData(AssetManager* manager, Asset** asset) {
+		XE_PROFILE_FUNCTION();
 		if ((*asset)->metadata.type == AssetType::Directory) {
 			return false;
 		}
@@ -100,6 +103,7 @@ namespace xe {
 	}
 
 	void importAsset(AssetManager* manager, const std::string& path, UUID parent) {
+		XE_PROFILE_FUNCTION();
 		AssetType type = getAssetTypeFromPath(path);
 		Asset* asset = createAsset(manager, path, type, parent);
 
@@ -118,6 +122,7 @@ namespace xe {
 	}
 
 	UUID updateDirectoryAssets(AssetManager* manager, const std::string& path, UUID parent) {
+		XE_PROFILE_FUNCTION();
 		Directory* directory = static_cast<Directory*>(createAsset(manager, path, AssetType::Directory, parent));
 		directory->runtimeData.loaded = true;
 
@@ -162,6 +167,7 @@ namespace xe {
 	};
 
 	void updateAssetRegistry(AssetManager* manager) {
+		XE_PROFILE_FUNCTION();
 		manager->sortedAssets.clear();
 		for (auto& [id, asset] : manager->assets) {
 			manager->sortedAssets.push_back(std::make_pair(id, asset));
@@ -11,6 +11,10 @@ namespace xe {
 			// XE_LOG_TRACE_F("Trace message ({}): {}", id, message);
 			return;
 		}
+		// Debug groups of XE_GPU_SCOPE
+		if (type == GL_DEBUG_TYPE_PUSH_GROUP || type == GL_DEBUG_TYPE_POP_GROUP) {
+			return;
+		}
 
 		XE_LOG_DEBUG("---------------");
 		XE_LOG_DEBUG_F("Debug message ({}): {}", id, message);
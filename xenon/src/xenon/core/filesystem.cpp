@@ -22,5 +22,18 @@ namespace xe {
 		return true;
 	}
 
+	bool saveTextResource(const std::string& path, const std::string& text) {
+		XE_LOG_TRACE_F("FILESYSTEM: Saving file: {}", path);
+		std::ofstream fileStream(path, std::ios::out | std::ios::trunc);
+
+		if (!fileStream.is_open()) {
+			XE_LOG_ERROR_F("FILESYSTEM: Failed to open file: {}", path);
+			return false;
+		}
+
+		fileStream << text;
+		return fileStream.good();
+	}
+
 }
 
@@ -5,5 +5,7 @@
 namespace xe {
 
 	bool loadTextResource(const std::string& path, std::string& target);
+	// Overwrites the file
+	bool saveTextResource(const std::string& path, const std::string& text);
 
 }
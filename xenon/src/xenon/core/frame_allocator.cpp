@@ -0,0 +1,88 @@
+#include "frame_allocator.h"
+
+#include <cstdint>
+#include <cstdlib>
+
+#include "xenon/core/assert.h"
+#include "xenon/core/log.h"
+
+namespace xe {
+
+	struct FrameArena {
+		uint8_t* memory = nullptr;
+		size_t offset = 0;
+		std::vector<void*> overflowBlocks;
+		FrameMemoryStats stats;
+	};
+
+	static FrameArena s_frameArena;
+
+	//----------------------------------------
+	// SECTION: Frame memory
+	//----------------------------------------
+
+	void* allocateFrameMemory(size_t size, size_t alignment) {
+		XE_ASSERT(alignment != 0 && (alignment & (alignment - 1)) == 0);
+
+		if (!s_frameArena.memory) {
+			s_frameArena.memory = static_cast<uint8_t*>(std::malloc(XE_FRAME_MEMORY_SIZE));
+			s_frameArena.stats.capacity = XE_FRAME_MEMORY_SIZE;
+		}
+
+		uintptr_t base = reinterpret_cast<uintptr_t>(s_frameArena.memory);
+		uintptr_t aligned = (base + s_frameArena.offset + alignment - 1) & ~(uintptr_t)(alignment - 1);
+		size_t end = (size_t)(aligned - base) + size;
+
+		if (end <= s_frameArena.stats.capacity) {
+			s_frameArena.offset = end;
+			s_frameArena.stats.used = end;
+			return reinterpret_cast<void*>(aligned);
+		}
+
+		// Arena is full, fall back to the heap until the next reset
+		if (s_frameArena.stats.overflowBytes == 0) {
+			XE_LOG_WARN_F("FRAME_MEMORY: Frame arena exhausted ({} bytes), falling back to heap allocations", s_frameArena.stats.capacity);
+		}
+		s_frameArena.stats.overflowBytes += size;
+
+		// NOTE: malloc is aligned for any fundamental type, over-aligned types are not supported in overflow
+		XE_ASSERT(alignment <= alignof(std::max_align_t));
+		void* block = std::malloc(size);
+		s_frameArena.overflowBlocks.push_back(block);
+		return block;
+	}
+
+	void resetFrameMemory() {
+		FrameMemoryStats& stats = s_frameArena.stats;
+
+		#ifdef XE_DEBUG_FRAME_MEMORY
+		XE_LOG_DEBUG_F("FRAME_MEMORY: Frame used {} / {} bytes (peak {}, overflow {})", stats.used, stats.capacity, stats.peakUsed, stats.overflowBytes);
+		#endif
+
+		for (void* block : s_frameArena.overflowBlocks) {
+			std::free(block);
+		}
+		s_frameArena.overflowBlocks.clear();
+
+		size_t frameUsed = stats.used + stats.overflowBytes;
+		stats.lastFrameUsed = frameUsed;
+		if (frameUsed > stats.peakUsed) {
+			stats.peakUsed = frameUsed;
+		}
+		stats.used = 0;
+		stats.overflowBytes = 0;
+		s_frameArena.offset = 0;
+	}
+
+	void releaseFrameMemory() {
+		resetFrameMemory();
+		std::free(s_frameArena.memory);
+		s_frameArena.memory = nullptr;
+		s_frameArena.stats = FrameMemoryStats();
+	}
+
+	const FrameMemoryStats& getFrameMemoryStats() {
+		return s_frameArena.stats;
+	}
+
+}
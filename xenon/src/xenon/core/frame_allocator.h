@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace xe {
+
+	// Size of the per-frame linear arena, allocations past this fall back to the heap
+	#ifndef XE_FRAME_MEMORY_SIZE
+	#define XE_FRAME_MEMORY_SIZE (4 * 1024 * 1024)
+	#endif
+
+	// Define XE_DEBUG_FRAME_MEMORY to log the arena usage of every frame
+
+	//----------------------------------------
+	// SECTION: Frame memory
+	//----------------------------------------
+
+	struct FrameMemoryStats {
+		size_t capacity = 0;
+		size_t used = 0;			// Bytes used by the current frame
+		size_t lastFrameUsed = 0;	// Bytes used by the previous frame
+		size_t peakUsed = 0;		// Highest usage of any frame
+		size_t overflowBytes = 0;	// Bytes that did not fit in the arena in the current frame
+	};
+
+	// NOTE: Memory returned by allocateFrameMemory is only valid until the next resetFrameMemory call.
+	// The arena is not thread safe and should only be used from the main thread.
+	void* allocateFrameMemory(size_t size, size_t alignment = alignof(std::max_align_t));
+	void resetFrameMemory();
+	void releaseFrameMemory();
+
+	const FrameMemoryStats& getFrameMemoryStats();
+
+
+	//----------------------------------------
+	// SECTION: STL adapters
+	//----------------------------------------
+
+	template<typename T>
+	struct FrameAllocator {
+		using value_type = T;
+
+		FrameAllocator() noexcept = default;
+		template<typename U>
+		FrameAllocator(const FrameAllocator<U>&) noexcept {}
+
+		T* allocate(size_t count) {
+			return static_cast<T*>(allocateFrameMemory(count * sizeof(T), alignof(T)));
+		}
+
+		// Frame memory is released all at once by resetFrameMemory
+		void deallocate(T*, size_t) noexcept {}
+
+		template<typename U>
+		bool operator==(const FrameAllocator<U>&) const noexcept { return true; }
+		template<typename U>
+		bool operator!=(const FrameAllocator<U>&) const noexcept { return false; }
+	};
+
+	template<typename T>
+	using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+	template<typename K, typename V, typename Compare = std::less<K>>
+	using FrameMap = std::map<K, V, Compare, FrameAllocator<std::pair<const K, V>>>;
+
+	using FrameString = std::basic_string<char, std::char_traits<char>, FrameAllocator<char>>;
+
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace xe {
+
+	// FNV-1a 64 bit offset basis and prime
+	#define XE_HASH_SEED 14695981039346656037ull
+	#define XE_HASH_PRIME 1099511628211ull
+
+	//----------------------------------------
+	// SECTION: Hash
+	//----------------------------------------
+
+	/*
+		FNV-1a for content keys of derived data caches (baked environments, mip chains). Not cryptographic, the
+		settings a cache depends on are mixed into the key with hashValue so changing them invalidates it.
+	*/
+
+	inline uint64_t hashValue(uint64_t hash, uint64_t value) {
+		hash ^= value;
+		return hash * XE_HASH_PRIME;
+	}
+
+	// Mixes eight bytes per step, hashing a texture is dominated by memory bandwidth instead of the multiply chain
+	inline uint64_t hashBytes(const void* data, size_t size, uint64_t hash = XE_HASH_SEED) {
+		const uint8_t* bytes = (const uint8_t*)data;
+		size_t i = 0;
+		for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+			uint64_t word;
+			std::memcpy(&word, bytes + i, sizeof(uint64_t));
+			hash = hashValue(hash, word);
+		}
+		for (; i < size; ++i) {
+			hash = hashValue(hash, bytes[i]);
+		}
+		return hashValue(hash, size);
+	}
+
+}
@@ -0,0 +1,148 @@
+#include "job_system.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "xenon/core/profiler.h"
+
+namespace xe {
+
+	struct JobSystem {
+		std::vector<std::thread> workers;
+		std::deque<std::function<void()>> queue;
+		std::mutex mutex;
+		std::condition_variable condition;
+		bool stopping = false;
+
+		~JobSystem() {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopping = true;
+			}
+			condition.notify_all();
+			for (std::thread& worker : workers) {
+				worker.join();
+			}
+		}
+	};
+
+	// Progress of one parallelFor call, shared with the helper jobs that may outlive the batches
+	struct ParallelForState {
+		const std::function<void(uint32_t, uint32_t)>* function = nullptr;
+		uint32_t count = 0;
+		uint32_t batchSize = 0;
+		uint32_t batches = 0;
+		std::atomic<uint32_t> nextBatch{ 0 };
+		std::atomic<uint32_t> finishedBatches{ 0 };
+		std::mutex mutex;
+		std::condition_variable finished;
+	};
+
+	//----------------------------------------
+	// SECTION: Job system
+	//----------------------------------------
+
+	void runJobWorker(JobSystem* system, uint32_t index) {
+		std::string name = "Worker " + std::to_string(index);
+		setProfilerThreadName(name.c_str());
+
+		while (true) {
+			std::function<void()> job;
+			{
+				std::unique_lock<std::mutex> lock(system->mutex);
+				system->condition.wait(lock, [system]() { return system->stopping || !system->queue.empty(); });
+				if (system->stopping && system->queue.empty()) {
+					return;
+				}
+				job = std::move(system->queue.front());
+				system->queue.pop_front();
+			}
+			job();
+		}
+	}
+
+	JobSystem& getJobSystem() {
+		static JobSystem system;
+		static std::once_flag started;
+		std::call_once(started, []() {
+			uint32_t workers = std::thread::hardware_concurrency();
+			// The calling thread works too
+			workers = workers > 1 ? workers - 1 : XE_JOB_SYSTEM_DEFAULT_WORKERS;
+			for (uint32_t i = 0; i < workers; ++i) {
+				system.workers.emplace_back(runJobWorker, &system, i);
+			}
+		});
+		return system;
+	}
+
+	uint32_t getJobWorkerCount() {
+		return (uint32_t)getJobSystem().workers.size();
+	}
+
+	void submitJob(std::function<void()> job) {
+		JobSystem& system = getJobSystem();
+		{
+			std::lock_guard<std::mutex> lock(system.mutex);
+			system.queue.push_back(std::move(job));
+		}
+		system.condition.notify_one();
+	}
+
+	void runParallelForBatches(ParallelForState& state) {
+		while (true) {
+			uint32_t batch = state.nextBatch.fetch_add(1);
+			if (batch >= state.batches) {
+				return;
+			}
+			uint32_t begin = batch * state.batchSize;
+			(*state.function)(begin, std::min(begin + state.batchSize, state.count));
+
+			if (state.finishedBatches.fetch_add(1) + 1 == state.batches) {
+				std::lock_guard<std::mutex> lock(state.mutex);
+				state.finished.notify_all();
+			}
+		}
+	}
+
+	void parallelFor(uint32_t count, uint32_t batchSize, const std::function<void(uint32_t begin, uint32_t end)>& function) {
+		if (count == 0) {
+			return;
+		}
+		batchSize = std::max(batchSize, 1u);
+		uint32_t batches = (count + batchSize - 1) / batchSize;
+		if (batches == 1) {
+			function(0, count);
+			return;
+		}
+
+		auto state = std::make_shared<ParallelForState>();
+		state->function = &function;
+		state->count = count;
+		state->batchSize = batchSize;
+		state->batches = batches;
+
+		// One helper per worker at most, helpers starting after the last batch was taken return immediately
+		JobSystem& system = getJobSystem();
+		uint32_t helpers = std::min(batches - 1, (uint32_t)system.workers.size());
+		{
+			std::lock_guard<std::mutex> lock(system.mutex);
+			for (uint32_t i = 0; i < helpers; ++i) {
+				system.queue.push_back([state]() { runParallelForBatches(*state); });
+			}
+		}
+		system.condition.notify_all();
+
+		runParallelForBatches(*state);
+
+		std::unique_lock<std::mutex> lock(state->mutex);
+		state->finished.wait(lock, [&state]() { return state->finishedBatches.load() == state->batches; });
+	}
+
+}
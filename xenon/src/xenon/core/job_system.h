@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+namespace xe {
+
+	// Worker threads when the hardware concurrency is unknown
+	#define XE_JOB_SYSTEM_DEFAULT_WORKERS 4
+
+	//----------------------------------------
+	// SECTION: Job system
+	//----------------------------------------
+
+	/*
+		Fixed pool of worker threads started on first use and joined when the process exits. Workers are
+		persistent so per-thread state (profiler buffers, thread locals) is created once per worker.
+		The calling thread of parallelFor works on batches too, so parallelFor can be called from inside a job.
+	*/
+
+	uint32_t getJobWorkerCount();
+
+	// Runs the job on a worker and returns immediately, the job has to own everything it touches
+	void submitJob(std::function<void()> job);
+
+	// Splits [0, count) into batches of batchSize and calls function(begin, end) for every batch on the workers
+	// and the calling thread, returns when all batches are done
+	void parallelFor(uint32_t count, uint32_t batchSize, const std::function<void(uint32_t begin, uint32_t end)>& function);
+
+}
@@ -0,0 +1,211 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#include "xenon/core/filesystem.h"
+#include "xenon/core/log.h"
+
+namespace xe {
+
+	// Event slot of a ring, the capture reads it while the owning thread may overwrite it (sequence lock)
+	struct ProfilerEventSlot {
+		// Index + 1 of the event held by the slot, 0 while it is being written
+		std::atomic<uint64_t> sequence{ 0 };
+		std::atomic<const char*> name{ nullptr };
+		std::atomic<uint64_t> begin{ 0 };
+		std::atomic<uint64_t> end{ 0 };
+	};
+
+	struct ProfilerThreadBuffer {
+		std::unique_ptr<ProfilerEventSlot[]> events;
+		// Events written since the thread registered, only the owning thread stores it
+		std::atomic<uint64_t> written{ 0 };
+		uint32_t threadIndex = 0;
+		std::string threadName;
+		// Written counter when the current capture started
+		uint64_t captureBegin = 0;
+	};
+
+	static const std::chrono::steady_clock::time_point s_epoch = std::chrono::steady_clock::now();
+	static std::atomic<bool> s_recording{ false };
+
+	// Registration and export only, recording does not lock
+	static std::mutex s_buffersMutex;
+	static std::vector<std::unique_ptr<ProfilerThreadBuffer>> s_buffers;
+	static thread_local ProfilerThreadBuffer* s_threadBuffer = nullptr;
+
+	static ProfilerCaptureInfo s_capture;
+	static uint64_t s_frameBegin = 0;
+
+	//----------------------------------------
+	// SECTION: CPU profiler
+	//----------------------------------------
+
+	ProfilerThreadBuffer* getProfilerThreadBuffer() {
+		if (!s_threadBuffer) {
+			std::lock_guard<std::mutex> lock(s_buffersMutex);
+			auto buffer = std::make_unique<ProfilerThreadBuffer>();
+			buffer->events = std::make_unique<ProfilerEventSlot[]>(XE_PROFILER_THREAD_EVENTS);
+			buffer->threadIndex = (uint32_t)s_buffers.size();
+			buffer->threadName = "Thread " + std::to_string(buffer->threadIndex);
+			// Threads registering in the middle of a capture export all their events, captureBegin stays 0
+			s_threadBuffer = buffer.get();
+			s_buffers.push_back(std::move(buffer));
+		}
+		return s_threadBuffer;
+	}
+
+	uint64_t getProfilerTime() {
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_epoch).count();
+	}
+
+	void setProfilerThreadName(const char* name) {
+		ProfilerThreadBuffer* buffer = getProfilerThreadBuffer();
+		std::lock_guard<std::mutex> lock(s_buffersMutex);
+		buffer->threadName = name;
+	}
+
+	bool isProfilerRecording() {
+		return s_recording.load(std::memory_order_relaxed);
+	}
+
+	void recordProfilerEvent(const char* name, uint64_t begin, uint64_t end) {
+		ProfilerThreadBuffer* buffer = getProfilerThreadBuffer();
+		uint64_t index = buffer->written.load(std::memory_order_relaxed);
+		ProfilerEventSlot& slot = buffer->events[index % XE_PROFILER_THREAD_EVENTS];
+		slot.sequence.store(0, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		slot.name.store(name, std::memory_order_relaxed);
+		slot.begin.store(begin, std::memory_order_relaxed);
+		slot.end.store(end, std::memory_order_relaxed);
+		slot.sequence.store(index + 1, std::memory_order_release);
+		buffer->written.store(index + 1, std::memory_order_release);
+	}
+
+
+	//----------------------------------------
+	// SECTION: Capture
+	//----------------------------------------
+
+	void writeJSONString(std::ostringstream& stream, const char* text) {
+		stream << '"';
+		for (const char* c = text; *c; ++c) {
+			if (*c == '"' || *c == '\\') {
+				stream << '\\';
+			}
+			stream << *c;
+		}
+		stream << '"';
+	}
+
+	// False when the owning thread overwrote the slot with a newer event while it was read
+	bool readProfilerEvent(const ProfilerEventSlot& slot, uint64_t index, ProfilerEvent& event) {
+		uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+		event.name = slot.name.load(std::memory_order_relaxed);
+		event.begin = slot.begin.load(std::memory_order_relaxed);
+		event.end = slot.end.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return sequence == index + 1 && slot.sequence.load(std::memory_order_relaxed) == sequence;
+	}
+
+	// Chrome trace event format, complete ("X") events with microsecond timestamps
+	void writeProfilerCapture() {
+		std::ostringstream stream;
+		stream.precision(3);
+		stream << std::fixed;
+		stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+		size_t events = 0, dropped = 0;
+		bool first = true;
+		{
+			std::lock_guard<std::mutex> lock(s_buffersMutex);
+			for (const auto& buffer : s_buffers) {
+				uint64_t end = buffer->written.load(std::memory_order_acquire);
+				uint64_t begin = std::max(buffer->captureBegin, end > XE_PROFILER_THREAD_EVENTS ? end - XE_PROFILER_THREAD_EVENTS : 0);
+				dropped += (size_t)(begin - buffer->captureBegin);
+
+				stream << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadIndex << ",\"args\":{\"name\":";
+				writeJSONString(stream, buffer->threadName.c_str());
+				stream << "}}";
+				first = false;
+
+				// Threads keep recording scopes that were open when the capture ended, they can wrap into this range
+				for (uint64_t i = begin; i < end; ++i) {
+					ProfilerEvent event;
+					if (!readProfilerEvent(buffer->events[i % XE_PROFILER_THREAD_EVENTS], i, event)) {
+						++dropped;
+						continue;
+					}
+					++events;
+					stream << ",\n{\"name\":";
+					writeJSONString(stream, event.name);
+					stream << ",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadIndex
+						<< ",\"ts\":" << event.begin / 1000.0 << ",\"dur\":" << (event.end - event.begin) / 1000.0 << "}";
+				}
+			}
+		}
+		stream << "\n]}\n";
+
+		s_capture.lastEventCount = events;
+		s_capture.lastDroppedEvents = dropped;
+		if (dropped > 0) {
+			XE_LOG_WARN_F("PROFILER: {} events were overwritten, capture fewer frames", dropped);
+		}
+		if (saveTextResource(s_capture.path, stream.str())) {
+			XE_LOG_INFO_F("PROFILER: Captured {} frames ({} events) to {}", s_capture.capturedFrames, events, s_capture.path);
+		}
+		else {
+			XE_LOG_ERROR_F("PROFILER: Failed to write capture {}", s_capture.path);
+		}
+	}
+
+	void advanceProfilerFrame() {
+		uint64_t now = getProfilerTime();
+
+		if (s_capture.capturing) {
+			// The frame itself, nested scopes of the main thread show up under it
+			recordProfilerEvent("Frame", s_frameBegin, now);
+			++s_capture.capturedFrames;
+			if (s_capture.capturedFrames >= s_capture.requestedFrames) {
+				s_recording.store(false, std::memory_order_relaxed);
+				s_capture.capturing = false;
+				writeProfilerCapture();
+			}
+		}
+		else if (s_capture.pending) {
+			{
+				std::lock_guard<std::mutex> lock(s_buffersMutex);
+				for (const auto& buffer : s_buffers) {
+					buffer->captureBegin = buffer->written.load(std::memory_order_acquire);
+				}
+			}
+			s_capture.pending = false;
+			s_capture.capturing = true;
+			s_capture.capturedFrames = 0;
+			s_recording.store(true, std::memory_order_relaxed);
+		}
+
+		s_frameBegin = now;
+	}
+
+	void startProfilerCapture(const std::string& path, uint32_t frames) {
+		if (s_capture.capturing || s_capture.pending) {
+			XE_LOG_WARN("PROFILER: A capture is already running");
+			return;
+		}
+		s_capture.pending = true;
+		s_capture.requestedFrames = std::max(frames, 1u);
+		s_capture.path = path;
+	}
+
+	const ProfilerCaptureInfo& getProfilerCaptureInfo() {
+		return s_capture;
+	}
+
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace xe {
+
+	// Events kept per thread, older events are overwritten once a capture records more
+	#define XE_PROFILER_THREAD_EVENTS (64 * 1024)
+	// Frames captured when the caller does not ask for a number
+	#define XE_PROFILER_DEFAULT_CAPTURE_FRAMES 60
+
+	// Define XE_NO_PROFILE to compile out the profiling macros, release builds define it
+
+	//----------------------------------------
+	// SECTION: CPU profiler
+	//----------------------------------------
+
+	/*
+		Scopes are recorded as complete events (name, begin, end) into a ring buffer owned by the recording thread.
+		Only the owning thread writes its buffer, so recording takes no lock: the event is written and the write
+		counter is published with a release store. Each slot carries a sequence number, an export running while
+		threads still record skips slots that were overwritten during the copy instead of reading torn events.
+		Buffers are registered once per thread and kept until the process exits so events of finished threads can
+		still be exported.
+
+		Nothing is recorded outside of a capture, a scope then costs one relaxed atomic load. A capture starts at the
+		next frame boundary (XE_PROFILE_FRAME), runs for the requested number of frames and is written as
+		Chrome trace JSON, which chrome://tracing and ui.perfetto.dev open.
+		Scope names are stored by pointer and have to outlive the capture (string literals, __FUNCTION__).
+	*/
+
+	struct ProfilerEvent {
+		const char* name = nullptr;
+		uint64_t begin = 0;		// Nanoseconds since the profiler epoch
+		uint64_t end = 0;
+	};
+
+	struct ProfilerCaptureInfo {
+		bool capturing = false;
+		bool pending = false;			// Requested, starts at the next frame boundary
+		uint32_t capturedFrames = 0;
+		uint32_t requestedFrames = 0;
+		std::string path;
+		// Previous capture
+		size_t lastEventCount = 0;
+		size_t lastDroppedEvents = 0;	// Overwritten because a thread recorded more than its ring holds
+	};
+
+	uint64_t getProfilerTime();
+
+	// Shown as the thread name in the trace, call from the thread itself
+	void setProfilerThreadName(const char* name);
+
+	bool isProfilerRecording();
+	void recordProfilerEvent(const char* name, uint64_t begin, uint64_t end);
+
+	// Ends the current frame, starts and finishes captures
+	void advanceProfilerFrame();
+
+	// Captures the next frames and writes them to path when done
+	void startProfilerCapture(const std::string& path, uint32_t frames = XE_PROFILER_DEFAULT_CAPTURE_FRAMES);
+	const ProfilerCaptureInfo& getProfilerCaptureInfo();
+
+	struct ProfileScope {
+		ProfileScope(const char* name) : name(isProfilerRecording() ? name : nullptr), begin(this->name ? getProfilerTime() : 0) {}
+		~ProfileScope() {
+			if (name) {
+				recordProfilerEvent(name, begin, getProfilerTime());
+			}
+		}
+
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+
+		const char* name;
+		uint64_t begin;
+	};
+
+	#ifndef XE_NO_PROFILE
+		#define XE_PROFILE_CONCAT_INNER(a, b) a##b
+		#define XE_PROFILE_CONCAT(a, b) XE_PROFILE_CONCAT_INNER(a, b)
+		#define XE_PROFILE_SCOPE(name)	::xe::ProfileScope XE_PROFILE_CONCAT(xeProfileScope, __LINE__)(name)
+		#define XE_PROFILE_FUNCTION()	XE_PROFILE_SCOPE(__FUNCTION__)
+		#define XE_PROFILE_FRAME()		::xe::advanceProfilerFrame()
+	#else
+		#define XE_PROFILE_SCOPE(name)
+		#define XE_PROFILE_FUNCTION()
+		#define XE_PROFILE_FRAME()
+	#endif
+
+}
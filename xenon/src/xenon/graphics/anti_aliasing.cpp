@@ -0,0 +1,234 @@
+#include "anti_aliasing.h"
+
+#include <vector>
+
+#include "xenon/core/log.h"
+#include "xenon/core/assert.h"
+#include "xenon/graphics/gl_state.h"
+#include "xenon/graphics/render_stats.h"
+#include "xenon/graphics/primitives.h"
+
+namespace xe {
+
+	//----------------------------------------
+	// SECTION: Anti-aliasing
+	//----------------------------------------
+
+	AntiAliasing* createAntiAliasing() {
+		AntiAliasing* antiAliasing = new AntiAliasing();
+		antiAliasing->fxaaShader = loadShader("assets/shaders/framebuffer.vert", "assets/shaders/fxaa.frag");
+		antiAliasing->taaShader = loadShader("assets/shaders/framebuffer.vert", "assets/shaders/taa.frag");
+		if (!antiAliasing->fxaaShader || !antiAliasing->taaShader) {
+			XE_LOG_ERROR("ANTI-ALIASING: Failed to load post process shaders, FXAA and TAA are disabled");
+		}
+		antiAliasing->planeModel = generatePlaneModel(1.0f, 1.0f, GeneratorDirection::FRONT);
+		return antiAliasing;
+	}
+
+	void destroyAntiAliasing(AntiAliasing* antiAliasing) {
+		if (antiAliasing->objectIDFramebuffer) {
+			destroyFramebuffer(antiAliasing->objectIDFramebuffer);
+		}
+		for (Framebuffer* framebuffer : antiAliasing->postFramebuffers) {
+			if (framebuffer) {
+				destroyFramebuffer(framebuffer);
+			}
+		}
+		if (antiAliasing->fxaaShader) {
+			destroyShader(antiAliasing->fxaaShader);
+		}
+		if (antiAliasing->taaShader) {
+			destroyShader(antiAliasing->taaShader);
+		}
+		destroyModel(antiAliasing->planeModel);
+		delete antiAliasing;
+	}
+
+
+	//----------------------------------------
+	// SECTION: Anti-aliasing functions
+	//----------------------------------------
+
+	int getAntiAliasingSamples(AntiAliasingMode mode) {
+		switch (mode) {
+		case AntiAliasingMode::MSAA_2X: return 2;
+		case AntiAliasingMode::MSAA_4X: return 4;
+		case AntiAliasingMode::MSAA_8X: return 8;
+		default: return 1;
+		}
+	}
+
+	void setAntiAliasingMode(AntiAliasing* antiAliasing, Framebuffer* framebuffer, AntiAliasingMode mode) {
+		// Move the integer attachments of the previous mode back into the framebuffer
+		if (antiAliasing->objectIDFramebuffer) {
+			for (const auto& [target, attachment] : antiAliasing->objectIDFramebuffer->attachments) {
+				if (target != GL_DEPTH_ATTACHMENT) {
+					framebuffer->attachments.insert({ target, FramebufferAttachment{ attachment.target, attachment.format, attachment.textureParams } });
+				}
+			}
+			destroyFramebuffer(antiAliasing->objectIDFramebuffer);
+			antiAliasing->objectIDFramebuffer = nullptr;
+		}
+
+		int samples = getAntiAliasingSamples(mode);
+		if (samples > 1) {
+			// Integer attachments can not be resolved, they stay single sampled in their own framebuffer
+			std::vector<GLenum> integerTargets;
+			Framebuffer* objectIDFramebuffer = createFramebuffer(framebuffer->width, framebuffer->height, 1, framebuffer->pool);
+			for (const auto& [target, attachment] : framebuffer->attachments) {
+				if (attachment.format == TextureFormat::RED_INTEGER) {
+					objectIDFramebuffer->attachments.insert({ target, FramebufferAttachment{ attachment.target, attachment.format, attachment.textureParams } });
+					integerTargets.push_back(target);
+				}
+			}
+			for (GLenum target : integerTargets) {
+				removeFramebufferAttachment(framebuffer, target);
+			}
+
+			if (integerTargets.empty()) {
+				destroyFramebuffer(objectIDFramebuffer);
+			}
+			else {
+				objectIDFramebuffer->attachments.insert(createDefaultFramebufferAttachment(DefaultAttachmentType::DEPTH));
+				buildFramebuffer(objectIDFramebuffer);
+				antiAliasing->objectIDFramebuffer = objectIDFramebuffer;
+			}
+		}
+
+		framebuffer->samples = samples;
+		rebuildFramebuffer(framebuffer);
+
+		antiAliasing->mode = mode;
+		antiAliasing->historyValid = false;
+	}
+
+	float halton(uint32_t index, uint32_t base) {
+		float result = 0.0f;
+		float fraction = 1.0f;
+		while (index > 0) {
+			fraction /= (float)base;
+			result += fraction * (float)(index % base);
+			index /= base;
+		}
+		return result;
+	}
+
+	void beginAntiAliasingFrame(AntiAliasing* antiAliasing, const Framebuffer& framebuffer, Camera& camera) {
+		antiAliasing->projection = camera.projection;
+		if (antiAliasing->mode != AntiAliasingMode::TAA || !antiAliasing->taaShader) {
+			return;
+		}
+
+		// Sub-pixel offset in [-0.5, 0.5] pixels, applied after the projection so it is the same at every depth
+		uint32_t index = (uint32_t)(antiAliasing->frame % XE_TAA_JITTER_SAMPLES) + 1;
+		glm::vec2 jitter = glm::vec2(halton(index, 2), halton(index, 3)) - 0.5f;
+		glm::mat4 jitterMatrix = glm::mat4(1.0f);
+		jitterMatrix[3][0] = jitter.x * 2.0f / (float)framebuffer.viewportWidth;
+		jitterMatrix[3][1] = jitter.y * 2.0f / (float)framebuffer.viewportHeight;
+		camera.projection = jitterMatrix * camera.projection;
+	}
+
+	Framebuffer* prepareObjectIDFramebuffer(AntiAliasing* antiAliasing, const Framebuffer& framebuffer) {
+		Framebuffer* objectIDFramebuffer = antiAliasing->objectIDFramebuffer;
+		if (!objectIDFramebuffer) {
+			return nullptr;
+		}
+
+		if (objectIDFramebuffer->width != framebuffer.width || objectIDFramebuffer->height != framebuffer.height) {
+			updateFramebufferSize(objectIDFramebuffer, framebuffer.width, framebuffer.height);
+		}
+		setFramebufferViewport(objectIDFramebuffer, framebuffer.viewportWidth, framebuffer.viewportHeight);
+		bindFramebuffer(*objectIDFramebuffer);
+
+		const GLuint noObject = 0;
+		const GLfloat farDepth = 1.0f;
+		setGLDepthMask(true);
+		for (const auto& [target, attachment] : objectIDFramebuffer->attachments) {
+			if (target != GL_DEPTH_ATTACHMENT) {
+				glClearNamedFramebufferuiv(objectIDFramebuffer->frambufferID, GL_COLOR, target - GL_COLOR_ATTACHMENT0, &noObject);
+			}
+		}
+		glClearNamedFramebufferfv(objectIDFramebuffer->frambufferID, GL_DEPTH, 0, &farDepth);
+		return objectIDFramebuffer;
+	}
+
+	void resizePostFramebuffers(AntiAliasing* antiAliasing, const Framebuffer& framebuffer) {
+		for (Framebuffer*& post : antiAliasing->postFramebuffers) {
+			if (!post) {
+				// Float color so the TAA history does not lose precision when blending
+				post = createFramebuffer(framebuffer.width, framebuffer.height, 1, framebuffer.pool);
+				TextureParameters params = TextureParameters{ GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE };
+				post->attachments.insert({ GL_COLOR_ATTACHMENT0, FramebufferAttachment{ GL_COLOR_ATTACHMENT0, TextureFormat::RGB_FLOAT, params } });
+				buildFramebuffer(post);
+			}
+			else if (post->width != framebuffer.width || post->height != framebuffer.height) {
+				updateFramebufferSize(post, framebuffer.width, framebuffer.height);
+			}
+			setFramebufferViewport(post, framebuffer.viewportWidth, framebuffer.viewportHeight);
+		}
+	}
+
+	void resolveAntiAliasing(AntiAliasing* antiAliasing, Framebuffer* framebuffer, Camera& camera) {
+		// Without jitter on both sides, the history is accumulated unjittered and a static camera reprojects onto itself
+		glm::mat4 viewProjection = antiAliasing->projection * camera.inverseTransform;
+		camera.projection = antiAliasing->projection;
+
+		bool fxaa = antiAliasing->mode == AntiAliasingMode::FXAA && antiAliasing->fxaaShader;
+		bool taa = antiAliasing->mode == AntiAliasingMode::TAA && antiAliasing->taaShader;
+		if (!fxaa && !taa) {
+			antiAliasing->historyValid = false;
+			return;
+		}
+		XE_ASSERT(framebuffer->samples == 1);
+
+		resizePostFramebuffers(antiAliasing, *framebuffer);
+		glm::uvec2 region = glm::uvec2(framebuffer->viewportWidth, framebuffer->viewportHeight);
+		Framebuffer* target = antiAliasing->postFramebuffers[antiAliasing->postIndex];
+
+		bindFramebuffer(*target);
+		setGLCapability(GL_DEPTH_TEST, false);
+		bindGLTextureUnit(0, framebuffer->attachments.at(GL_COLOR_ATTACHMENT0).texture->textureID);
+
+		if (fxaa) {
+			const Shader& shader = *antiAliasing->fxaaShader;
+			bindShader(shader);
+			loadVec2(shader, "regionSize", glm::vec2(region));
+		}
+		else {
+			// The history is only usable at the resolution it was rendered at
+			if (antiAliasing->historySize != region) {
+				antiAliasing->historyValid = false;
+			}
+
+			const Shader& shader = *antiAliasing->taaShader;
+			const Framebuffer* history = antiAliasing->postFramebuffers[1 - antiAliasing->postIndex];
+			bindShader(shader);
+			bindGLTextureUnit(1, framebuffer->attachments.at(GL_DEPTH_ATTACHMENT).texture->textureID);
+			bindGLTextureUnit(2, history->attachments.at(GL_COLOR_ATTACHMENT0).texture->textureID);
+			loadMat4(shader, "reprojection", antiAliasing->previousViewProjection * glm::inverse(viewProjection));
+			loadVec2(shader, "regionSize", glm::vec2(region));
+			loadInt(shader, "historyValid", antiAliasing->historyValid);
+			loadFloat(shader, "historyWeight", XE_TAA_HISTORY_WEIGHT);
+		}
+
+		const Primitive& primitive = antiAliasing->planeModel->primitives[0];
+		bindGLVertexArray(primitive.vao);
+		glDrawArrays(primitive.mode, 0, primitive.count);
+		recordDrawCall(primitive.mode, primitive.count);
+
+		setGLCapability(GL_DEPTH_TEST, true);
+		unbindFramebuffer();
+
+		// Copy the result back, the following passes only see the color attachment of framebuffer
+		blitFramebuffers(target, framebuffer);
+
+		if (taa) {
+			antiAliasing->previousViewProjection = viewProjection;
+			antiAliasing->historySize = region;
+			antiAliasing->historyValid = true;
+			antiAliasing->postIndex = 1 - antiAliasing->postIndex;
+			++antiAliasing->frame;
+		}
+	}
+
+}
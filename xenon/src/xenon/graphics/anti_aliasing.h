@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include "xenon/graphics/camera.h"
+#include "xenon/graphics/framebuffer.h"
+#include "xenon/graphics/model.h"
+#include "xenon/graphics/shader.h"
+
+namespace xe {
+
+	// Length of the TAA jitter sequence (Halton 2, 3)
+	#define XE_TAA_JITTER_SAMPLES 8
+	// Weight of the reprojected history in the TAA result
+	#define XE_TAA_HISTORY_WEIGHT 0.9f
+
+	//----------------------------------------
+	// SECTION: Anti-aliasing
+	//----------------------------------------
+
+	/*
+		Anti-aliasing of one framebuffer.
+
+		MSAA: the framebuffer is multisampled, except for its integer (object ID) attachments. Those are moved
+		      to a single sampled framebuffer that is filled by a separate depth tested pass, see
+		      prepareObjectIDFramebuffer.
+		FXAA: post process on the color attachment of the single sampled framebuffer.
+		TAA:  the projection is jittered every frame and the color attachment is blended with the reprojected
+		      history of the previous frames, clamped to the neighborhood of the current frame.
+	*/
+
+	enum class AntiAliasingMode : uint8_t {
+		NONE		= 0,
+		MSAA_2X		= 1,
+		MSAA_4X		= 2,
+		MSAA_8X		= 3,
+		FXAA		= 4,
+		TAA			= 5
+	};
+
+	struct AntiAliasing {
+		AntiAliasingMode mode = AntiAliasingMode::NONE;
+
+		// MSAA: single sampled integer attachments and the depth to render them
+		Framebuffer* objectIDFramebuffer = nullptr;
+
+		// FXAA and TAA: result of the post process, copied back into the color attachment. TAA alternates
+		// between both, the other one holds the history.
+		std::array<Framebuffer*, 2> postFramebuffers = {};
+		uint32_t postIndex = 0;
+
+		// TAA
+		uint64_t frame = 0;
+		glm::mat4 projection = glm::mat4(1.0f);				// Projection of the camera without jitter
+		glm::mat4 previousViewProjection = glm::mat4(1.0f);
+		glm::uvec2 historySize = glm::uvec2(0);
+		bool historyValid = false;
+
+		Shader* fxaaShader = nullptr;
+		Shader* taaShader = nullptr;
+		Model* planeModel = nullptr;
+	};
+
+	AntiAliasing* createAntiAliasing();
+	void destroyAntiAliasing(AntiAliasing* antiAliasing);
+
+
+	//----------------------------------------
+	// SECTION: Anti-aliasing functions
+	//----------------------------------------
+
+	int getAntiAliasingSamples(AntiAliasingMode mode);
+
+	// Rebuilds framebuffer with the sample count of mode
+	void setAntiAliasingMode(AntiAliasing* antiAliasing, Framebuffer* framebuffer, AntiAliasingMode mode);
+
+	// TAA: jitters the projection of camera, call after the viewport of framebuffer is set
+	void beginAntiAliasingFrame(AntiAliasing* antiAliasing, const Framebuffer& framebuffer, Camera& camera);
+	// MSAA: returns the object ID framebuffer matching framebuffer, bound and cleared. Returns nullptr when
+	// framebuffer holds the object IDs itself.
+	Framebuffer* prepareObjectIDFramebuffer(AntiAliasing* antiAliasing, const Framebuffer& framebuffer);
+	// FXAA/TAA: filters the color attachment of framebuffer. Restores the projection of camera.
+	void resolveAntiAliasing(AntiAliasing* antiAliasing, Framebuffer* framebuffer, Camera& camera);
+
+}
@@ -1,47 +1,165 @@
 #include "brdf.h"
 
-#include "xenon/graphics/framebuffer.h"
-#include "xenon/graphics/primitives.h"
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+#include <ktx.h>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include "xenon/core/log.h"
+#include "xenon/core/job_system.h"
+#include "xenon/core/profiler.h"
 
 namespace xe {
 
-	Texture* generateBRDFLUT(unsigned int width, unsigned int height) {
-		// Create shader, framebuffer and load model.
-		Shader* shader = loadShader("assets/shaders/brdf.vert", "assets/shaders/brdf.frag");
-		Model* plane = generatePlaneModel(1, 1, GeneratorDirection::FRONT);
-		Framebuffer* framebuffer = createFramebuffer(width, height);
+	// VK_FORMAT_R16G16_SFLOAT, KTX2 files describe their format with Vulkan formats
+	#define XE_BRDF_LUT_VK_FORMAT 83
+	// Rows of the table integrated by one job
+	#define XE_BRDF_LUT_ROWS_PER_JOB 4
+
+	//----------------------------------------
+	// SECTION: BRDF LUT
+	//----------------------------------------
+
+	float radicalInverse(uint32_t bits) {
+		bits = (bits << 16u) | (bits >> 16u);
+		bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+		bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+		bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+		bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+		return (float)bits * 2.3283064365386963e-10f;
+	}
 
-		TextureParameters params = TextureParameters{ GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE };
-		framebuffer->attachments.insert({ GL_COLOR_ATTACHMENT0, FramebufferAttachment{ GL_COLOR_ATTACHMENT0, TextureFormat::RGB_FLOAT, params } });
+	// Schlick-GGX with the k of image based lighting
+	float geometrySchlickGGX(float NdotX, float roughness) {
+		float k = roughness * roughness / 2.0f;
+		return NdotX / (NdotX * (1.0f - k) + k);
+	}
 
-		buildFramebuffer(framebuffer);
+	glm::vec2 integrateBRDF(float NdotV, float roughness, uint32_t samples) {
+		// Tangent space, N = +Z and V in the XZ plane
+		glm::vec3 V = glm::vec3(glm::sqrt(1.0f - NdotV * NdotV), 0.0f, NdotV);
+		float a = roughness * roughness;
 
-		// Render BRDF to framebuffer texture
-		bindFramebuffer(*framebuffer);
-		bindShader(*shader);
-		glClear(GL_COLOR_BUFFER_BIT);
+		glm::vec2 result = glm::vec2(0.0f);
+		for (uint32_t i = 0; i < samples; ++i) {
+			// GGX importance sample of the half vector
+			float phi = 2.0f * glm::pi<float>() * (float)i / samples;
+			float xi = radicalInverse(i);
+			float cosTheta = glm::sqrt((1.0f - xi) / (1.0f + (a * a - 1.0f) * xi));
+			float sinTheta = glm::sqrt(1.0f - cosTheta * cosTheta);
+			glm::vec3 H = glm::vec3(glm::cos(phi) * sinTheta, glm::sin(phi) * sinTheta, cosTheta);
+			glm::vec3 L = 2.0f * glm::dot(V, H) * H - V;
 
-		GLint viewport[4];
-		glGetIntegerv(GL_VIEWPORT, viewport);
-		glViewport(0, 0, width, height);
+			float NdotL = L.z;
+			if (NdotL > 0.0f) {
+				float NdotH = glm::max(H.z, 0.0f);
+				float VdotH = glm::max(glm::dot(V, H), 0.0f);
+				float G = geometrySchlickGGX(NdotV, roughness) * geometrySchlickGGX(NdotL, roughness);
+				float visibility = G * VdotH / (NdotH * NdotV);
+				float fresnel = glm::pow(1.0f - VdotH, 5.0f);
+				result += glm::vec2((1.0f - fresnel) * visibility, fresnel * visibility);
+			}
+		}
+		return result / (float)samples;
+	}
 
-		const Primitive& primitive = plane->primitives[0];
-		glBindVertexArray(primitive.vao);
-		glDrawArrays(primitive.mode, 0, primitive.count);
-		glBindVertexArray(0);
+	void integrateBRDFLUT(glm::vec2* target, int resolution, uint32_t samples) {
+		XE_PROFILE_FUNCTION();
+		parallelFor((uint32_t)resolution, XE_BRDF_LUT_ROWS_PER_JOB, [&](uint32_t begin, uint32_t end) {
+			XE_PROFILE_SCOPE("integrateBRDFLUT rows");
+			for (uint32_t y = begin; y < end; ++y) {
+				float roughness = (y + 0.5f) / resolution;
+				for (int x = 0; x < resolution; ++x) {
+					float NdotV = (x + 0.5f) / resolution;
+					target[y * resolution + x] = integrateBRDF(NdotV, roughness, samples);
+				}
+			}
+		});
+	}
 
-		unbindShader();
-		unbindFramebuffer();
+	std::string getBRDFLUTCachePath() {
+		// The settings are part of the name so changing them integrates again
+		char name[64];
+		std::snprintf(name, sizeof(name), "brdf_lut_%d_%d.ktx2", XE_BRDF_LUT_RESOLUTION, XE_BRDF_LUT_SAMPLES);
+		return std::string(XE_BRDF_LUT_CACHE_DIRECTORY) + name;
+	}
 
-		glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	Texture* createBRDFLUTTexture(const uint16_t* data, int resolution) {
+		const TextureParameters params = TextureParameters{ GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE };
+		Texture* texture = createEmptyTexture(resolution, resolution, TextureFormat::RG_FLOAT, params);
+		glTextureSubImage2D(texture->textureID, 0, 0, 0, resolution, resolution, GL_RG, GL_HALF_FLOAT, data);
+		return texture;
+	}
+
+	Texture* loadBRDFLUTCache(const std::string& path) {
+		ktxTexture* cache = nullptr;
+		if (!std::filesystem::exists(path)
+			|| ktxTexture_CreateFromNamedFile(path.c_str(), KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, &cache) != KTX_SUCCESS) {
+			return nullptr;
+		}
+
+		Texture* texture = nullptr;
+		size_t expectedSize = (size_t)XE_BRDF_LUT_RESOLUTION * XE_BRDF_LUT_RESOLUTION * 2 * sizeof(uint16_t);
+		if (cache->baseWidth == XE_BRDF_LUT_RESOLUTION && cache->baseHeight == XE_BRDF_LUT_RESOLUTION && ktxTexture_GetDataSize(cache) >= expectedSize) {
+			texture = createBRDFLUTTexture((const uint16_t*)ktxTexture_GetData(cache), XE_BRDF_LUT_RESOLUTION);
+		}
+		ktxTexture_Destroy(cache);
+		return texture;
+	}
+
+	void writeBRDFLUTCache(const std::string& path, std::vector<uint16_t> data) {
+		submitJob([path, data = std::move(data)]() {
+			ktxTextureCreateInfo info = {};
+			info.glInternalformat = GL_RG16F;
+			info.vkFormat = XE_BRDF_LUT_VK_FORMAT;
+			info.baseWidth = XE_BRDF_LUT_RESOLUTION;
+			info.baseHeight = XE_BRDF_LUT_RESOLUTION;
+			info.baseDepth = 1;
+			info.numDimensions = 2;
+			info.numLevels = 1;
+			info.numLayers = 1;
+			info.numFaces = 1;
+			info.isArray = KTX_FALSE;
+			info.generateMipmaps = KTX_FALSE;
+
+			ktxTexture2* cache = nullptr;
+			if (ktxTexture2_Create(&info, KTX_TEXTURE_CREATE_ALLOC_STORAGE, &cache) != KTX_SUCCESS) {
+				XE_LOG_ERROR("BRDF: Failed to create the LUT cache");
+				return;
+			}
+			ktxTexture_SetImageFromMemory(ktxTexture(cache), 0, 0, 0, (const ktx_uint8_t*)data.data(), data.size() * sizeof(uint16_t));
+
+			std::error_code error;
+			std::filesystem::create_directories(XE_BRDF_LUT_CACHE_DIRECTORY, error);
+			if (ktxTexture_WriteToNamedFile(ktxTexture(cache), path.c_str()) != KTX_SUCCESS) {
+				XE_LOG_ERROR_F("BRDF: Failed to write the LUT cache {}", path);
+			}
+			ktxTexture_Destroy(ktxTexture(cache));
+		});
+	}
 
-		// Extract framebuffer texture
-		Texture* texture = framebuffer->attachments.at(GL_COLOR_ATTACHMENT0).texture;
+	Texture* loadBRDFLUT() {
+		XE_PROFILE_FUNCTION();
+		std::string path = getBRDFLUTCachePath();
+		Texture* texture = loadBRDFLUTCache(path);
+		if (texture) {
+			return texture;
+		}
 
-		// Delete only the framebuffer, not the texture rendered to
-		glDeleteFramebuffers(1, &framebuffer->frambufferID);
-		delete framebuffer;
+		std::vector<glm::vec2> table((size_t)XE_BRDF_LUT_RESOLUTION * XE_BRDF_LUT_RESOLUTION);
+		integrateBRDFLUT(table.data(), XE_BRDF_LUT_RESOLUTION, XE_BRDF_LUT_SAMPLES);
 
+		std::vector<uint16_t> halfs(table.size() * 2);
+		for (size_t i = 0; i < table.size(); ++i) {
+			halfs[i * 2] = glm::packHalf1x16(table[i].x);
+			halfs[i * 2 + 1] = glm::packHalf1x16(table[i].y);
+		}
+		texture = createBRDFLUTTexture(halfs.data(), XE_BRDF_LUT_RESOLUTION);
+		XE_LOG_INFO_F("BRDF: Integrated the LUT, caching it as {}", path);
+		writeBRDFLUTCache(path, std::move(halfs));
 		return texture;
 	}
 
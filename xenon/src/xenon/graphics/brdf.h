@@ -1,9 +1,35 @@
 #pragma once
 
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
 #include "xenon/graphics/texture.h"
 
 namespace xe {
 
-	Texture* generateBRDFLUT(unsigned int width, unsigned int height);
+	// Size of the BRDF LUT, the integral is smooth so a small table is enough
+	#define XE_BRDF_LUT_RESOLUTION 128
+	// GGX importance samples per texel
+	#define XE_BRDF_LUT_SAMPLES 1024
+	// Directory of the cached table, relative to the working directory
+	#define XE_BRDF_LUT_CACHE_DIRECTORY "cache/"
+
+	//----------------------------------------
+	// SECTION: BRDF LUT
+	//----------------------------------------
+
+	/*
+		Split sum environment BRDF (Karis, "Real Shading in Unreal Engine 4"): scale (r) and bias (g) of F0 over
+		NdotV (u) and roughness (v). The table is integrated on the CPU with the job system once and cached as a
+		KTX2 file, later starts only read and upload it.
+	*/
+
+	glm::vec2 integrateBRDF(float NdotV, float roughness, uint32_t samples);
+	// Rows of increasing roughness, texel centers like the GPU samples them
+	void integrateBRDFLUT(glm::vec2* target, int resolution, uint32_t samples);
+
+	// RG16F texture from the cache, integrated and cached when there is none
+	Texture* loadBRDFLUT();
 
 }
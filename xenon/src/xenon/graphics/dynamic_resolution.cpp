@@ -0,0 +1,194 @@
+#include "dynamic_resolution.h"
+
+#include <glm/glm.hpp>
+
+#include "xenon/core/log.h"
+#include "xenon/core/assert.h"
+#include "xenon/graphics/gl_state.h"
+#include "xenon/graphics/render_stats.h"
+#include "xenon/graphics/primitives.h"
+
+namespace xe {
+
+	//----------------------------------------
+	// SECTION: Dynamic resolution
+	//----------------------------------------
+
+	DynamicResolution* createDynamicResolution() {
+		DynamicResolution* resolution = new DynamicResolution();
+		for (auto& frameQueries : resolution->queries) {
+			glCreateQueries(GL_TIMESTAMP, (GLsizei)frameQueries.size(), frameQueries.data());
+		}
+
+		resolution->sharpenShader = loadShader("assets/shaders/framebuffer.vert", "assets/shaders/sharpen.frag");
+		if (!resolution->sharpenShader) {
+			XE_LOG_ERROR("DYNAMIC RESOLUTION: Failed to load sharpen shader, falling back to bilinear upscaling");
+		}
+		resolution->planeModel = generatePlaneModel(1.0f, 1.0f, GeneratorDirection::FRONT);
+		return resolution;
+	}
+
+	void destroyDynamicResolution(DynamicResolution* resolution) {
+		for (auto& frameQueries : resolution->queries) {
+			glDeleteQueries((GLsizei)frameQueries.size(), frameQueries.data());
+		}
+		if (resolution->resolveFramebuffer) {
+			destroyFramebuffer(resolution->resolveFramebuffer);
+		}
+		if (resolution->sharpenShader) {
+			destroyShader(resolution->sharpenShader);
+		}
+		destroyModel(resolution->planeModel);
+		delete resolution;
+	}
+
+
+	//----------------------------------------
+	// SECTION: Dynamic resolution functions
+	//----------------------------------------
+
+	// Returns the GPU time of the newest finished frame in milliseconds, or a negative value if none finished
+	float collectGPUTime(DynamicResolution* resolution) {
+		float newest = -1.0f;
+		for (uint64_t age = XE_DYNAMIC_RESOLUTION_FRAMES; age > 0; --age) {
+			if (resolution->frame < age) {
+				continue;
+			}
+			size_t slot = (resolution->frame - age) % XE_DYNAMIC_RESOLUTION_FRAMES;
+			if (!resolution->pending[slot]) {
+				continue;
+			}
+
+			GLint available = GL_FALSE;
+			glGetQueryObjectiv(resolution->queries[slot][1], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available) {
+				// Later frames can not have finished either
+				break;
+			}
+
+			GLuint64 begin = 0, end = 0;
+			glGetQueryObjectui64v(resolution->queries[slot][0], GL_QUERY_RESULT, &begin);
+			glGetQueryObjectui64v(resolution->queries[slot][1], GL_QUERY_RESULT, &end);
+			resolution->pending[slot] = false;
+			newest = (float)(end - begin) * 1e-6f;
+		}
+		return newest;
+	}
+
+	void updateScale(DynamicResolution* resolution, float gpuTime) {
+		DynamicResolutionSettings& settings = resolution->settings;
+		settings.maxScale = glm::clamp(settings.maxScale, XE_DYNAMIC_RESOLUTION_STEP, 1.0f);
+		settings.minScale = glm::clamp(settings.minScale, XE_DYNAMIC_RESOLUTION_STEP, settings.maxScale);
+
+		if (gpuTime > 0.0f) {
+			resolution->gpuTime = resolution->gpuTime > 0.0f ? glm::mix(resolution->gpuTime, gpuTime, XE_DYNAMIC_RESOLUTION_SMOOTHING) : gpuTime;
+		}
+
+		if (!settings.enabled) {
+			resolution->scale = 1.0f;
+			return;
+		}
+
+		float time = resolution->gpuTime;
+		float target = settings.targetGPUTime;
+		if (gpuTime > 0.0f && time > 0.0f && (time > target || time < target * (1.0f - XE_DYNAMIC_RESOLUTION_HEADROOM))) {
+			// The cost is proportional to the pixel count, which grows with the square of the scale
+			float desired = resolution->scale * glm::sqrt(target / time);
+			float step = glm::clamp(desired - resolution->scale, -XE_DYNAMIC_RESOLUTION_STEP, XE_DYNAMIC_RESOLUTION_STEP);
+			// Snap so the viewport does not change on every frame while converging
+			resolution->scale = glm::round((resolution->scale + step) / XE_DYNAMIC_RESOLUTION_STEP) * XE_DYNAMIC_RESOLUTION_STEP;
+		}
+		resolution->scale = glm::clamp(resolution->scale, settings.minScale, settings.maxScale);
+	}
+
+	void beginDynamicResolutionFrame(DynamicResolution* resolution, Framebuffer* framebuffer) {
+		updateScale(resolution, collectGPUTime(resolution));
+
+		unsigned int width = (unsigned int)glm::round(framebuffer->width * resolution->scale);
+		unsigned int height = (unsigned int)glm::round(framebuffer->height * resolution->scale);
+		setFramebufferViewport(framebuffer, width, height);
+
+		// Results of this slot that were not collected yet are lost
+		size_t slot = resolution->frame % XE_DYNAMIC_RESOLUTION_FRAMES;
+		resolution->pending[slot] = false;
+		glQueryCounter(resolution->queries[slot][0], GL_TIMESTAMP);
+	}
+
+	void resizeResolveFramebuffer(DynamicResolution* resolution, const Framebuffer& source) {
+		Framebuffer*& resolve = resolution->resolveFramebuffer;
+		if (resolve && resolve->pool == source.pool) {
+			if (resolve->width != source.width || resolve->height != source.height) {
+				updateFramebufferSize(resolve, source.width, source.height);
+			}
+			return;
+		}
+		if (resolve) {
+			destroyFramebuffer(resolve);
+		}
+
+		// Same color attachments as the source, depth is not needed after the scene was rendered
+		resolve = createFramebuffer(source.width, source.height, 1, source.pool);
+		for (const auto& [target, attachment] : source.attachments) {
+			if (target != GL_DEPTH_ATTACHMENT && target != GL_STENCIL_ATTACHMENT) {
+				resolve->attachments.insert({ target, FramebufferAttachment{ attachment.target, attachment.format, attachment.textureParams } });
+			}
+		}
+		buildFramebuffer(resolve);
+	}
+
+	void sharpenFramebuffer(DynamicResolution* resolution, const Framebuffer& source, Framebuffer* target) {
+		const Shader& shader = *resolution->sharpenShader;
+
+		bindFramebuffer(*target);
+		glNamedFramebufferDrawBuffer(target->frambufferID, GL_COLOR_ATTACHMENT0);
+		setGLCapability(GL_DEPTH_TEST, false);
+
+		bindShader(shader);
+		bindGLTextureUnit(0, source.attachments.at(GL_COLOR_ATTACHMENT0).texture->textureID);
+		glm::vec2 textureSize = glm::vec2(source.textureWidth, source.textureHeight);
+		loadVec2(shader, "sourceScale", glm::vec2(source.viewportWidth, source.viewportHeight) / textureSize);
+		loadVec2(shader, "sourceTexelSize", 1.0f / textureSize);
+		loadFloat(shader, "sharpness", glm::clamp(resolution->settings.sharpness, 0.0f, 1.0f));
+
+		const Primitive& primitive = resolution->planeModel->primitives[0];
+		bindGLVertexArray(primitive.vao);
+		glDrawArrays(primitive.mode, 0, primitive.count);
+		recordDrawCall(primitive.mode, primitive.count);
+
+		setGLCapability(GL_DEPTH_TEST, true);
+		glNamedFramebufferDrawBuffers(target->frambufferID, target->colorBuffers.size(), target->colorBuffers.data());
+		unbindFramebuffer();
+	}
+
+	void resolveDynamicResolution(DynamicResolution* resolution, Framebuffer* source, Framebuffer* target) {
+		bool scaled = source->viewportWidth != target->viewportWidth || source->viewportHeight != target->viewportHeight;
+		bool sharpen = resolution->settings.filter == UpscaleFilter::SHARPEN && resolution->sharpenShader;
+
+		if (!scaled && !sharpen) {
+			// Same size, a single blit resolves the samples
+			blitFramebuffers(source, target);
+		}
+		else {
+			// Multisampled framebuffers can only be blitted without scaling, resolve the samples first
+			Framebuffer* scaleSource = source;
+			if (source->samples > 1) {
+				resizeResolveFramebuffer(resolution, *source);
+				setFramebufferViewport(resolution->resolveFramebuffer, source->viewportWidth, source->viewportHeight);
+				blitFramebuffers(source, resolution->resolveFramebuffer);
+				scaleSource = resolution->resolveFramebuffer;
+			}
+
+			// Object IDs use nearest filtering through blitFramebuffers, the color is overwritten when sharpening
+			blitFramebuffers(scaleSource, target, GL_LINEAR);
+			if (sharpen) {
+				sharpenFramebuffer(resolution, *scaleSource, target);
+			}
+		}
+
+		size_t slot = resolution->frame % XE_DYNAMIC_RESOLUTION_FRAMES;
+		glQueryCounter(resolution->queries[slot][1], GL_TIMESTAMP);
+		resolution->pending[slot] = true;
+		++resolution->frame;
+	}
+
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <glad/gl.h>
+
+#include "xenon/graphics/framebuffer.h"
+#include "xenon/graphics/model.h"
+#include "xenon/graphics/shader.h"
+
+namespace xe {
+
+	// Number of frames of timer queries in flight
+	#define XE_DYNAMIC_RESOLUTION_FRAMES 4
+	// Weight of a new GPU time sample in the smoothed GPU time
+	#define XE_DYNAMIC_RESOLUTION_SMOOTHING 0.1f
+	// The scale is only changed when the GPU time is above the target or this fraction below it
+	#define XE_DYNAMIC_RESOLUTION_HEADROOM 0.15f
+	// Largest scale change per frame, the applied scale is snapped to multiples of this
+	#define XE_DYNAMIC_RESOLUTION_STEP 0.05f
+
+	//----------------------------------------
+	// SECTION: Dynamic resolution
+	//----------------------------------------
+
+	/*
+		Scales the rendered region (viewport) of a framebuffer to keep the GPU time of the scene close to a target.
+		The framebuffer stays allocated at the output size, changing the scale never reallocates, and the rendered
+		region is upscaled when resolving into the output framebuffer.
+	*/
+
+	enum class UpscaleFilter : uint8_t {
+		BILINEAR	= 0,
+		SHARPEN		= 1		// Bilinear followed by contrast adaptive sharpening
+	};
+
+	struct DynamicResolutionSettings {
+		bool enabled = false;
+		float targetGPUTime = 8.0f;		// Milliseconds between beginDynamicResolutionFrame and the end of the resolve
+		float minScale = 0.5f;
+		float maxScale = 1.0f;			// At most 1, the framebuffer is allocated at the output size
+		UpscaleFilter filter = UpscaleFilter::BILINEAR;
+		float sharpness = 0.5f;
+	};
+
+	struct DynamicResolution {
+		DynamicResolutionSettings settings;
+
+		float scale = 1.0f;
+		float gpuTime = 0.0f;			// Smoothed, milliseconds
+
+		// Timestamps at the begin and end of every frame
+		uint64_t frame = 0;
+		std::array<std::array<GLuint, 2>, XE_DYNAMIC_RESOLUTION_FRAMES> queries = {};
+		std::array<bool, XE_DYNAMIC_RESOLUTION_FRAMES> pending = {};
+
+		// Single sampled copy of the rendered region, same size as the rendered framebuffer
+		Framebuffer* resolveFramebuffer = nullptr;
+		Shader* sharpenShader = nullptr;
+		Model* planeModel = nullptr;
+	};
+
+	DynamicResolution* createDynamicResolution();
+	void destroyDynamicResolution(DynamicResolution* resolution);
+
+
+	//----------------------------------------
+	// SECTION: Dynamic resolution functions
+	//----------------------------------------
+
+	// Updates the scale from the finished timings and sets the viewport of framebuffer, call before binding it
+	void beginDynamicResolutionFrame(DynamicResolution* resolution, Framebuffer* framebuffer);
+	// Resolves and upscales the viewport of source into the viewport of target
+	void resolveDynamicResolution(DynamicResolution* resolution, Framebuffer* source, Framebuffer* target);
+
+}
@@ -1,13 +1,15 @@
 #pragma once
 
 #include "xenon/graphics/texture.h"
+#include "xenon/graphics/spherical_harmonics.h"
 
 namespace xe {
 
 	struct Environment {
 		Texture* environmentCubemap = nullptr;
-		Texture* irradianceMap = nullptr;
 		Texture* radianceMap = nullptr;
+		// Diffuse lighting, see computeIrradianceSH
+		SphericalHarmonics irradianceSH;
 	};
 
 }
@@ -0,0 +1,601 @@
+#include "frame_graph.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <sstream>
+
+#include "xenon/core/log.h"
+#include "xenon/core/assert.h"
+#include "xenon/core/filesystem.h"
+#include "xenon/graphics/gl_state.h"
+#include "xenon/graphics/gpu_profiler.h"
+
+namespace xe {
+
+	//----------------------------------------
+	// SECTION: Frame graph
+	//----------------------------------------
+
+	FrameGraph* createFrameGraph(RenderTargetPool* pool) {
+		FrameGraph* graph = new FrameGraph();
+		graph->pool = pool;
+		return graph;
+	}
+
+	void destroyFrameGraph(FrameGraph* graph) {
+		for (FrameGraphBuffer& buffer : graph->buffers) {
+			glDeleteBuffers(1, &buffer.bufferID);
+		}
+		for (auto& [name, framebuffer] : graph->passFramebuffers) {
+			forgetGLFramebuffer(framebuffer.framebufferID);
+			glDeleteFramebuffers(1, &framebuffer.framebufferID);
+		}
+		delete graph;
+	}
+
+
+	//----------------------------------------
+	// SECTION: Frame graph declaration
+	//----------------------------------------
+
+	void resetFrameGraph(FrameGraph* graph) {
+		graph->resources.clear();
+		graph->versions.clear();
+		graph->passes.clear();
+		graph->order.clear();
+		graph->compiled = false;
+	}
+
+	FrameGraphResource addResource(FrameGraph* graph, FrameGraphResourceNode&& node) {
+		graph->resources.push_back(std::move(node));
+		FrameGraphVersion version;
+		version.resource = (uint32_t)graph->resources.size() - 1;
+		graph->versions.push_back(version);
+		return (FrameGraphResource)graph->versions.size() - 1;
+	}
+
+	FrameGraphResource importFramebuffer(FrameGraph* graph, const std::string& name, Framebuffer* framebuffer) {
+		FrameGraphResourceNode node;
+		node.name = name;
+		node.type = FrameGraphResourceType::FRAMEBUFFER;
+		node.imported = true;
+		node.framebuffer = framebuffer;
+		return addResource(graph, std::move(node));
+	}
+
+	FrameGraphResource importTexture(FrameGraph* graph, const std::string& name, Texture* texture) {
+		FrameGraphResourceNode node;
+		node.name = name;
+		node.type = FrameGraphResourceType::TEXTURE;
+		node.imported = true;
+		node.texture = texture;
+		node.textureDesc = FrameGraphTextureDesc{ (GLuint)texture->width, (GLuint)texture->height, texture->format, 1, texture->params };
+		return addResource(graph, std::move(node));
+	}
+
+	FrameGraphResource importBuffer(FrameGraph* graph, const std::string& name, GLuint buffer, size_t size) {
+		FrameGraphResourceNode node;
+		node.name = name;
+		node.type = FrameGraphResourceType::BUFFER;
+		node.imported = true;
+		node.buffer = buffer;
+		node.bufferSize = size;
+		return addResource(graph, std::move(node));
+	}
+
+	FrameGraphResource createTransientTexture(FrameGraph* graph, const std::string& name, const FrameGraphTextureDesc& desc) {
+		FrameGraphResourceNode node;
+		node.name = name;
+		node.type = FrameGraphResourceType::TEXTURE;
+		node.textureDesc = desc;
+		return addResource(graph, std::move(node));
+	}
+
+	FrameGraphResource createTransientBuffer(FrameGraph* graph, const std::string& name, size_t size) {
+		FrameGraphResourceNode node;
+		node.name = name;
+		node.type = FrameGraphResourceType::BUFFER;
+		node.bufferSize = size;
+		return addResource(graph, std::move(node));
+	}
+
+	uint32_t addFrameGraphPass(FrameGraph* graph, const std::string& name, FrameGraphExecute execute, bool sideEffect) {
+		FrameGraphPass pass;
+		pass.name = name;
+		pass.execute = std::move(execute);
+		pass.sideEffect = sideEffect;
+		graph->passes.push_back(std::move(pass));
+		graph->compiled = false;
+		return (uint32_t)graph->passes.size() - 1;
+	}
+
+	void readResource(FrameGraph* graph, uint32_t pass, FrameGraphResource resource, FrameGraphAccess access) {
+		XE_ASSERT(pass < graph->passes.size() && resource < graph->versions.size());
+		graph->passes[pass].reads.push_back(FrameGraphAccessDecl{ resource, access });
+		graph->versions[resource].readers.push_back(pass);
+	}
+
+	FrameGraphResource writeResource(FrameGraph* graph, uint32_t pass, FrameGraphResource resource, FrameGraphAccess access, GLenum attachment) {
+		XE_ASSERT(pass < graph->passes.size() && resource < graph->versions.size());
+		FrameGraphResourceNode& node = graph->resources[graph->versions[resource].resource];
+		if (graph->versions[resource].version != node.versions - 1) {
+			XE_LOG_ERROR_F("FRAME GRAPH: Pass {} writes an outdated version of {}", graph->passes[pass].name, node.name);
+		}
+
+		graph->passes[pass].writes.push_back(FrameGraphAccessDecl{ resource, access, attachment });
+
+		FrameGraphVersion version;
+		version.resource = graph->versions[resource].resource;
+		version.version = node.versions++;
+		version.producer = pass;
+		graph->versions.push_back(version);
+		return (FrameGraphResource)graph->versions.size() - 1;
+	}
+
+
+	//----------------------------------------
+	// SECTION: Frame graph functions
+	//----------------------------------------
+
+	GLbitfield getAccessBarrier(FrameGraphAccess access) {
+		switch (access) {
+		case FrameGraphAccess::ATTACHMENT:		return GL_FRAMEBUFFER_BARRIER_BIT;
+		case FrameGraphAccess::SAMPLED:			return GL_TEXTURE_FETCH_BARRIER_BIT;
+		case FrameGraphAccess::IMAGE:			return GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+		case FrameGraphAccess::STORAGE_BUFFER:	return GL_SHADER_STORAGE_BARRIER_BIT;
+		case FrameGraphAccess::UNIFORM_BUFFER:	return GL_UNIFORM_BARRIER_BIT;
+		case FrameGraphAccess::TRANSFER:		return GL_TEXTURE_UPDATE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT | GL_PIXEL_BUFFER_BARRIER_BIT;
+		case FrameGraphAccess::INDIRECT:		return GL_COMMAND_BARRIER_BIT;
+		}
+		return GL_ALL_BARRIER_BITS;
+	}
+
+	// Writes GL does not synchronize with later commands by itself
+	bool isIncoherentAccess(FrameGraphAccess access) {
+		return access == FrameGraphAccess::IMAGE || access == FrameGraphAccess::STORAGE_BUFFER;
+	}
+
+	void cullPasses(FrameGraph* graph) {
+		std::vector<uint32_t> stack;
+		for (uint32_t p = 0; p < graph->passes.size(); ++p) {
+			FrameGraphPass& pass = graph->passes[p];
+			pass.culled = true;
+
+			bool output = pass.sideEffect;
+			for (const FrameGraphAccessDecl& write : pass.writes) {
+				output |= graph->resources[graph->versions[write.handle].resource].imported;
+			}
+			if (output) {
+				pass.culled = false;
+				stack.push_back(p);
+			}
+		}
+
+		// Producers of everything a kept pass reads or overwrites are kept as well
+		while (!stack.empty()) {
+			uint32_t p = stack.back();
+			stack.pop_back();
+
+			for (const auto* decls : { &graph->passes[p].reads, &graph->passes[p].writes }) {
+				for (const FrameGraphAccessDecl& decl : *decls) {
+					uint32_t producer = graph->versions[decl.handle].producer;
+					if (producer != XE_FRAME_GRAPH_INVALID && graph->passes[producer].culled) {
+						graph->passes[producer].culled = false;
+						stack.push_back(producer);
+					}
+				}
+			}
+		}
+	}
+
+	bool sortPasses(FrameGraph* graph) {
+		size_t passCount = graph->passes.size();
+		std::vector<std::vector<uint32_t>> edges(passCount);
+		std::vector<uint32_t> inDegree(passCount, 0);
+
+		auto addEdge = [&](uint32_t from, uint32_t to) {
+			if (from == XE_FRAME_GRAPH_INVALID || from == to || graph->passes[from].culled) {
+				return;
+			}
+			edges[from].push_back(to);
+			++inDegree[to];
+		};
+
+		size_t keptCount = 0;
+		for (uint32_t p = 0; p < passCount; ++p) {
+			const FrameGraphPass& pass = graph->passes[p];
+			if (pass.culled) {
+				continue;
+			}
+			++keptCount;
+
+			// Read after write
+			for (const FrameGraphAccessDecl& read : pass.reads) {
+				addEdge(graph->versions[read.handle].producer, p);
+			}
+			// Write after write and write after read of the overwritten version
+			for (const FrameGraphAccessDecl& write : pass.writes) {
+				const FrameGraphVersion& version = graph->versions[write.handle];
+				addEdge(version.producer, p);
+				for (uint32_t reader : version.readers) {
+					addEdge(reader, p);
+				}
+			}
+		}
+
+		// Kahn's algorithm, the lowest declaration index first keeps the declared order where possible
+		std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t>> ready;
+		for (uint32_t p = 0; p < passCount; ++p) {
+			if (!graph->passes[p].culled && inDegree[p] == 0) {
+				ready.push(p);
+			}
+		}
+
+		graph->order.clear();
+		while (!ready.empty()) {
+			uint32_t p = ready.top();
+			ready.pop();
+			graph->order.push_back(p);
+			for (uint32_t next : edges[p]) {
+				if (--inDegree[next] == 0) {
+					ready.push(next);
+				}
+			}
+		}
+
+		if (graph->order.size() != keptCount) {
+			XE_LOG_ERROR("FRAME GRAPH: Passes have cyclic dependencies");
+			return false;
+		}
+		return true;
+	}
+
+	void computeLifetimesAndBarriers(FrameGraph* graph) {
+		for (FrameGraphResourceNode& node : graph->resources) {
+			node.firstUse = XE_FRAME_GRAPH_INVALID;
+			node.lastUse = XE_FRAME_GRAPH_INVALID;
+		}
+
+		// Barrier bits each resource still needs since its last incoherent write
+		std::vector<GLbitfield> pending(graph->resources.size(), 0);
+
+		for (uint32_t position = 0; position < graph->order.size(); ++position) {
+			FrameGraphPass& pass = graph->passes[graph->order[position]];
+
+			GLbitfield barriers = 0;
+			for (const auto* decls : { &pass.reads, &pass.writes }) {
+				for (const FrameGraphAccessDecl& decl : *decls) {
+					uint32_t resource = graph->versions[decl.handle].resource;
+					FrameGraphResourceNode& node = graph->resources[resource];
+					if (node.firstUse == XE_FRAME_GRAPH_INVALID) {
+						node.firstUse = position;
+					}
+					node.lastUse = position;
+
+					barriers |= pending[resource] & getAccessBarrier(decl.access);
+				}
+			}
+
+			for (const FrameGraphAccessDecl& read : pass.reads) {
+				const FrameGraphVersion& version = graph->versions[read.handle];
+				const FrameGraphResourceNode& node = graph->resources[version.resource];
+				if (!node.imported && version.producer == XE_FRAME_GRAPH_INVALID) {
+					XE_LOG_WARN_F("FRAME GRAPH: Pass {} reads transient {} before anything was written to it", pass.name, node.name);
+				}
+			}
+
+			// A barrier is global, it covers every resource with that kind of access
+			pass.barriers = barriers;
+			for (GLbitfield& bits : pending) {
+				bits &= ~barriers;
+			}
+			for (const FrameGraphAccessDecl& write : pass.writes) {
+				if (isIncoherentAccess(write.access)) {
+					pending[graph->versions[write.handle].resource] = GL_ALL_BARRIER_BITS;
+				}
+			}
+		}
+	}
+
+	bool compileFrameGraph(FrameGraph* graph) {
+		graph->compiled = false;
+		cullPasses(graph);
+		if (!sortPasses(graph)) {
+			return false;
+		}
+		computeLifetimesAndBarriers(graph);
+		graph->compiled = true;
+		return true;
+	}
+
+	void allocateTransient(FrameGraph* graph, FrameGraphResourceNode& node) {
+		if (node.type == FrameGraphResourceType::TEXTURE) {
+			const FrameGraphTextureDesc& desc = node.textureDesc;
+			if (graph->pool) {
+				node.texture = acquireRenderTarget(graph->pool, desc.width, desc.height, desc.format, desc.params, desc.samples);
+			}
+			else {
+				node.texture = createEmptyTexture(desc.width, desc.height, desc.format, desc.params, desc.samples);
+			}
+			node.allocatedID = node.texture->textureID;
+		}
+		else if (node.type == FrameGraphResourceType::BUFFER) {
+			// Smallest free buffer that fits
+			FrameGraphBuffer* best = nullptr;
+			for (FrameGraphBuffer& buffer : graph->buffers) {
+				if (!buffer.inUse && buffer.size >= node.bufferSize && (!best || buffer.size < best->size)) {
+					best = &buffer;
+				}
+			}
+			if (!best) {
+				FrameGraphBuffer buffer;
+				buffer.size = node.bufferSize;
+				glCreateBuffers(1, &buffer.bufferID);
+				glNamedBufferStorage(buffer.bufferID, buffer.size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+				graph->buffers.push_back(buffer);
+				best = &graph->buffers.back();
+			}
+			best->inUse = true;
+			best->lastUsedFrame = graph->frame;
+			node.buffer = best->bufferID;
+			node.allocatedID = best->bufferID;
+		}
+	}
+
+	void releaseTransient(FrameGraph* graph, FrameGraphResourceNode& node) {
+		if (node.type == FrameGraphResourceType::TEXTURE && node.texture) {
+			if (graph->pool) {
+				releaseRenderTarget(graph->pool, node.texture);
+			}
+			else {
+				forgetGLTexture(node.texture->textureID);
+				glDeleteTextures(1, &node.texture->textureID);
+				delete node.texture;
+			}
+			node.texture = nullptr;
+		}
+		else if (node.type == FrameGraphResourceType::BUFFER && node.buffer) {
+			for (FrameGraphBuffer& buffer : graph->buffers) {
+				if (buffer.bufferID == node.buffer) {
+					buffer.inUse = false;
+				}
+			}
+			node.buffer = 0;
+		}
+	}
+
+	void bindPassFramebuffer(FrameGraph* graph, const FrameGraphPass& pass) {
+		std::vector<std::pair<GLenum, GLuint>> attachments;
+		GLuint width = 0, height = 0;
+		for (const FrameGraphAccessDecl& write : pass.writes) {
+			const FrameGraphResourceNode& node = graph->resources[graph->versions[write.handle].resource];
+			if (write.access == FrameGraphAccess::ATTACHMENT && node.type == FrameGraphResourceType::TEXTURE && write.attachment != GL_NONE) {
+				attachments.push_back({ write.attachment, node.texture->textureID });
+				width = node.textureDesc.width;
+				height = node.textureDesc.height;
+			}
+		}
+		if (attachments.empty()) {
+			return;
+		}
+
+		FrameGraphPassFramebuffer& framebuffer = graph->passFramebuffers[pass.name];
+		if (framebuffer.attachments != attachments) {
+			if (framebuffer.framebufferID) {
+				forgetGLFramebuffer(framebuffer.framebufferID);
+				glDeleteFramebuffers(1, &framebuffer.framebufferID);
+			}
+			glCreateFramebuffers(1, &framebuffer.framebufferID);
+
+			// Draw buffer N is GL_COLOR_ATTACHMENTN, same as buildFramebuffer
+			std::vector<GLenum> drawBuffers;
+			for (const auto& [point, texture] : attachments) {
+				glNamedFramebufferTexture(framebuffer.framebufferID, point, texture, 0);
+				if (point != GL_DEPTH_ATTACHMENT && point != GL_STENCIL_ATTACHMENT) {
+					size_t index = point - GL_COLOR_ATTACHMENT0;
+					if (drawBuffers.size() <= index) {
+						drawBuffers.resize(index + 1, GL_NONE);
+					}
+					drawBuffers[index] = point;
+				}
+			}
+			glNamedFramebufferDrawBuffers(framebuffer.framebufferID, (GLsizei)drawBuffers.size(), drawBuffers.data());
+			if (glCheckNamedFramebufferStatus(framebuffer.framebufferID, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+				XE_LOG_ERROR_F("FRAME GRAPH: Framebuffer of pass {} is incomplete", pass.name);
+			}
+			framebuffer.attachments = attachments;
+		}
+
+		bindGLFramebuffer(GL_FRAMEBUFFER, framebuffer.framebufferID);
+		glViewport(0, 0, width, height);
+	}
+
+	void executeFrameGraph(FrameGraph* graph) {
+		if (!graph->compiled) {
+			XE_LOG_ERROR("FRAME GRAPH: Executing a graph that was not compiled");
+			return;
+		}
+		++graph->frame;
+
+		for (uint32_t position = 0; position < graph->order.size(); ++position) {
+			const FrameGraphPass& pass = graph->passes[graph->order[position]];
+
+			for (FrameGraphResourceNode& node : graph->resources) {
+				if (!node.imported && node.firstUse == position) {
+					allocateTransient(graph, node);
+				}
+			}
+
+			XE_GPU_SCOPE(pass.name.c_str());
+			bindPassFramebuffer(graph, pass);
+			if (pass.barriers) {
+				glMemoryBarrier(pass.barriers);
+			}
+			if (pass.execute) {
+				pass.execute(*graph, pass);
+			}
+
+			for (FrameGraphResourceNode& node : graph->resources) {
+				if (!node.imported && node.lastUse == position) {
+					releaseTransient(graph, node);
+				}
+			}
+		}
+
+		// Evict transient buffers that were not needed for a while
+		for (size_t i = 0; i < graph->buffers.size();) {
+			FrameGraphBuffer& buffer = graph->buffers[i];
+			if (!buffer.inUse && graph->frame - buffer.lastUsedFrame > XE_FRAME_GRAPH_BUFFER_IDLE_FRAMES) {
+				glDeleteBuffers(1, &buffer.bufferID);
+				graph->buffers[i] = graph->buffers.back();
+				graph->buffers.pop_back();
+				continue;
+			}
+			++i;
+		}
+	}
+
+	Texture* getFrameGraphTexture(const FrameGraph& graph, FrameGraphResource resource) {
+		return graph.resources[graph.versions[resource].resource].texture;
+	}
+
+	GLuint getFrameGraphBuffer(const FrameGraph& graph, FrameGraphResource resource) {
+		return graph.resources[graph.versions[resource].resource].buffer;
+	}
+
+	Framebuffer* getFrameGraphFramebuffer(const FrameGraph& graph, FrameGraphResource resource) {
+		return graph.resources[graph.versions[resource].resource].framebuffer;
+	}
+
+
+	//----------------------------------------
+	// SECTION: Frame graph dump
+	//----------------------------------------
+
+	const char* getAccessName(FrameGraphAccess access) {
+		switch (access) {
+		case FrameGraphAccess::ATTACHMENT:		return "attachment";
+		case FrameGraphAccess::SAMPLED:			return "sampled";
+		case FrameGraphAccess::IMAGE:			return "image";
+		case FrameGraphAccess::STORAGE_BUFFER:	return "storage buffer";
+		case FrameGraphAccess::UNIFORM_BUFFER:	return "uniform buffer";
+		case FrameGraphAccess::TRANSFER:		return "transfer";
+		case FrameGraphAccess::INDIRECT:		return "indirect";
+		}
+		return "unknown";
+	}
+
+	const char* getResourceTypeName(FrameGraphResourceType type) {
+		switch (type) {
+		case FrameGraphResourceType::TEXTURE:		return "texture";
+		case FrameGraphResourceType::BUFFER:		return "buffer";
+		case FrameGraphResourceType::FRAMEBUFFER:	return "framebuffer";
+		}
+		return "unknown";
+	}
+
+	std::string getVersionName(const FrameGraph& graph, FrameGraphResource handle) {
+		const FrameGraphVersion& version = graph.versions[handle];
+		return graph.resources[version.resource].name + " v" + std::to_string(version.version);
+	}
+
+	std::string dumpFrameGraph(const FrameGraph& graph) {
+		std::ostringstream out;
+		size_t culled = graph.passes.size() - graph.order.size();
+		out << "Frame graph: " << graph.passes.size() << " passes (" << culled << " culled), " << graph.resources.size() << " resources\n";
+		if (!graph.compiled) {
+			out << "Not compiled\n";
+			return out.str();
+		}
+
+		out << "\nExecution order:\n";
+		for (uint32_t position = 0; position < graph.order.size(); ++position) {
+			const FrameGraphPass& pass = graph.passes[graph.order[position]];
+			out << "  " << position << ". " << pass.name;
+			if (pass.sideEffect) {
+				out << " [side effect]";
+			}
+			if (pass.barriers) {
+				out << " [barrier 0x" << std::hex << pass.barriers << std::dec << "]";
+			}
+			out << "\n";
+			for (const FrameGraphAccessDecl& read : pass.reads) {
+				out << "       read  " << getVersionName(graph, read.handle) << " (" << getAccessName(read.access) << ")\n";
+			}
+			for (const FrameGraphAccessDecl& write : pass.writes) {
+				const FrameGraphVersion& version = graph.versions[write.handle];
+				out << "       write " << graph.resources[version.resource].name << " v" << version.version + 1 << " (" << getAccessName(write.access) << ")\n";
+			}
+		}
+
+		if (culled > 0) {
+			out << "\nCulled:\n";
+			for (const FrameGraphPass& pass : graph.passes) {
+				if (pass.culled) {
+					out << "  " << pass.name << "\n";
+				}
+			}
+		}
+
+		out << "\nResources:\n";
+		for (const FrameGraphResourceNode& node : graph.resources) {
+			out << "  " << node.name << ": " << getResourceTypeName(node.type) << (node.imported ? ", imported" : ", transient");
+			if (node.type == FrameGraphResourceType::TEXTURE) {
+				out << ", " << node.textureDesc.width << "x" << node.textureDesc.height << " format " << (int)node.textureDesc.format << " samples " << node.textureDesc.samples;
+			}
+			else if (node.type == FrameGraphResourceType::BUFFER) {
+				out << ", " << node.bufferSize << " bytes";
+			}
+			if (node.firstUse == XE_FRAME_GRAPH_INVALID) {
+				out << ", unused\n";
+				continue;
+			}
+			out << ", passes " << node.firstUse << "-" << node.lastUse;
+
+			if (!node.imported && node.allocatedID != 0) {
+				out << ", GL name " << node.allocatedID;
+				// Other transients that got the same texture or buffer
+				for (const FrameGraphResourceNode& other : graph.resources) {
+					if (&other != &node && !other.imported && other.type == node.type && other.allocatedID == node.allocatedID) {
+						out << " (aliased with " << other.name << ")";
+					}
+				}
+			}
+			out << "\n";
+		}
+		return out.str();
+	}
+
+	bool writeFrameGraphDot(const FrameGraph& graph, const std::string& path) {
+		std::ostringstream out;
+		out << "digraph FrameGraph {\n";
+		out << "\trankdir=LR;\n";
+
+		for (uint32_t p = 0; p < graph.passes.size(); ++p) {
+			const FrameGraphPass& pass = graph.passes[p];
+			out << "\tpass" << p << " [shape=box, label=\"" << pass.name << "\"" << (pass.culled ? ", style=dashed" : ", style=filled, fillcolor=lightblue") << "];\n";
+		}
+		for (uint32_t v = 0; v < graph.versions.size(); ++v) {
+			const FrameGraphResourceNode& node = graph.resources[graph.versions[v].resource];
+			out << "\tresource" << v << " [shape=ellipse, label=\"" << getVersionName(graph, v) << "\"" << (node.imported ? ", style=bold" : "") << "];\n";
+		}
+
+		for (uint32_t p = 0; p < graph.passes.size(); ++p) {
+			const FrameGraphPass& pass = graph.passes[p];
+			for (const FrameGraphAccessDecl& read : pass.reads) {
+				out << "\tresource" << read.handle << " -> pass" << p << " [label=\"" << getAccessName(read.access) << "\"];\n";
+			}
+		}
+		for (uint32_t v = 0; v < graph.versions.size(); ++v) {
+			const FrameGraphVersion& version = graph.versions[v];
+			if (version.producer != XE_FRAME_GRAPH_INVALID) {
+				out << "\tpass" << version.producer << " -> resource" << v << ";\n";
+			}
+		}
+		out << "}\n";
+
+		return saveTextResource(path, out.str());
+	}
+
+}
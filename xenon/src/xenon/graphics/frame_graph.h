@@ -0,0 +1,192 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glad/gl.h>
+
+#include "xenon/graphics/framebuffer.h"
+#include "xenon/graphics/render_target_pool.h"
+#include "xenon/graphics/texture.h"
+
+namespace xe {
+
+	// Handle of one version of a frame graph resource, every write creates a new version
+	typedef uint32_t FrameGraphResource;
+
+	#define XE_FRAME_GRAPH_INVALID UINT32_MAX
+	// Transient buffers that are not used for this many frames are deleted
+	#define XE_FRAME_GRAPH_BUFFER_IDLE_FRAMES 120
+
+	//----------------------------------------
+	// SECTION: Frame graph
+	//----------------------------------------
+
+	/*
+		The frame is declared every frame as passes that read and write resources, then compiled and executed:
+
+		1. Culling: passes with side effects and passes writing imported resources are kept, together with every
+		   pass producing a resource version they read or overwrite. All other passes are culled.
+		2. Ordering: passes are sorted topologically (read after write, write after read, write after write),
+		   ties keep the declaration order.
+		3. Barriers: reads and writes after an incoherent write (image store, storage buffer) get the
+		   glMemoryBarrier bits of their access.
+		4. Aliasing: transient textures are acquired from the render target pool right before their first pass
+		   and released after their last pass, so transients with the same description and disjoint lifetimes
+		   share one texture. Transient buffers are aliased the same way by size.
+
+		Imported resources (framebuffers, textures, buffers owned by someone else) are never allocated or aliased.
+	*/
+
+	enum class FrameGraphResourceType : uint8_t {
+		TEXTURE		= 0,
+		BUFFER		= 1,
+		FRAMEBUFFER	= 2
+	};
+
+	enum class FrameGraphAccess : uint8_t {
+		ATTACHMENT		= 0,	// Rendered to, cleared or blitted as a framebuffer attachment
+		SAMPLED			= 1,	// Read through a sampler
+		IMAGE			= 2,	// Image load/store (incoherent)
+		STORAGE_BUFFER	= 3,	// Shader storage (incoherent)
+		UNIFORM_BUFFER	= 4,
+		TRANSFER		= 5,	// Copies, uploads and readbacks
+		INDIRECT		= 6		// Indirect draw or dispatch arguments
+	};
+
+	struct FrameGraphTextureDesc {
+		GLuint width = 0, height = 0;
+		TextureFormat format = TextureFormat::RGBA;
+		int samples = 1;
+		TextureParameters params = TextureParameters{ GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE };
+	};
+
+	struct FrameGraphResourceNode {
+		std::string name;
+		FrameGraphResourceType type = FrameGraphResourceType::TEXTURE;
+		bool imported = false;
+
+		FrameGraphTextureDesc textureDesc;
+		size_t bufferSize = 0;
+
+		Texture* texture = nullptr;
+		GLuint buffer = 0;
+		Framebuffer* framebuffer = nullptr;
+
+		uint32_t versions = 1;
+
+		// Compiled, positions in the execution order
+		uint32_t firstUse = XE_FRAME_GRAPH_INVALID;
+		uint32_t lastUse = XE_FRAME_GRAPH_INVALID;
+		// Executed, GL name the transient resource got (for the dump, the resource itself is released)
+		GLuint allocatedID = 0;
+	};
+
+	struct FrameGraphVersion {
+		uint32_t resource = 0;
+		uint32_t version = 0;
+		uint32_t producer = XE_FRAME_GRAPH_INVALID;
+		std::vector<uint32_t> readers;
+	};
+
+	struct FrameGraphAccessDecl {
+		FrameGraphResource handle = XE_FRAME_GRAPH_INVALID;	// For writes the version that is overwritten
+		FrameGraphAccess access = FrameGraphAccess::SAMPLED;
+		GLenum attachment = GL_NONE;						// Attachment point of transient textures
+	};
+
+	struct FrameGraph;
+	struct FrameGraphPass;
+	typedef std::function<void(const FrameGraph& graph, const FrameGraphPass& pass)> FrameGraphExecute;
+
+	struct FrameGraphPass {
+		std::string name;
+		FrameGraphExecute execute;
+		bool sideEffect = false;
+
+		std::vector<FrameGraphAccessDecl> reads;
+		std::vector<FrameGraphAccessDecl> writes;
+
+		// Compiled
+		bool culled = false;
+		GLbitfield barriers = 0;
+	};
+
+	// Framebuffer for the transient attachments of one pass, recreated when the attached textures change
+	struct FrameGraphPassFramebuffer {
+		GLuint framebufferID = 0;
+		std::vector<std::pair<GLenum, GLuint>> attachments;
+	};
+
+	struct FrameGraphBuffer {
+		GLuint bufferID = 0;
+		size_t size = 0;
+		bool inUse = false;
+		uint64_t lastUsedFrame = 0;
+	};
+
+	struct FrameGraph {
+		RenderTargetPool* pool = nullptr;
+
+		// Declared
+		std::vector<FrameGraphResourceNode> resources;
+		std::vector<FrameGraphVersion> versions;
+		std::vector<FrameGraphPass> passes;
+
+		// Compiled
+		std::vector<uint32_t> order;
+		bool compiled = false;
+
+		// Persistent between frames
+		uint64_t frame = 0;
+		std::vector<FrameGraphBuffer> buffers;
+		std::unordered_map<std::string, FrameGraphPassFramebuffer> passFramebuffers;	// By pass name
+	};
+
+	FrameGraph* createFrameGraph(RenderTargetPool* pool);
+	void destroyFrameGraph(FrameGraph* graph);
+
+
+	//----------------------------------------
+	// SECTION: Frame graph declaration
+	//----------------------------------------
+
+	// Clears the passes and resources of the previous frame
+	void resetFrameGraph(FrameGraph* graph);
+
+	FrameGraphResource importFramebuffer(FrameGraph* graph, const std::string& name, Framebuffer* framebuffer);
+	FrameGraphResource importTexture(FrameGraph* graph, const std::string& name, Texture* texture);
+	FrameGraphResource importBuffer(FrameGraph* graph, const std::string& name, GLuint buffer, size_t size);
+	FrameGraphResource createTransientTexture(FrameGraph* graph, const std::string& name, const FrameGraphTextureDesc& desc);
+	FrameGraphResource createTransientBuffer(FrameGraph* graph, const std::string& name, size_t size);
+
+	// Side effect passes (readbacks, presenting, state for later frames) are never culled
+	uint32_t addFrameGraphPass(FrameGraph* graph, const std::string& name, FrameGraphExecute execute, bool sideEffect = false);
+	void readResource(FrameGraph* graph, uint32_t pass, FrameGraphResource resource, FrameGraphAccess access);
+	// Returns the new version, later passes have to use it to see the written data. Transient textures written
+	// as ATTACHMENT are attached at the attachment point to a framebuffer that is bound before the pass executes.
+	FrameGraphResource writeResource(FrameGraph* graph, uint32_t pass, FrameGraphResource resource, FrameGraphAccess access, GLenum attachment = GL_NONE);
+
+
+	//----------------------------------------
+	// SECTION: Frame graph functions
+	//----------------------------------------
+
+	bool compileFrameGraph(FrameGraph* graph);
+	void executeFrameGraph(FrameGraph* graph);
+
+	// Valid while the pass using the resource executes
+	Texture* getFrameGraphTexture(const FrameGraph& graph, FrameGraphResource resource);
+	GLuint getFrameGraphBuffer(const FrameGraph& graph, FrameGraphResource resource);
+	Framebuffer* getFrameGraphFramebuffer(const FrameGraph& graph, FrameGraphResource resource);
+
+	// Human readable description of the compiled graph: execution order, culled passes, barriers, lifetimes
+	// and aliasing of transient resources
+	std::string dumpFrameGraph(const FrameGraph& graph);
+	// Graphviz version of the compiled graph
+	bool writeFrameGraphDot(const FrameGraph& graph, const std::string& path);
+
+}
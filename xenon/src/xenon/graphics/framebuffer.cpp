@@ -1,30 +1,52 @@
 #include "framebuffer.h"
 
+#include <algorithm>
+
+#include <glm/glm.hpp>
+#include <stb_image_write.h>
+
 #include "xenon/core/log.h"
 #include "xenon/core/assert.h"
+#include "xenon/graphics/gl_state.h"
+#include "xenon/graphics/render_stats.h"
 
 namespace xe {
 
-	Framebuffer* createFramebuffer(unsigned int width, unsigned int height, int samples) {
+	Framebuffer* createFramebuffer(unsigned int width, unsigned int height, int samples, RenderTargetPool* pool) {
 		Framebuffer* framebuffer = new Framebuffer{ width, height, samples };
+		framebuffer->pool = pool;
 		glCreateFramebuffers(1, &framebuffer->frambufferID);
 		return framebuffer;
 	}
 
-	void destroyFramebufferInternals(Framebuffer* framebuffer) {
-		glDeleteFramebuffers(1, &framebuffer->frambufferID);
-		framebuffer->frambufferID = 0;
+	void releaseAttachmentTexture(Framebuffer* framebuffer, FramebufferAttachment& attachment) {
+		if (!attachment.texture) {
+			return;
+		}
+		glNamedFramebufferTexture(framebuffer->frambufferID, attachment.target, 0, 0);
+		if (framebuffer->pool) {
+			releaseRenderTarget(framebuffer->pool, attachment.texture);
+		}
+		else {
+			forgetGLTexture(attachment.texture->textureID);
+			glDeleteTextures(1, &attachment.texture->textureID);
+			delete attachment.texture;
+		}
+		attachment.texture = nullptr;
+	}
 
+	void releaseFramebufferTextures(Framebuffer* framebuffer) {
 		for (auto& [target, attachment] : framebuffer->attachments) {
-			if (attachment.texture) {
-				glDeleteTextures(1, &attachment.texture->textureID);
-				attachment.texture = nullptr;
-			}
+			releaseAttachmentTexture(framebuffer, attachment);
 		}
+		framebuffer->textureWidth = 0;
+		framebuffer->textureHeight = 0;
 	}
 
 	void destroyFramebuffer(Framebuffer* framebuffer) {
-		destroyFramebufferInternals(framebuffer);
+		releaseFramebufferTextures(framebuffer);
+		forgetGLFramebuffer(framebuffer->frambufferID);
+		glDeleteFramebuffers(1, &framebuffer->frambufferID);
 		delete framebuffer;
 	}
 
@@ -37,20 +59,33 @@ namespace xe {
 		}
 
 		if (framebuffer->status != FramebufferStatus::UNINITIALIZED) {
-			// TODO: Destroy previous textures
 			// TODO: Manage incomplete state
 			framebuffer->colorBuffers.clear();
 		}
 
 		for (auto& [target, attachment] : framebuffer->attachments) {
 			if (attachment.texture) {
-				XE_LOG_WARN_F("FRAMEBUFFER: Framebuffer texture already exists, overwriting framebuffer texture: {}", attachment.texture->textureID);
+				XE_LOG_WARN_F("FRAMEBUFFER: Framebuffer texture already exists, releasing framebuffer texture: {}", attachment.texture->textureID);
+				releaseAttachmentTexture(framebuffer, attachment);
+			}
+			if (framebuffer->pool) {
+				attachment.texture = acquireRenderTarget(framebuffer->pool, framebuffer->width, framebuffer->height, attachment.format, attachment.textureParams, framebuffer->samples);
+			}
+			else {
+				attachment.texture = createEmptyTexture(framebuffer->width, framebuffer->height, attachment.format, attachment.textureParams, framebuffer->samples);
 			}
-			attachment.texture = createEmptyTexture(framebuffer->width, framebuffer->height, attachment.format, attachment.textureParams, framebuffer->samples);
+			// All attachments of a size share a bucket, so they have the same size
+			framebuffer->textureWidth = attachment.texture->width;
+			framebuffer->textureHeight = attachment.texture->height;
 			glNamedFramebufferTexture(framebuffer->frambufferID, attachment.target, attachment.texture->textureID, 0);
 
+			// Draw buffer N is always GL_COLOR_ATTACHMENTN, fragment output locations match the attachment numbers
 			if (attachment.target != GL_DEPTH_ATTACHMENT && attachment.target != GL_STENCIL_ATTACHMENT) {
-				framebuffer->colorBuffers.push_back(attachment.target);
+				size_t index = attachment.target - GL_COLOR_ATTACHMENT0;
+				if (framebuffer->colorBuffers.size() <= index) {
+					framebuffer->colorBuffers.resize(index + 1, GL_NONE);
+				}
+				framebuffer->colorBuffers[index] = attachment.target;
 			}
 		}
 		if (framebuffer->colorBuffers.size()) {
@@ -60,6 +95,9 @@ namespace xe {
 			XE_LOG_DEBUG_F("FRAMEBUFFER: Framebuffer has no drawbuffers (depth only)");
 		}
 
+		framebuffer->viewportWidth = framebuffer->width;
+		framebuffer->viewportHeight = framebuffer->height;
+
 		GLenum status = glCheckNamedFramebufferStatus(framebuffer->frambufferID, GL_FRAMEBUFFER);
 		if (status == GL_FRAMEBUFFER_COMPLETE) {
 			framebuffer->status = FramebufferStatus::COMPLETE;
@@ -74,14 +112,16 @@ namespace xe {
 	}
 
 	void bindFramebuffer(const Framebuffer& framebuffer) {
-		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.frambufferID);
+		bindGLFramebuffer(GL_FRAMEBUFFER, framebuffer.frambufferID);
+		glViewport(0, 0, framebuffer.viewportWidth, framebuffer.viewportHeight);
 	}
 
 	void unbindFramebuffer() {
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		bindGLFramebuffer(GL_FRAMEBUFFER, 0);
 	}
 
 	void clearFramebuffer(const Framebuffer& framebuffer, const Shader& shader) {
+		// NOTE: glClear does not depend on the bound program, the shader is kept bound for the following scene pass
 		bindShader(shader);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		
@@ -90,31 +130,67 @@ namespace xe {
 		glClearNamedFramebufferfv(framebuffer.frambufferID, GL_COLOR, 0, &zeroF);
 		glClearNamedFramebufferiv(framebuffer.frambufferID, GL_COLOR, 1, &zeroI);
 		glClearNamedFramebufferfv(framebuffer.frambufferID, GL_DEPTH, 0, &zeroF);*/
-		
-		unbindShader();
+	}
+
+	void rebuildFramebuffer(Framebuffer* framebuffer) {
+		releaseFramebufferTextures(framebuffer);
+		buildFramebuffer(framebuffer);
 	}
 
 	void updateFramebufferSize(Framebuffer* framebuffer, unsigned int width, unsigned int height) {
-		destroyFramebufferInternals(framebuffer);
+		// Pooled textures are allocated per size bucket, sizes within the bucket only change the viewport
+		bool sameBucket = framebuffer->pool && framebuffer->status == FramebufferStatus::COMPLETE
+			&& getRenderTargetBucketSize(width) == framebuffer->textureWidth
+			&& getRenderTargetBucketSize(height) == framebuffer->textureHeight;
+
 		framebuffer->width = width;
 		framebuffer->height = height;
-		glCreateFramebuffers(1, &framebuffer->frambufferID);
-		buildFramebuffer(framebuffer);
+		if (sameBucket) {
+			framebuffer->viewportWidth = width;
+			framebuffer->viewportHeight = height;
+		}
+		else {
+			rebuildFramebuffer(framebuffer);
+		}
 	}
 
-	void blitFramebuffers(Framebuffer* source, Framebuffer* target) {
+	void removeFramebufferAttachment(Framebuffer* framebuffer, GLenum target) {
+		auto attachment = framebuffer->attachments.find(target);
+		if (attachment == framebuffer->attachments.end()) {
+			return;
+		}
+		releaseAttachmentTexture(framebuffer, attachment->second);
+		framebuffer->attachments.erase(attachment);
+	}
+
+	void setFramebufferViewport(Framebuffer* framebuffer, unsigned int width, unsigned int height) {
+		framebuffer->viewportWidth = glm::clamp<GLuint>(width, 1, framebuffer->width);
+		framebuffer->viewportHeight = glm::clamp<GLuint>(height, 1, framebuffer->height);
+	}
+
+	void blitFramebuffers(Framebuffer* source, Framebuffer* target, GLenum colorFilter) {
 		for (const auto [attachmentTarget, attachment] : source->attachments) {
 			if (target->attachments.find(attachmentTarget) != target->attachments.end()) {
 				glNamedFramebufferReadBuffer(source->frambufferID, attachmentTarget);
 				glNamedFramebufferDrawBuffer(target->frambufferID, attachmentTarget);
-				GLbitfield filter = GL_COLOR_BUFFER_BIT;
+				GLbitfield mask = GL_COLOR_BUFFER_BIT;
+				GLenum filter = colorFilter;
 				if (attachmentTarget == GL_DEPTH_ATTACHMENT) {
-					filter = GL_DEPTH_ATTACHMENT;
+					mask = GL_DEPTH_BUFFER_BIT;
+					filter = GL_NEAREST;
 				}
 				else if(attachmentTarget == GL_STENCIL_ATTACHMENT) {
-					filter = GL_STENCIL_BUFFER_BIT;
+					mask = GL_STENCIL_BUFFER_BIT;
+					filter = GL_NEAREST;
+				}
+				else if (attachment.format == TextureFormat::RED_INTEGER) {
+					// Integer formats can not be filtered
+					filter = GL_NEAREST;
 				}
-				glBlitNamedFramebuffer(source->frambufferID, target->frambufferID, 0, 0, source->width, source->height, 0, 0, target->width, target->height, filter, GL_NEAREST);
+				glBlitNamedFramebuffer(source->frambufferID, target->frambufferID,
+					0, 0, source->viewportWidth, source->viewportHeight,
+					0, 0, target->viewportWidth, target->viewportHeight, mask, filter);
+				recordFramebufferBlit();
 			}
 		}
 		// Restore draw- and readbuffers
@@ -126,6 +202,75 @@ namespace xe {
 		}
 	}
 
+	bool saveFramebufferImage(const Framebuffer& framebuffer, const std::string& path, GLenum attachment) {
+		auto it = framebuffer.attachments.find(attachment);
+		if (it == framebuffer.attachments.end() || attachment == GL_DEPTH_ATTACHMENT || attachment == GL_STENCIL_ATTACHMENT || it->second.format == TextureFormat::RED_INTEGER) {
+			XE_LOG_ERROR_F("FRAMEBUFFER: Can not save attachment {:#x} as image, not a color attachment", attachment);
+			return false;
+		}
+
+		GLuint width = framebuffer.viewportWidth;
+		GLuint height = framebuffer.viewportHeight;
+		bool hdr = path.size() >= 4 && path.compare(path.size() - 4, 4, ".hdr") == 0;
+
+		// Multisampled attachments can not be read, resolve into a temporary renderbuffer
+		GLuint readFramebuffer = framebuffer.frambufferID;
+		GLuint resolveFramebuffer = 0, resolveRenderbuffer = 0;
+		if (framebuffer.samples > 1) {
+			glCreateRenderbuffers(1, &resolveRenderbuffer);
+			glNamedRenderbufferStorage(resolveRenderbuffer, hdr ? GL_RGBA32F : GL_RGBA8, width, height);
+			glCreateFramebuffers(1, &resolveFramebuffer);
+			glNamedFramebufferRenderbuffer(resolveFramebuffer, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, resolveRenderbuffer);
+
+			glNamedFramebufferReadBuffer(framebuffer.frambufferID, attachment);
+			glBlitNamedFramebuffer(framebuffer.frambufferID, resolveFramebuffer, 0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+			recordFramebufferBlit();
+			readFramebuffer = resolveFramebuffer;
+			attachment = GL_COLOR_ATTACHMENT0;
+		}
+
+		int channels = hdr ? 3 : 4;
+		size_t pixelSize = hdr ? channels * sizeof(float) : channels;
+		std::vector<unsigned char> pixels(width * height * pixelSize);
+
+		glNamedFramebufferReadBuffer(readFramebuffer, attachment);
+		bindGLFramebuffer(GL_READ_FRAMEBUFFER, readFramebuffer);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glReadPixels(0, 0, width, height, hdr ? GL_RGB : GL_RGBA, hdr ? GL_FLOAT : GL_UNSIGNED_BYTE, pixels.data());
+		bindGLFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+		if (resolveFramebuffer) {
+			forgetGLFramebuffer(resolveFramebuffer);
+			glDeleteFramebuffers(1, &resolveFramebuffer);
+			glDeleteRenderbuffers(1, &resolveRenderbuffer);
+		}
+		else if (framebuffer.colorBuffers.size() > 0) {
+			glNamedFramebufferReadBuffer(framebuffer.frambufferID, framebuffer.colorBuffers.at(0));
+		}
+
+		// GL rows start at the bottom, image rows at the top
+		size_t rowSize = width * pixelSize;
+		std::vector<unsigned char> row(rowSize);
+		for (GLuint y = 0; y < height / 2; ++y) {
+			unsigned char* top = pixels.data() + y * rowSize;
+			unsigned char* bottom = pixels.data() + (height - 1 - y) * rowSize;
+			std::copy(top, top + rowSize, row.data());
+			std::copy(bottom, bottom + rowSize, top);
+			std::copy(row.data(), row.data() + rowSize, bottom);
+		}
+
+		int result = hdr
+			? stbi_write_hdr(path.c_str(), width, height, channels, (const float*)pixels.data())
+			: stbi_write_png(path.c_str(), width, height, channels, pixels.data(), (int)rowSize);
+		if (!result) {
+			XE_LOG_ERROR_F("FRAMEBUFFER: Failed to write image: {}", path);
+			return false;
+		}
+		XE_LOG_TRACE_F("FRAMEBUFFER: Saved image: {}", path);
+		return true;
+	}
+
 
 	FramebufferAttachmentPair createDefaultFramebufferAttachment(DefaultAttachmentType type, GLuint target) {
 		if (type == DefaultAttachmentType::COLOR) {
@@ -136,7 +281,7 @@ namespace xe {
 			return { GL_DEPTH_ATTACHMENT, FramebufferAttachment{ GL_DEPTH_ATTACHMENT, TextureFormat::DEPTH, TextureParameters{ GL_NEAREST, GL_NEAREST } } };
 		}
 		else { // type == DefaultAttachmentType::INTEGER
-			return { GL_COLOR_ATTACHMENT0 + target, FramebufferAttachment{ GL_COLOR_ATTACHMENT0 + target, TextureFormat::RED, TextureParameters{ GL_NEAREST, GL_NEAREST } } };
+			return { GL_COLOR_ATTACHMENT0 + target, FramebufferAttachment{ GL_COLOR_ATTACHMENT0 + target, TextureFormat::RED_INTEGER, TextureParameters{ GL_NEAREST, GL_NEAREST } } };
 		}
 	}
 
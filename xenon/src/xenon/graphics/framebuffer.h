@@ -1,12 +1,14 @@
 #pragma once
 
 #include <map>
+#include <string>
 #include <vector>
 
 #include <glad/gl.h>
 
 #include "xenon/graphics/texture.h"
 #include "xenon/graphics/shader.h"
+#include "xenon/graphics/render_target_pool.h"
 
 namespace xe {
 
@@ -28,23 +30,41 @@ namespace xe {
 	struct Framebuffer {
 		GLuint width, height;
 		int samples;
+		// Textures are acquired from the pool when set, they can then be larger than the framebuffer
+		RenderTargetPool* pool = nullptr;
+		GLuint textureWidth = 0, textureHeight = 0;
 		GLuint frambufferID = 0;
 		FramebufferStatus status = FramebufferStatus::UNINITIALIZED;
 		std::map<GLenum, FramebufferAttachment> attachments;
 		std::vector<GLenum> colorBuffers;
+		// Region starting at the origin that is rendered to, at most width x height and smaller when rendering at
+		// a reduced resolution. Reset to the full size when the framebuffer is built or resized.
+		GLuint viewportWidth = 0, viewportHeight = 0;
 	};
 
-	Framebuffer* createFramebuffer(unsigned int width, unsigned int height, int samples = 1);
+	Framebuffer* createFramebuffer(unsigned int width, unsigned int height, int samples = 1, RenderTargetPool* pool = nullptr);
 	void destroyFramebuffer(Framebuffer* framebuffer);
 
 	bool buildFramebuffer(Framebuffer* framebuffer);
 
+	// Also sets the GL viewport to the viewport of the framebuffer
 	void bindFramebuffer(const Framebuffer& framebuffer);
 	void unbindFramebuffer();
 
 	void clearFramebuffer(const Framebuffer& framebuffer, const Shader& shader);
+	// Releases and recreates all attachment textures, needed after changing the samples or the attachments
+	void rebuildFramebuffer(Framebuffer* framebuffer);
+	// Also resets the viewport, pooled framebuffers keep their textures when the size stays in the same bucket
 	void updateFramebufferSize(Framebuffer* framebuffer, unsigned int width, unsigned int height);
-	void blitFramebuffers(Framebuffer* source, Framebuffer* target);
+	// Releases the texture of the attachment, the framebuffer has to be rebuilt (rebuildFramebuffer) afterwards
+	void removeFramebufferAttachment(Framebuffer* framebuffer, GLenum target);
+	// Changes the rendered region without reallocating, clamped to the size of the framebuffer
+	void setFramebufferViewport(Framebuffer* framebuffer, unsigned int width, unsigned int height);
+	// Blits the viewports of all attachments both framebuffers have, integer and depth attachments always use GL_NEAREST
+	void blitFramebuffers(Framebuffer* source, Framebuffer* target, GLenum colorFilter = GL_NEAREST);
+	// Writes the viewport of a color attachment to disk, as Radiance HDR when the path ends in .hdr and as PNG
+	// otherwise. Multisampled attachments are resolved first.
+	bool saveFramebufferImage(const Framebuffer& framebuffer, const std::string& path, GLenum attachment = GL_COLOR_ATTACHMENT0);
 
 	typedef enum class DefaultFramebufferAttachmentType {
 		COLOR,
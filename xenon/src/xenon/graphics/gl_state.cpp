@@ -0,0 +1,218 @@
+#include "gl_state.h"
+
+#include <array>
+
+namespace xe {
+
+	// Value used for state that has not been set through the cache (or has been invalidated)
+	#define XE_GL_STATE_UNKNOWN 0xFFFFFFFF
+
+	struct GLStateCache {
+		GLuint program = XE_GL_STATE_UNKNOWN;
+		GLuint vertexArray = XE_GL_STATE_UNKNOWN;
+		std::array<GLuint, XE_GL_STATE_TEXTURE_UNITS> textures;
+		GLuint drawFramebuffer = XE_GL_STATE_UNKNOWN;
+		GLuint readFramebuffer = XE_GL_STATE_UNKNOWN;
+
+		GLenum polygonModeFront = XE_GL_STATE_UNKNOWN;
+		GLenum polygonModeBack = XE_GL_STATE_UNKNOWN;
+
+		// -1 = unknown, 0 = disabled, 1 = enabled
+		int8_t blend = -1;
+		int8_t cullFace = -1;
+		int8_t depthTest = -1;
+		int8_t depthMask = -1;
+		int8_t colorMask = -1;
+
+		GLenum depthFunc = XE_GL_STATE_UNKNOWN;
+		GLenum blendSource = XE_GL_STATE_UNKNOWN;
+		GLenum blendDestination = XE_GL_STATE_UNKNOWN;
+
+		GLStateCache() { textures.fill(XE_GL_STATE_UNKNOWN); }
+	};
+
+	static GLStateCache s_state;
+	static GLStateCounters s_counters;
+
+	//----------------------------------------
+	// SECTION: State counters
+	//----------------------------------------
+
+	const GLStateCounters& getGLStateCounters() {
+		return s_counters;
+	}
+
+	void resetGLStateCounters() {
+		s_counters = GLStateCounters();
+	}
+
+
+	//----------------------------------------
+	// SECTION: State cache
+	//----------------------------------------
+
+	void invalidateGLState() {
+		s_state = GLStateCache();
+	}
+
+	void bindGLProgram(GLuint program) {
+		if (s_state.program == program) {
+			++s_counters.avoidedCalls;
+			return;
+		}
+		glUseProgram(program);
+		s_state.program = program;
+		++s_counters.programBinds;
+	}
+
+	void bindGLVertexArray(GLuint vao) {
+		if (s_state.vertexArray == vao) {
+			++s_counters.avoidedCalls;
+			return;
+		}
+		glBindVertexArray(vao);
+		s_state.vertexArray = vao;
+		++s_counters.vertexArrayBinds;
+	}
+
+	void bindGLTextureUnit(GLuint unit, GLuint texture) {
+		if (unit < XE_GL_STATE_TEXTURE_UNITS) {
+			if (s_state.textures[unit] == texture) {
+				++s_counters.avoidedCalls;
+				return;
+			}
+			s_state.textures[unit] = texture;
+		}
+		glBindTextureUnit(unit, texture);
+		++s_counters.textureBinds;
+	}
+
+	void bindGLFramebuffer(GLenum target, GLuint framebuffer) {
+		bool bindDraw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+		bool bindRead = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+
+		if ((!bindDraw || s_state.drawFramebuffer == framebuffer) && (!bindRead || s_state.readFramebuffer == framebuffer)) {
+			++s_counters.avoidedCalls;
+			return;
+		}
+		glBindFramebuffer(target, framebuffer);
+		if (bindDraw) s_state.drawFramebuffer = framebuffer;
+		if (bindRead) s_state.readFramebuffer = framebuffer;
+		++s_counters.framebufferBinds;
+	}
+
+	void setGLPolygonMode(GLenum face, GLenum mode) {
+		bool setFront = face == GL_FRONT_AND_BACK || face == GL_FRONT;
+		bool setBack = face == GL_FRONT_AND_BACK || face == GL_BACK;
+
+		if ((!setFront || s_state.polygonModeFront == mode) && (!setBack || s_state.polygonModeBack == mode)) {
+			++s_counters.avoidedCalls;
+			return;
+		}
+		glPolygonMode(face, mode);
+		if (setFront) s_state.polygonModeFront = mode;
+		if (setBack) s_state.polygonModeBack = mode;
+		++s_counters.stateChanges;
+	}
+
+	void setGLCapability(GLenum capability, bool enabled) {
+		int8_t* cached = nullptr;
+		if (capability == GL_BLEND) {
+			cached = &s_state.blend;
+		}
+		else if (capability == GL_CULL_FACE) {
+			cached = &s_state.cullFace;
+		}
+		else if (capability == GL_DEPTH_TEST) {
+			cached = &s_state.depthTest;
+		}
+
+		if (cached) {
+			if (*cached == (int8_t)enabled) {
+				++s_counters.avoidedCalls;
+				return;
+			}
+			*cached = (int8_t)enabled;
+		}
+
+		if (enabled) {
+			glEnable(capability);
+		}
+		else {
+			glDisable(capability);
+		}
+		++s_counters.stateChanges;
+	}
+
+	void setGLDepthFunc(GLenum func) {
+		if (s_state.depthFunc == func) {
+			++s_counters.avoidedCalls;
+			return;
+		}
+		glDepthFunc(func);
+		s_state.depthFunc = func;
+		++s_counters.stateChanges;
+	}
+
+	void setGLDepthMask(bool enabled) {
+		if (s_state.depthMask == (int8_t)enabled) {
+			++s_counters.avoidedCalls;
+			return;
+		}
+		glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+		s_state.depthMask = (int8_t)enabled;
+		++s_counters.stateChanges;
+	}
+
+	void setGLColorMask(bool enabled) {
+		if (s_state.colorMask == (int8_t)enabled) {
+			++s_counters.avoidedCalls;
+			return;
+		}
+		GLboolean value = enabled ? GL_TRUE : GL_FALSE;
+		glColorMask(value, value, value, value);
+		s_state.colorMask = (int8_t)enabled;
+		++s_counters.stateChanges;
+	}
+
+	void setGLBlendFunc(GLenum source, GLenum destination) {
+		if (s_state.blendSource == source && s_state.blendDestination == destination) {
+			++s_counters.avoidedCalls;
+			return;
+		}
+		glBlendFunc(source, destination);
+		s_state.blendSource = source;
+		s_state.blendDestination = destination;
+		++s_counters.stateChanges;
+	}
+
+	void forgetGLProgram(GLuint program) {
+		if (s_state.program == program) {
+			s_state.program = XE_GL_STATE_UNKNOWN;
+		}
+	}
+
+	void forgetGLVertexArray(GLuint vao) {
+		if (s_state.vertexArray == vao) {
+			s_state.vertexArray = XE_GL_STATE_UNKNOWN;
+		}
+	}
+
+	void forgetGLTexture(GLuint texture) {
+		for (GLuint& bound : s_state.textures) {
+			if (bound == texture) {
+				bound = XE_GL_STATE_UNKNOWN;
+			}
+		}
+	}
+
+	void forgetGLFramebuffer(GLuint framebuffer) {
+		if (s_state.drawFramebuffer == framebuffer) {
+			s_state.drawFramebuffer = XE_GL_STATE_UNKNOWN;
+		}
+		if (s_state.readFramebuffer == framebuffer) {
+			s_state.readFramebuffer = XE_GL_STATE_UNKNOWN;
+		}
+	}
+
+}
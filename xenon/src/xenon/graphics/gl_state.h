@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glad/gl.h>
+
+namespace xe {
+
+	// Number of texture units tracked by the state cache, units above this are always forwarded to GL
+	#define XE_GL_STATE_TEXTURE_UNITS 16
+
+	//----------------------------------------
+	// SECTION: State counters
+	//----------------------------------------
+
+	struct GLStateCounters {
+		// Calls forwarded to GL
+		uint32_t programBinds = 0;
+		uint32_t vertexArrayBinds = 0;
+		uint32_t textureBinds = 0;
+		uint32_t framebufferBinds = 0;
+		uint32_t stateChanges = 0;
+
+		// Calls filtered out because the state was already set
+		uint32_t avoidedCalls = 0;
+	};
+
+	const GLStateCounters& getGLStateCounters();
+	void resetGLStateCounters();
+
+
+	//----------------------------------------
+	// SECTION: State cache
+	//----------------------------------------
+
+	// NOTE: All state changes made by the engine should go through these functions. If some other code changes
+	// GL state behind the cache's back (ImGui, third party loaders), call invalidateGLState() afterwards.
+	void invalidateGLState();
+
+	void bindGLProgram(GLuint program);
+	void bindGLVertexArray(GLuint vao);
+	void bindGLTextureUnit(GLuint unit, GLuint texture);
+	void bindGLFramebuffer(GLenum target, GLuint framebuffer);
+
+	void setGLPolygonMode(GLenum face, GLenum mode);
+	void setGLCapability(GLenum capability, bool enabled);
+	void setGLDepthFunc(GLenum func);
+	void setGLDepthMask(bool enabled);
+	// Masks all color channels of all draw buffers
+	void setGLColorMask(bool enabled);
+	void setGLBlendFunc(GLenum source, GLenum destination);
+
+	// Should be called when a GL object is deleted, GL may reuse the name for a new object
+	void forgetGLProgram(GLuint program);
+	void forgetGLVertexArray(GLuint vao);
+	void forgetGLTexture(GLuint texture);
+	void forgetGLFramebuffer(GLuint framebuffer);
+
+}
@@ -0,0 +1,146 @@
+#include "gpu_profiler.h"
+
+#include "xenon/core/log.h"
+#include "xenon/core/assert.h"
+
+namespace xe {
+
+	static GPUProfiler* s_activeProfiler = nullptr;
+
+	//----------------------------------------
+	// SECTION: GPU profiler
+	//----------------------------------------
+
+	GPUProfiler* createGPUProfiler() {
+		GPUProfiler* profiler = new GPUProfiler();
+		for (GPUProfilerFrame& frame : profiler->frames) {
+			glCreateQueries(GL_TIMESTAMP, (GLsizei)frame.queries.size(), frame.queries.data());
+			frame.scopes.reserve(XE_GPU_PROFILER_MAX_SCOPES);
+		}
+		return profiler;
+	}
+
+	void destroyGPUProfiler(GPUProfiler* profiler) {
+		for (GPUProfilerFrame& frame : profiler->frames) {
+			glDeleteQueries((GLsizei)frame.queries.size(), frame.queries.data());
+		}
+		if (s_activeProfiler == profiler) {
+			s_activeProfiler = nullptr;
+		}
+		delete profiler;
+	}
+
+	void setActiveGPUProfiler(GPUProfiler* profiler) {
+		s_activeProfiler = profiler;
+	}
+
+	GPUProfiler* getActiveGPUProfiler() {
+		return s_activeProfiler;
+	}
+
+
+	//----------------------------------------
+	// SECTION: GPU profiler functions
+	//----------------------------------------
+
+	void readGPUProfilerFrame(GPUProfiler* profiler, GPUProfilerFrame& frame) {
+		GLint available = GL_FALSE;
+		glGetQueryObjectiv(frame.lastQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) {
+			++profiler->droppedFrames;
+			return;
+		}
+
+		profiler->results.clear();
+		for (size_t i = 0; i < frame.scopes.size(); ++i) {
+			GLuint64 begin = 0, end = 0;
+			glGetQueryObjectui64v(frame.queries[i * 2], GL_QUERY_RESULT, &begin);
+			glGetQueryObjectui64v(frame.queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+
+			GPUScopeResult result;
+			result.name = frame.scopes[i].name;
+			result.depth = frame.scopes[i].depth;
+			result.time = end > begin ? (end - begin) / 1000000.0f : 0.0f;
+
+			auto average = profiler->averages.find(result.name);
+			if (average == profiler->averages.end()) {
+				average = profiler->averages.emplace(result.name, result.time).first;
+			}
+			average->second += (result.time - average->second) * XE_GPU_PROFILER_SMOOTHING;
+			result.averageTime = average->second;
+
+			profiler->results.push_back(std::move(result));
+		}
+		profiler->resultsFrame = frame.frame;
+	}
+
+	void beginGPUProfilerFrame(GPUProfiler* profiler) {
+		profiler->currentSlot = profiler->frame % XE_GPU_PROFILER_FRAMES;
+		GPUProfilerFrame& frame = profiler->frames[profiler->currentSlot];
+		if (frame.pending) {
+			readGPUProfilerFrame(profiler, frame);
+		}
+
+		frame.scopes.clear();
+		frame.frame = profiler->frame;
+		frame.pending = false;
+		profiler->openScopes.clear();
+		profiler->recording = true;
+	}
+
+	void endGPUProfilerFrame(GPUProfiler* profiler) {
+		if (!profiler->openScopes.empty()) {
+			XE_LOG_ERROR_F("GPU_PROFILER: {} scopes still open at the end of the frame", profiler->openScopes.size());
+			while (!profiler->openScopes.empty()) {
+				endGPUScope(profiler);
+			}
+		}
+
+		GPUProfilerFrame& frame = profiler->frames[profiler->currentSlot];
+		frame.pending = !frame.scopes.empty();
+		profiler->recording = false;
+		++profiler->frame;
+	}
+
+	void beginGPUScope(GPUProfiler* profiler, const char* name) {
+		GPUProfilerFrame& frame = profiler->frames[profiler->currentSlot];
+		if (!profiler->recording || frame.scopes.size() == XE_GPU_PROFILER_MAX_SCOPES) {
+			// Keeps begin and end balanced, the scope is not timed
+			profiler->openScopes.push_back(UINT32_MAX);
+			return;
+		}
+
+		uint32_t index = (uint32_t)frame.scopes.size();
+		frame.scopes.push_back(GPUScopeRecord{ name, (uint8_t)profiler->openScopes.size() });
+		glQueryCounter(frame.queries[index * 2], GL_TIMESTAMP);
+		frame.lastQuery = frame.queries[index * 2];
+		profiler->openScopes.push_back(index);
+	}
+
+	void endGPUScope(GPUProfiler* profiler) {
+		XE_ASSERT(!profiler->openScopes.empty());
+		uint32_t index = profiler->openScopes.back();
+		profiler->openScopes.pop_back();
+		if (index == UINT32_MAX) {
+			return;
+		}
+		GPUProfilerFrame& frame = profiler->frames[profiler->currentSlot];
+		glQueryCounter(frame.queries[index * 2 + 1], GL_TIMESTAMP);
+		frame.lastQuery = frame.queries[index * 2 + 1];
+	}
+
+	GPUScope::GPUScope(const char* name) : profiler(s_activeProfiler) {
+		glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+		if (profiler) {
+			beginGPUScope(profiler, name);
+		}
+	}
+
+	GPUScope::~GPUScope() {
+		if (profiler) {
+			endGPUScope(profiler);
+		}
+		glPopDebugGroup();
+	}
+
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glad/gl.h>
+
+namespace xe {
+
+	// Frames in flight before the queries of a frame are read back, results are this many frames old
+	#define XE_GPU_PROFILER_FRAMES 4
+	// Scopes per frame, further scopes only emit their debug group
+	#define XE_GPU_PROFILER_MAX_SCOPES 64
+	// Weight of the newest frame in the averaged scope times
+	#define XE_GPU_PROFILER_SMOOTHING 0.1f
+
+	//----------------------------------------
+	// SECTION: GPU profiler
+	//----------------------------------------
+
+	/*
+		Scopes are timed with a pair of GL_TIMESTAMP queries so they can nest (GL_TIME_ELAPSED queries can not).
+		The queries of a frame are read back XE_GPU_PROFILER_FRAMES frames later without waiting, frames whose
+		results are still not available by then are dropped instead of stalling the CPU.
+	*/
+
+	struct GPUScopeRecord {
+		std::string name;
+		uint8_t depth = 0;
+	};
+
+	struct GPUProfilerFrame {
+		std::array<GLuint, XE_GPU_PROFILER_MAX_SCOPES * 2> queries = {};
+		std::vector<GPUScopeRecord> scopes;
+		// Last query issued, queries finish in order so all results are available once it is
+		GLuint lastQuery = 0;
+		uint64_t frame = 0;
+		bool pending = false;
+	};
+
+	struct GPUScopeResult {
+		std::string name;
+		uint8_t depth = 0;
+		float time = 0.0f;			// Milliseconds
+		float averageTime = 0.0f;	// Smoothed over the previous results
+	};
+
+	struct GPUProfiler {
+		std::array<GPUProfilerFrame, XE_GPU_PROFILER_FRAMES> frames;
+		uint64_t frame = 0;
+		uint32_t currentSlot = 0;
+		bool recording = false;
+		// Open scopes of the current frame, indices into its scopes
+		std::vector<uint32_t> openScopes;
+
+		// Newest read back frame, in scope begin order
+		std::vector<GPUScopeResult> results;
+		uint64_t resultsFrame = UINT64_MAX;
+		uint32_t droppedFrames = 0;
+		std::unordered_map<std::string, float> averages;
+	};
+
+	GPUProfiler* createGPUProfiler();
+	void destroyGPUProfiler(GPUProfiler* profiler);
+
+	// Scopes without an explicit profiler go to the active one, the renderer activates its profiler
+	void setActiveGPUProfiler(GPUProfiler* profiler);
+	GPUProfiler* getActiveGPUProfiler();
+
+
+	//----------------------------------------
+	// SECTION: GPU profiler functions
+	//----------------------------------------
+
+	// Reads back the results of an earlier frame, called by beginRenderFrame and endRenderFrame
+	void beginGPUProfilerFrame(GPUProfiler* profiler);
+	void endGPUProfilerFrame(GPUProfiler* profiler);
+
+	void beginGPUScope(GPUProfiler* profiler, const char* name);
+	void endGPUScope(GPUProfiler* profiler);
+
+	// Times the enclosing block on the active profiler and wraps it in a debug group for captures
+	struct GPUScope {
+		GPUScope(const char* name);
+		~GPUScope();
+
+		GPUScope(const GPUScope&) = delete;
+		GPUScope& operator=(const GPUScope&) = delete;
+
+		GPUProfiler* profiler;
+	};
+
+	#define XE_GPU_SCOPE_CONCAT_INNER(a, b) a##b
+	#define XE_GPU_SCOPE_CONCAT(a, b) XE_GPU_SCOPE_CONCAT_INNER(a, b)
+	#define XE_GPU_SCOPE(name) ::xe::GPUScope XE_GPU_SCOPE_CONCAT(xeGPUScope, __LINE__)(name)
+
+}
@@ -0,0 +1,576 @@
+#include "ibl_baker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+#include <stb_image.h>
+#include <ktx.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "xenon/core/log.h"
+#include "xenon/core/hash.h"
+#include "xenon/core/job_system.h"
+#include "xenon/core/profiler.h"
+#include "xenon/graphics/primitives.h"
+#include "xenon/graphics/gl_state.h"
+#include "xenon/graphics/render_stats.h"
+#include "xenon/graphics/gpu_profiler.h"
+
+namespace xe {
+
+	// VK_FORMAT_R16G16B16A16_SFLOAT, KTX2 files describe their format with Vulkan formats
+	#define XE_IBL_CACHE_VK_FORMAT 97
+	// Key of the irradiance coefficients in the metadata of the cached radiance
+	#define XE_IBL_CACHE_SH_KEY "xenon.irradianceSH"
+
+	struct IBLBakeData {
+		std::atomic<bool> ready{ false };
+		bool failed = false;
+		uint64_t hash = 0;
+
+		// Set by the job consuming the readback of the IRRADIANCE or CACHE stage
+		std::atomic<bool> jobDone{ false };
+		int irradianceSourceSize = 0;
+		SphericalHarmonics irradiance;
+
+		// Decoded source, RGB rows from bottom to top
+		float* pixels = nullptr;
+		int width = 0, height = 0;
+
+		// Cached bake, either loaded by the loading job or filled by the cache stage
+		ktxTexture* skybox = nullptr;
+		ktxTexture* radiance = nullptr;
+
+		~IBLBakeData() {
+			if (pixels) {
+				stbi_image_free(pixels);
+			}
+			if (skybox) {
+				ktxTexture_Destroy(skybox);
+			}
+			if (radiance) {
+				ktxTexture_Destroy(radiance);
+			}
+		}
+	};
+
+	//----------------------------------------
+	// SECTION: IBL baker
+	//----------------------------------------
+
+	IBLBaker* createIBLBaker() {
+		IBLBaker* baker = new IBLBaker();
+		baker->equirectangularShader = loadShader("assets/shaders/ibl_cubemap.vert", "assets/shaders/equirectangular.frag");
+		baker->prefilterShader = loadShader("assets/shaders/ibl_cubemap.vert", "assets/shaders/ibl_prefilter.frag");
+		baker->cube = generateCubeModel(glm::vec3(1.0f));
+		glCreateFramebuffers(1, &baker->framebufferID);
+
+		// Filtering across faces, the prefiltered mip levels would show the face edges otherwise
+		setGLCapability(GL_TEXTURE_CUBE_MAP_SEAMLESS, true);
+		return baker;
+	}
+
+	void destroyIBLBaker(IBLBaker* baker) {
+		forgetGLFramebuffer(baker->framebufferID);
+		glDeleteFramebuffers(1, &baker->framebufferID);
+		destroyModel(baker->cube);
+		destroyShader(baker->prefilterShader);
+		destroyShader(baker->equirectangularShader);
+		delete baker;
+	}
+
+
+	//----------------------------------------
+	// SECTION: IBL baker functions
+	//----------------------------------------
+
+	uint64_t hashIBLSource(const std::vector<char>& bytes) {
+		// The settings are part of the key so changing them bakes again
+		uint64_t hash = hashBytes(bytes.data(), bytes.size());
+		hash = hashValue(hash, XE_IBL_CACHE_VERSION);
+		hash = hashValue(hash, XE_IBL_CUBEMAP_RESOLUTION);
+		hash = hashValue(hash, XE_IBL_RADIANCE_RESOLUTION);
+		hash = hashValue(hash, XE_IBL_RADIANCE_LEVELS);
+		return hashValue(hash, XE_IBL_SAMPLE_COUNT);
+	}
+
+	std::string getIBLCachePath(uint64_t hash, const char* suffix) {
+		char name[32];
+		std::snprintf(name, sizeof(name), "%016llx", (unsigned long long)hash);
+		return std::string(XE_IBL_CACHE_DIRECTORY) + name + suffix;
+	}
+
+	void loadIBLSource(const std::shared_ptr<IBLBakeData>& data, const std::string& path) {
+		XE_PROFILE_FUNCTION();
+		std::ifstream file(path, std::ios::in | std::ios::binary);
+		if (!file.is_open()) {
+			XE_LOG_ERROR_F("IBL_BAKER: Failed to open {}", path);
+			data->failed = true;
+			return;
+		}
+		std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		data->hash = hashIBLSource(bytes);
+
+		std::string skyboxPath = getIBLCachePath(data->hash, "_skybox.ktx2");
+		std::string radiancePath = getIBLCachePath(data->hash, "_radiance.ktx2");
+		if (std::filesystem::exists(skyboxPath) && std::filesystem::exists(radiancePath)) {
+			bool loaded = ktxTexture_CreateFromNamedFile(skyboxPath.c_str(), KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, &data->skybox) == KTX_SUCCESS
+				&& ktxTexture_CreateFromNamedFile(radiancePath.c_str(), KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, &data->radiance) == KTX_SUCCESS;
+			if (loaded) {
+				return;
+			}
+			XE_LOG_WARN_F("IBL_BAKER: Cache of {} is unreadable, baking again", path);
+			if (data->skybox) {
+				ktxTexture_Destroy(data->skybox);
+				data->skybox = nullptr;
+			}
+		}
+
+		// The flip flag of stb_image is global, rows are flipped here so loads on other threads are not affected
+		int channels = 0;
+		data->pixels = stbi_loadf_from_memory((const stbi_uc*)bytes.data(), (int)bytes.size(), &data->width, &data->height, &channels, 3);
+		if (!data->pixels) {
+			XE_LOG_ERROR_F("IBL_BAKER: Failed to decode {}", path);
+			data->failed = true;
+			return;
+		}
+		size_t rowSize = (size_t)data->width * 3;
+		for (int y = 0; y < data->height / 2; ++y) {
+			std::swap_ranges(data->pixels + y * rowSize, data->pixels + (y + 1) * rowSize, data->pixels + (data->height - 1 - y) * rowSize);
+		}
+	}
+
+	// Pixel pack buffer for the reads of one stage, mapped persistently so the jobs can read it in place
+	void beginIBLReadback(IBLBake* bake, size_t size) {
+		const GLbitfield readFlags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glCreateBuffers(1, &bake->readbackBuffer);
+		glNamedBufferStorage(bake->readbackBuffer, (GLsizeiptr)size, nullptr, readFlags);
+		bake->readbackMemory = static_cast<uint8_t*>(glMapNamedBufferRange(bake->readbackBuffer, 0, (GLsizeiptr)size, readFlags));
+	}
+
+	// All faces of the level, the copy runs on the GPU and is only waited for through the fence
+	void readIBLTextureLevel(IBLBake* bake, const Texture& texture, int level, GLenum format, GLenum type, size_t offset, size_t size) {
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, bake->readbackBuffer);
+		glGetTextureImage(texture.textureID, level, format, type, (GLsizei)size, (void*)offset);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	}
+
+	bool isIBLReadbackReady(IBLBake* bake) {
+		return glClientWaitSync(bake->readbackFence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) != GL_TIMEOUT_EXPIRED;
+	}
+
+	void releaseIBLReadback(IBLBake* bake) {
+		if (bake->readbackFence) {
+			glDeleteSync(bake->readbackFence);
+			bake->readbackFence = nullptr;
+		}
+		if (bake->readbackBuffer) {
+			glUnmapNamedBuffer(bake->readbackBuffer);
+			glDeleteBuffers(1, &bake->readbackBuffer);
+			bake->readbackBuffer = 0;
+			bake->readbackMemory = nullptr;
+		}
+		bake->readbackJob = false;
+	}
+
+	IBLBake* startIBLBake(const std::string& path) {
+		IBLBake* bake = new IBLBake();
+		bake->path = path;
+		bake->data = std::make_shared<IBLBakeData>();
+
+		std::shared_ptr<IBLBakeData> data = bake->data;
+		submitJob([data, path]() {
+			loadIBLSource(data, path);
+			data->ready.store(true, std::memory_order_release);
+		});
+		return bake;
+	}
+
+	void destroyIBLBake(IBLBake* bake) {
+		// The job reads the mapped readback, it has to finish before the buffer goes away
+		if (bake->readbackJob) {
+			while (!bake->data->jobDone.load(std::memory_order_acquire)) {
+				std::this_thread::yield();
+			}
+		}
+		releaseIBLReadback(bake);
+
+		if (bake->equirectangular) {
+			destroyTexture(bake->equirectangular);
+		}
+		if (bake->stage != IBLBakeStage::DONE) {
+			if (bake->environment.environmentCubemap) {
+				destroyTexture(bake->environment.environmentCubemap);
+			}
+			if (bake->environment.radianceMap) {
+				destroyTexture(bake->environment.radianceMap);
+			}
+		}
+		delete bake;
+	}
+
+	// Uploaded through DSA like the baked cubemaps, libktx's uploader would change GL state behind the state cache
+	Texture* uploadIBLCacheTexture(ktxTexture* source, const TextureParameters& params) {
+		bool valid = source->classId == ktxTexture2_c
+			&& reinterpret_cast<ktxTexture2*>(source)->vkFormat == XE_IBL_CACHE_VK_FORMAT
+			&& reinterpret_cast<ktxTexture2*>(source)->supercompressionScheme == KTX_SS_NONE
+			&& source->numFaces == 6
+			&& source->baseWidth == source->baseHeight;
+		if (!valid) {
+			return nullptr;
+		}
+
+		int resolution = (int)source->baseWidth;
+		GLuint textureID;
+		glCreateTextures(GL_TEXTURE_CUBE_MAP, 1, &textureID);
+		glTextureParameteri(textureID, GL_TEXTURE_MIN_FILTER, params.minFilter);
+		glTextureParameteri(textureID, GL_TEXTURE_MAG_FILTER, params.magFilter);
+		glTextureParameteri(textureID, GL_TEXTURE_WRAP_S, params.wrapS);
+		glTextureParameteri(textureID, GL_TEXTURE_WRAP_T, params.wrapT);
+		glTextureParameteri(textureID, GL_TEXTURE_WRAP_R, params.wrapR);
+		glTextureStorage2D(textureID, (GLsizei)source->numLevels, GL_RGBA16F, resolution, resolution);
+
+		const uint8_t* data = ktxTexture_GetData(source);
+		for (uint32_t level = 0; level < source->numLevels; ++level) {
+			int size = glm::max(resolution >> level, 1);
+			for (uint32_t face = 0; face < 6; ++face) {
+				ktx_size_t offset = 0;
+				ktxTexture_GetImageOffset(source, level, 0, face, &offset);
+				glTextureSubImage3D(textureID, (GLint)level, 0, 0, (GLint)face, size, size, 1, GL_RGBA, GL_HALF_FLOAT, data + offset);
+			}
+		}
+		return new Texture{ AssetMetadata(), AssetRuntimeData(), textureID, params, resolution, resolution, 4, TextureFormat::RGBA_FLOAT };
+	}
+
+	// Cube face views matching the GL face order and orientation
+	glm::mat4 getIBLFaceView(uint32_t face) {
+		static const glm::vec3 directions[6] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+		static const glm::vec3 ups[6] = { { 0, -1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 }, { 0, -1, 0 }, { 0, -1, 0 } };
+		return glm::lookAt(glm::vec3(0.0f), directions[face], ups[face]);
+	}
+
+	void renderIBLFace(IBLBaker* baker, const Shader& shader, const Texture& target, uint32_t face, int level) {
+		int size = glm::max(target.width >> level, 1);
+		glNamedFramebufferTextureLayer(baker->framebufferID, GL_COLOR_ATTACHMENT0, target.textureID, level, (GLint)face);
+		bindGLFramebuffer(GL_FRAMEBUFFER, baker->framebufferID);
+
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		glViewport(0, 0, size, size);
+
+		loadMat4(shader, "projection", glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f));
+		loadMat4(shader, "view", getIBLFaceView(face));
+
+		setGLCapability(GL_CULL_FACE, false);
+		setGLCapability(GL_DEPTH_TEST, false);
+		const Primitive& primitive = baker->cube->primitives[0];
+		bindGLVertexArray(primitive.vao);
+		glDrawArrays(primitive.mode, 0, primitive.count);
+		recordDrawCall(primitive.mode, primitive.count);
+		setGLCapability(GL_DEPTH_TEST, true);
+		setGLCapability(GL_CULL_FACE, true);
+
+		glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+		bindGLFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	ktxTexture* createIBLCacheTexture(int resolution, uint32_t levels) {
+		ktxTextureCreateInfo info = {};
+		info.glInternalformat = GL_RGBA16F;
+		info.vkFormat = XE_IBL_CACHE_VK_FORMAT;
+		info.baseWidth = (ktx_uint32_t)resolution;
+		info.baseHeight = (ktx_uint32_t)resolution;
+		info.baseDepth = 1;
+		info.numDimensions = 2;
+		info.numLevels = levels;
+		info.numLayers = 1;
+		info.numFaces = 6;
+		info.isArray = KTX_FALSE;
+		info.generateMipmaps = KTX_FALSE;
+
+		ktxTexture2* cache = nullptr;
+		if (ktxTexture2_Create(&info, KTX_TEXTURE_CREATE_ALLOC_STORAGE, &cache) != KTX_SUCCESS) {
+			return nullptr;
+		}
+		return ktxTexture(cache);
+	}
+
+	// Bytes of all faces of a level of the cached RGBA16F cubemaps
+	size_t getIBLCacheLevelSize(int resolution, uint32_t level) {
+		size_t size = (size_t)glm::max(resolution >> level, 1);
+		return size * size * 4 * sizeof(uint16_t) * 6;
+	}
+
+	// Levels are read back one after the other, all faces of a level are consecutive
+	const uint8_t* setIBLCacheLevels(ktxTexture* cache, const uint8_t* memory, int resolution, uint32_t levels) {
+		for (uint32_t level = 0; level < levels; ++level) {
+			size_t faceSize = getIBLCacheLevelSize(resolution, level) / 6;
+			for (uint32_t face = 0; face < 6; ++face) {
+				ktxTexture_SetImageFromMemory(cache, level, 0, face, memory + face * faceSize, faceSize);
+			}
+			memory += faceSize * 6;
+		}
+		return memory;
+	}
+
+	void writeIBLCache(const std::shared_ptr<IBLBakeData>& data, const uint8_t* memory, const std::string& path) {
+		data->jobDone.store(false, std::memory_order_relaxed);
+
+		// Copies, compression and file IO on a worker, the job keeps the data alive and the bake keeps the readback
+		submitJob([data, memory, path]() {
+			XE_PROFILE_SCOPE("writeIBLCache");
+			uint32_t skyboxLevels = (uint32_t)glm::log2((float)XE_IBL_CUBEMAP_RESOLUTION) + 1;
+			data->skybox = createIBLCacheTexture(XE_IBL_CUBEMAP_RESOLUTION, skyboxLevels);
+			data->radiance = createIBLCacheTexture(XE_IBL_RADIANCE_RESOLUTION, XE_IBL_RADIANCE_LEVELS);
+			if (!data->skybox || !data->radiance) {
+				XE_LOG_ERROR_F("IBL_BAKER: Failed to create the cache of {}", path);
+				data->jobDone.store(true, std::memory_order_release);
+				return;
+			}
+			const uint8_t* radianceMemory = setIBLCacheLevels(data->skybox, memory, XE_IBL_CUBEMAP_RESOLUTION, skyboxLevels);
+			setIBLCacheLevels(data->radiance, radianceMemory, XE_IBL_RADIANCE_RESOLUTION, XE_IBL_RADIANCE_LEVELS);
+			ktxHashList_AddKVPair(&data->radiance->kvDataHead, XE_IBL_CACHE_SH_KEY, sizeof(data->irradiance.coefficients), data->irradiance.coefficients);
+
+			std::error_code error;
+			std::filesystem::create_directories(XE_IBL_CACHE_DIRECTORY, error);
+			std::string skyboxPath = getIBLCachePath(data->hash, "_skybox.ktx2");
+			std::string radiancePath = getIBLCachePath(data->hash, "_radiance.ktx2");
+			if (ktxTexture_WriteToNamedFile(data->skybox, skyboxPath.c_str()) != KTX_SUCCESS
+				|| ktxTexture_WriteToNamedFile(data->radiance, radiancePath.c_str()) != KTX_SUCCESS) {
+				XE_LOG_ERROR_F("IBL_BAKER: Failed to write the cache of {}", path);
+				std::filesystem::remove(skyboxPath, error);
+			}
+			else {
+				XE_LOG_INFO_F("IBL_BAKER: Cached {} as {}", path, radiancePath);
+			}
+			data->jobDone.store(true, std::memory_order_release);
+		});
+	}
+
+	// Projects the six faces of the read back level, the result is picked up by the IRRADIANCE stage
+	void projectIBLIrradiance(const std::shared_ptr<IBLBakeData>& data, const float* faces, int size) {
+		data->jobDone.store(false, std::memory_order_relaxed);
+		submitJob([data, faces, size]() {
+			XE_PROFILE_SCOPE("projectIBLIrradiance");
+			SHProjection projection;
+			for (int face = 0; face < 6; ++face) {
+				projectCubemapFaceSH(projection, face, faces + (size_t)face * size * size * 3, size);
+			}
+			data->irradiance = convolveIrradianceSH(finishSHProjection(projection));
+			data->jobDone.store(true, std::memory_order_release);
+		});
+	}
+
+	bool finishIBLBakeFromCache(IBLBake* bake) {
+		const TextureParameters cubemapParams = TextureParameters{ GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE };
+		IBLBakeData& data = *bake->data;
+
+		char* value = nullptr;
+		unsigned int valueSize = 0;
+		if (ktxHashList_FindValue(&data.radiance->kvDataHead, XE_IBL_CACHE_SH_KEY, &valueSize, (void**)&value) != KTX_SUCCESS
+			|| valueSize != sizeof(SphericalHarmonics::coefficients)) {
+			return false;
+		}
+		std::copy(value, value + valueSize, (char*)bake->environment.irradianceSH.coefficients);
+
+		bake->environment.environmentCubemap = uploadIBLCacheTexture(data.skybox, cubemapParams);
+		bake->environment.radianceMap = uploadIBLCacheTexture(data.radiance, cubemapParams);
+		return bake->environment.environmentCubemap && bake->environment.radianceMap;
+	}
+
+	bool updateIBLBake(IBLBaker* baker, IBLBake* bake) {
+		XE_PROFILE_FUNCTION();
+		IBLBakeData& data = *bake->data;
+		Environment& environment = bake->environment;
+
+		switch (bake->stage) {
+		case IBLBakeStage::LOADING: {
+			if (!data.ready.load(std::memory_order_acquire)) {
+				return false;
+			}
+			if (data.failed) {
+				bake->stage = IBLBakeStage::FAILED;
+				return true;
+			}
+			if (data.skybox && data.radiance) {
+				bake->loadedFromCache = finishIBLBakeFromCache(bake);
+				if (bake->loadedFromCache) {
+					XE_LOG_INFO_F("IBL_BAKER: Loaded {} from the cache", bake->path);
+					bake->stage = IBLBakeStage::DONE;
+					return true;
+				}
+				XE_LOG_ERROR_F("IBL_BAKER: Failed to upload the cache of {}", bake->path);
+				bake->stage = IBLBakeStage::FAILED;
+				return true;
+			}
+
+			const TextureParameters sourceParams = TextureParameters{ GL_LINEAR, GL_LINEAR, GL_REPEAT, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE };
+			bake->equirectangular = createEmptyTexture(data.width, data.height, TextureFormat::RGB_FLOAT, sourceParams);
+			glTextureSubImage2D(bake->equirectangular->textureID, 0, 0, 0, data.width, data.height, GL_RGB, GL_FLOAT, data.pixels);
+			stbi_image_free(data.pixels);
+			data.pixels = nullptr;
+
+			const TextureParameters cubemapParams = TextureParameters{ GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE };
+			int cubemapLevels = (int)glm::log2((float)XE_IBL_CUBEMAP_RESOLUTION) + 1;
+			environment.environmentCubemap = createEmptyCubemapTexture(XE_IBL_CUBEMAP_RESOLUTION, TextureFormat::RGBA_FLOAT, cubemapParams, cubemapLevels);
+			environment.radianceMap = createEmptyCubemapTexture(XE_IBL_RADIANCE_RESOLUTION, TextureFormat::RGBA_FLOAT, cubemapParams, XE_IBL_RADIANCE_LEVELS);
+
+			bake->stage = IBLBakeStage::CUBEMAP;
+			bake->step = 0;
+			return false;
+		}
+
+		case IBLBakeStage::CUBEMAP: {
+			XE_GPU_SCOPE("IBL cubemap");
+			bindShader(*baker->equirectangularShader);
+			bindGLTextureUnit(0, bake->equirectangular->textureID);
+			renderIBLFace(baker, *baker->equirectangularShader, *environment.environmentCubemap, bake->step, 0);
+
+			if (++bake->step == 6) {
+				glGenerateTextureMipmap(environment.environmentCubemap->textureID);
+				destroyTexture(bake->equirectangular);
+				bake->equirectangular = nullptr;
+				bake->stage = IBLBakeStage::IRRADIANCE;
+				bake->step = 0;
+			}
+			return false;
+		}
+
+		case IBLBakeStage::IRRADIANCE: {
+			// Read back a small level, project it in a job once the copy has finished, then pick up the result
+			if (bake->step == 0) {
+				int size = 0;
+				int level = getSHSourceLevel(*environment.environmentCubemap, size);
+				if (size == 0) {
+					XE_LOG_ERROR_F("IBL_BAKER: Cubemap of {} has no data, the irradiance stays black", bake->path);
+					bake->stage = IBLBakeStage::RADIANCE;
+					bake->step = 0;
+					return false;
+				}
+				size_t bytes = (size_t)size * size * 3 * sizeof(float) * 6;
+				beginIBLReadback(bake, bytes);
+				readIBLTextureLevel(bake, *environment.environmentCubemap, level, GL_RGB, GL_FLOAT, 0, bytes);
+				bake->readbackFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+				data.irradianceSourceSize = size;
+				bake->step = 1;
+			}
+			else if (bake->step == 1) {
+				if (!isIBLReadbackReady(bake)) {
+					return false;
+				}
+				projectIBLIrradiance(bake->data, reinterpret_cast<const float*>(bake->readbackMemory), data.irradianceSourceSize);
+				bake->readbackJob = true;
+				bake->step = 2;
+			}
+			else if (data.jobDone.load(std::memory_order_acquire)) {
+				environment.irradianceSH = data.irradiance;
+				releaseIBLReadback(bake);
+				bake->stage = IBLBakeStage::RADIANCE;
+				bake->step = 0;
+			}
+			return false;
+		}
+
+		case IBLBakeStage::RADIANCE: {
+			XE_GPU_SCOPE("IBL prefilter");
+			uint32_t level = bake->step / 6;
+			uint32_t face = bake->step % 6;
+			const Shader& shader = *baker->prefilterShader;
+			bindShader(shader);
+			loadFloat(shader, "roughness", (float)level / (XE_IBL_RADIANCE_LEVELS - 1));
+			loadFloat(shader, "sourceResolution", (float)XE_IBL_CUBEMAP_RESOLUTION);
+			loadInt(shader, "sampleCount", XE_IBL_SAMPLE_COUNT);
+			bindGLTextureUnit(0, environment.environmentCubemap->textureID);
+			renderIBLFace(baker, shader, *environment.radianceMap, face, (int)level);
+
+			if (++bake->step == 6 * XE_IBL_RADIANCE_LEVELS) {
+				unbindShader();
+				bake->stage = IBLBakeStage::CACHE;
+				bake->step = 0;
+			}
+			return false;
+		}
+
+		case IBLBakeStage::CACHE: {
+			// One mip level read per step, the skybox levels first, then a job writes the files once all copies are done
+			uint32_t skyboxLevels = (uint32_t)glm::log2((float)XE_IBL_CUBEMAP_RESOLUTION) + 1;
+			uint32_t levels = skyboxLevels + XE_IBL_RADIANCE_LEVELS;
+			if (bake->step == 0) {
+				size_t bytes = 0;
+				for (uint32_t level = 0; level < skyboxLevels; ++level) {
+					bytes += getIBLCacheLevelSize(XE_IBL_CUBEMAP_RESOLUTION, level);
+				}
+				for (uint32_t level = 0; level < XE_IBL_RADIANCE_LEVELS; ++level) {
+					bytes += getIBLCacheLevelSize(XE_IBL_RADIANCE_RESOLUTION, level);
+				}
+				beginIBLReadback(bake, bytes);
+				bake->readbackOffset = 0;
+			}
+
+			if (bake->step < levels) {
+				bool skybox = bake->step < skyboxLevels;
+				uint32_t level = skybox ? bake->step : bake->step - skyboxLevels;
+				size_t size = getIBLCacheLevelSize(skybox ? XE_IBL_CUBEMAP_RESOLUTION : XE_IBL_RADIANCE_RESOLUTION, level);
+				readIBLTextureLevel(bake, skybox ? *environment.environmentCubemap : *environment.radianceMap, (int)level, GL_RGBA, GL_HALF_FLOAT, bake->readbackOffset, size);
+				bake->readbackOffset += size;
+				if (++bake->step == levels) {
+					bake->readbackFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+				}
+			}
+			else if (bake->step == levels) {
+				if (!isIBLReadbackReady(bake)) {
+					return false;
+				}
+				data.irradiance = environment.irradianceSH;
+				writeIBLCache(bake->data, bake->readbackMemory, bake->path);
+				bake->readbackJob = true;
+				++bake->step;
+			}
+			else if (data.jobDone.load(std::memory_order_acquire)) {
+				releaseIBLReadback(bake);
+				XE_LOG_INFO_F("IBL_BAKER: Baked {}", bake->path);
+				bake->stage = IBLBakeStage::DONE;
+				return true;
+			}
+			return false;
+		}
+
+		case IBLBakeStage::DONE:
+		case IBLBakeStage::FAILED:
+			return true;
+		}
+		return true;
+	}
+
+	bool bakeIBL(IBLBaker* baker, IBLBake* bake) {
+		while (!updateIBLBake(baker, bake)) {
+			// The loading job, readbacks and the jobs consuming them keep the bake waiting
+			if (bake->stage == IBLBakeStage::LOADING || bake->readbackFence || bake->readbackJob) {
+				std::this_thread::yield();
+			}
+		}
+		return bake->stage == IBLBakeStage::DONE;
+	}
+
+	float getIBLBakeProgress(const IBLBake& bake) {
+		const uint32_t skyboxLevels = (uint32_t)glm::log2((float)XE_IBL_CUBEMAP_RESOLUTION) + 1;
+		const uint32_t total = 1 + 6 + 3 + 6 * XE_IBL_RADIANCE_LEVELS + skyboxLevels + XE_IBL_RADIANCE_LEVELS + 2;
+		uint32_t done = 0;
+		switch (bake.stage) {
+		case IBLBakeStage::LOADING: done = 0; break;
+		case IBLBakeStage::CUBEMAP: done = 1 + bake.step; break;
+		case IBLBakeStage::IRRADIANCE: done = 7 + bake.step; break;
+		case IBLBakeStage::RADIANCE: done = 10 + bake.step; break;
+		case IBLBakeStage::CACHE: done = 10 + 6 * XE_IBL_RADIANCE_LEVELS + bake.step; break;
+		default: done = total; break;
+		}
+		return (float)done / total;
+	}
+
+}
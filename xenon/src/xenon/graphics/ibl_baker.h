@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <glad/gl.h>
+
+#include "xenon/graphics/environment.h"
+#include "xenon/graphics/model.h"
+#include "xenon/graphics/shader.h"
+#include "xenon/graphics/texture.h"
+
+namespace xe {
+
+	// Face size of the environment cubemap the equirectangular image is projected to
+	#define XE_IBL_CUBEMAP_RESOLUTION 512
+	// Face size and mip levels of the prefiltered radiance, pbr.frag maps roughness 1 to the last level
+	#define XE_IBL_RADIANCE_RESOLUTION 256
+	#define XE_IBL_RADIANCE_LEVELS 5
+	// GGX samples per texel of the prefiltered radiance
+	#define XE_IBL_SAMPLE_COUNT 512
+	// Directory of baked environments, relative to the working directory
+	#define XE_IBL_CACHE_DIRECTORY "cache/ibl/"
+	// Part of the cache key, increment when the baked data changes
+	#define XE_IBL_CACHE_VERSION 1
+
+	//----------------------------------------
+	// SECTION: IBL baker
+	//----------------------------------------
+
+	/*
+		Bakes an environment from an equirectangular HDR image at runtime:
+
+		1. Loading: a job reads and hashes the file, then either loads the cached KTX2 files of that hash or
+		   decodes the image.
+		2. Cubemap: the image is projected to the six faces of the environment cubemap (equirectangular.frag),
+		   then mip levels are generated for filtered sampling.
+		3. Irradiance: a small mip level of the cubemap is read back and a job projects it to spherical
+		   harmonics (see computeIrradianceSH).
+		4. Radiance: every face of every mip level is prefiltered with GGX importance sampling (ibl_prefilter.frag).
+		5. Cache: both cubemaps are read back and a job writes them as KTX2 files keyed by the source hash, the
+		   irradiance coefficients are stored as metadata of the radiance file.
+
+		Each updateIBLBake call does one unit of work (one face, one mip level, one readback), so a bake is spread
+		over about 50 frames instead of stalling one. Readbacks go to a persistently mapped pixel pack buffer and
+		are only touched once their fence has signaled, the CPU work on them runs in jobs.
+	*/
+
+	enum class IBLBakeStage : uint8_t {
+		LOADING		= 0,
+		CUBEMAP		= 1,
+		IRRADIANCE	= 2,
+		RADIANCE	= 3,
+		CACHE		= 4,
+		DONE		= 5,
+		FAILED		= 6
+	};
+
+	struct IBLBaker {
+		Shader* equirectangularShader = nullptr;
+		Shader* prefilterShader = nullptr;
+		Model* cube = nullptr;
+		GLuint framebufferID = 0;
+	};
+
+	// State shared with the loading and cache jobs, outlives the bake while a job runs
+	struct IBLBakeData;
+
+	struct IBLBake {
+		std::string path;
+		IBLBakeStage stage = IBLBakeStage::LOADING;
+		// Index of the next unit of work of the stage
+		uint32_t step = 0;
+		bool loadedFromCache = false;
+
+		// Readback of the IRRADIANCE or CACHE stage, kept until the job reading it has finished
+		GLuint readbackBuffer = 0;
+		uint8_t* readbackMemory = nullptr;
+		size_t readbackOffset = 0;
+		GLsync readbackFence = nullptr;
+		bool readbackJob = false;
+
+		std::shared_ptr<IBLBakeData> data;
+		Texture* equirectangular = nullptr;
+
+		// Valid once the stage is DONE, owned by the caller from then on
+		Environment environment;
+	};
+
+	IBLBaker* createIBLBaker();
+	void destroyIBLBaker(IBLBaker* baker);
+
+
+	//----------------------------------------
+	// SECTION: IBL baker functions
+	//----------------------------------------
+
+	IBLBake* startIBLBake(const std::string& path);
+	// Destroys the textures of unfinished bakes, finished environments belong to the caller
+	void destroyIBLBake(IBLBake* bake);
+
+	// Does the next unit of work, returns true once the bake is DONE or FAILED
+	bool updateIBLBake(IBLBaker* baker, IBLBake* bake);
+	// Whole bake at once, for tools and loading screens
+	bool bakeIBL(IBLBaker* baker, IBLBake* bake);
+
+	// Fraction of the work done, for progress bars
+	float getIBLBakeProgress(const IBLBake& bake);
+
+}
@@ -0,0 +1,330 @@
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+namespace xe {
+
+	//----------------------------------------
+	// SECTION: Vertex cache simulation
+	//----------------------------------------
+
+	// FIFO post-transform cache, a vertex is a hit if it was transformed less than cacheSize misses ago
+	struct VertexCache {
+		std::vector<uint32_t> timestamps;
+		uint32_t time;
+		uint32_t cacheSize;
+
+		VertexCache(size_t vertexCount, uint32_t cacheSize)
+			: timestamps(vertexCount, 0), time(cacheSize + 1), cacheSize(cacheSize) {}
+
+		// Returns true on a cache miss
+		bool access(uint32_t vertex) {
+			if (time - timestamps[vertex] > cacheSize) {
+				timestamps[vertex] = time++;
+				return true;
+			}
+			return false;
+		}
+
+		void flush() {
+			time += cacheSize + 1;
+		}
+	};
+
+	VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize) {
+		VertexCacheStats stats;
+		if (indices.empty() || vertexCount == 0) {
+			return stats;
+		}
+
+		VertexCache cache(vertexCount, cacheSize);
+		std::vector<uint8_t> referenced(vertexCount, 0);
+		size_t misses = 0, uniqueVertices = 0;
+		for (uint32_t index : indices) {
+			misses += cache.access(index);
+			if (!referenced[index]) {
+				referenced[index] = 1;
+				++uniqueVertices;
+			}
+		}
+
+		stats.acmr = (float)misses / (float)(indices.size() / 3);
+		stats.atvr = (float)misses / (float)uniqueVertices;
+		return stats;
+	}
+
+
+	//----------------------------------------
+	// SECTION: Vertex cache optimization
+	//----------------------------------------
+
+	void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize) {
+		size_t triangleCount = indices.size() / 3;
+		if (triangleCount == 0 || vertexCount == 0) {
+			return;
+		}
+
+		// Vertex to triangle adjacency
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+		for (uint32_t index : indices) {
+			++adjacencyOffsets[index + 1];
+		}
+		std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+		std::vector<uint32_t> adjacency(indices.size());
+		{
+			std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (size_t i = 0; i < indices.size(); ++i) {
+				adjacency[fill[indices[i]]++] = (uint32_t)(i / 3);
+			}
+		}
+
+		std::vector<uint32_t> liveTriangles(vertexCount);
+		for (size_t v = 0; v < vertexCount; ++v) {
+			liveTriangles[v] = adjacencyOffsets[v + 1] - adjacencyOffsets[v];
+		}
+
+		std::vector<uint32_t> cacheTime(vertexCount, 0);
+		std::vector<uint8_t> emitted(triangleCount, 0);
+		std::vector<uint32_t> deadEnds;
+		std::vector<uint32_t> candidates;
+		std::vector<uint32_t> result;
+		result.reserve(indices.size());
+
+		uint32_t time = cacheSize + 1;
+		size_t cursor = 0;  // Next vertex to consider when the dead end stack runs empty
+		int64_t fanning = 0;
+
+		// Tipsify: fan around a vertex, then continue with the adjacent vertex most likely still in the cache
+		while (fanning >= 0) {
+			candidates.clear();
+
+			for (uint32_t a = adjacencyOffsets[fanning]; a < adjacencyOffsets[fanning + 1]; ++a) {
+				uint32_t triangle = adjacency[a];
+				if (emitted[triangle]) {
+					continue;
+				}
+				for (size_t k = 0; k < 3; ++k) {
+					uint32_t vertex = indices[triangle * 3 + k];
+					result.push_back(vertex);
+					deadEnds.push_back(vertex);
+					candidates.push_back(vertex);
+					--liveTriangles[vertex];
+					if (time - cacheTime[vertex] > cacheSize) {
+						cacheTime[vertex] = time++;
+					}
+				}
+				emitted[triangle] = 1;
+			}
+
+			// Pick the candidate that stays in the cache longest while fanning all its remaining triangles
+			fanning = -1;
+			int64_t bestPriority = -1;
+			for (uint32_t vertex : candidates) {
+				if (liveTriangles[vertex] == 0) {
+					continue;
+				}
+				int64_t priority = 0;
+				if (time - cacheTime[vertex] + 2 * liveTriangles[vertex] <= cacheSize) {
+					priority = time - cacheTime[vertex];
+				}
+				if (priority > bestPriority) {
+					bestPriority = priority;
+					fanning = vertex;
+				}
+			}
+
+			// Dead end, fall back to recently used vertices and then to the next unprocessed vertex
+			while (fanning < 0 && !deadEnds.empty()) {
+				uint32_t vertex = deadEnds.back();
+				deadEnds.pop_back();
+				if (liveTriangles[vertex] > 0) {
+					fanning = vertex;
+				}
+			}
+			while (fanning < 0 && cursor < vertexCount) {
+				if (liveTriangles[cursor] > 0) {
+					fanning = cursor;
+				}
+				++cursor;
+			}
+		}
+
+		indices = std::move(result);
+	}
+
+
+	//----------------------------------------
+	// SECTION: Overdraw optimization
+	//----------------------------------------
+
+	// Splits the triangle list into clusters that can be reordered without losing much vertex cache efficiency
+	static std::vector<uint32_t> generateClusters(const std::vector<uint32_t>& indices, size_t vertexCount, float threshold) {
+		size_t triangleCount = indices.size() / 3;
+
+		// Hard boundaries, triangles where the cache was effectively flushed (all three vertices missed)
+		std::vector<uint32_t> hardBoundaries;
+		std::vector<uint32_t> triangleMisses(triangleCount);
+		{
+			VertexCache cache(vertexCount, XE_VERTEX_CACHE_SIZE);
+			for (size_t t = 0; t < triangleCount; ++t) {
+				uint32_t misses = cache.access(indices[t * 3 + 0]) + cache.access(indices[t * 3 + 1]) + cache.access(indices[t * 3 + 2]);
+				triangleMisses[t] = misses;
+				if (t == 0 || misses == 3) {
+					hardBoundaries.push_back((uint32_t)t);
+				}
+			}
+		}
+		hardBoundaries.push_back((uint32_t)triangleCount);
+
+		// Soft boundaries, split a hard cluster once the running miss ratio is close enough to the cluster's
+		std::vector<uint32_t> clusters;
+		VertexCache cache(vertexCount, XE_VERTEX_CACHE_SIZE);
+		for (size_t c = 0; c + 1 < hardBoundaries.size(); ++c) {
+			uint32_t begin = hardBoundaries[c];
+			uint32_t end = hardBoundaries[c + 1];
+
+			uint32_t clusterMisses = 0;
+			for (uint32_t t = begin; t < end; ++t) {
+				clusterMisses += triangleMisses[t];
+			}
+			float target = (float)clusterMisses / (float)(end - begin) * threshold;
+
+			clusters.push_back(begin);
+			cache.flush();
+			uint32_t start = begin;
+			uint32_t misses = 0;
+			for (uint32_t t = begin; t < end; ++t) {
+				misses += cache.access(indices[t * 3 + 0]) + cache.access(indices[t * 3 + 1]) + cache.access(indices[t * 3 + 2]);
+				if (t + 1 < end && (float)misses / (float)(t - start + 1) <= target) {
+					clusters.push_back(t + 1);
+					cache.flush();
+					start = t + 1;
+					misses = 0;
+				}
+			}
+		}
+		clusters.push_back((uint32_t)triangleCount);
+
+		return clusters;
+	}
+
+	void optimizeOverdraw(std::vector<uint32_t>& indices, const float* positions, size_t vertexCount, size_t positionStride, float threshold) {
+		size_t triangleCount = indices.size() / 3;
+		if (triangleCount == 0 || vertexCount == 0) {
+			return;
+		}
+		if (positionStride == 0) {
+			positionStride = sizeof(float) * 3;
+		}
+
+		auto position = [&](uint32_t vertex) {
+			return reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + vertex * positionStride);
+		};
+
+		std::vector<uint32_t> clusters = generateClusters(indices, vertexCount, threshold);
+		size_t clusterCount = clusters.size() - 1;
+		if (clusterCount <= 1) {
+			return;
+		}
+
+		// Area weighted centroid and normal per cluster
+		struct Cluster {
+			double centroid[3] = { 0, 0, 0 };
+			double normal[3] = { 0, 0, 0 };
+			double area = 0;
+			float sortKey = 0.0f;
+		};
+		std::vector<Cluster> clusterData(clusterCount);
+		double meshCentroid[3] = { 0, 0, 0 };
+		double meshArea = 0;
+
+		for (size_t c = 0; c < clusterCount; ++c) {
+			Cluster& cluster = clusterData[c];
+			for (uint32_t t = clusters[c]; t < clusters[c + 1]; ++t) {
+				const float* p0 = position(indices[t * 3 + 0]);
+				const float* p1 = position(indices[t * 3 + 1]);
+				const float* p2 = position(indices[t * 3 + 2]);
+
+				double e1[3] = { (double)p1[0] - p0[0], (double)p1[1] - p0[1], (double)p1[2] - p0[2] };
+				double e2[3] = { (double)p2[0] - p0[0], (double)p2[1] - p0[1], (double)p2[2] - p0[2] };
+				double normal[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+				double area = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+				for (size_t k = 0; k < 3; ++k) {
+					cluster.centroid[k] += (p0[k] + p1[k] + p2[k]) / 3.0 * area;
+					cluster.normal[k] += normal[k];
+				}
+				cluster.area += area;
+			}
+
+			for (size_t k = 0; k < 3; ++k) {
+				meshCentroid[k] += cluster.centroid[k];
+				if (cluster.area > 0) {
+					cluster.centroid[k] /= cluster.area;
+				}
+			}
+			meshArea += cluster.area;
+		}
+		if (meshArea > 0) {
+			for (size_t k = 0; k < 3; ++k) {
+				meshCentroid[k] /= meshArea;
+			}
+		}
+
+		// Clusters on the outside facing away from the center are likely to occlude the others, draw them first
+		for (Cluster& cluster : clusterData) {
+			double length = std::sqrt(cluster.normal[0] * cluster.normal[0] + cluster.normal[1] * cluster.normal[1] + cluster.normal[2] * cluster.normal[2]);
+			if (length == 0) {
+				continue;
+			}
+			double dot = 0;
+			for (size_t k = 0; k < 3; ++k) {
+				dot += (cluster.centroid[k] - meshCentroid[k]) * cluster.normal[k] / length;
+			}
+			cluster.sortKey = (float)dot;
+		}
+
+		std::vector<uint32_t> order(clusterCount);
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return clusterData[a].sortKey > clusterData[b].sortKey; });
+
+		std::vector<uint32_t> result;
+		result.reserve(indices.size());
+		for (uint32_t c : order) {
+			result.insert(result.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+		}
+		indices = std::move(result);
+	}
+
+
+	//----------------------------------------
+	// SECTION: Vertex fetch optimization
+	//----------------------------------------
+
+	std::vector<uint32_t> optimizeVertexFetch(std::vector<uint32_t>& indices, size_t vertexCount, size_t& outputVertexCount) {
+		std::vector<uint32_t> remap(vertexCount, UINT32_MAX);
+		uint32_t nextVertex = 0;
+		for (uint32_t& index : indices) {
+			if (remap[index] == UINT32_MAX) {
+				remap[index] = nextVertex++;
+			}
+			index = remap[index];
+		}
+		outputVertexCount = nextVertex;
+		return remap;
+	}
+
+	void remapVertexBuffer(void* destination, const void* source, size_t vertexCount, size_t elementSize, size_t sourceStride, const std::vector<uint32_t>& remap) {
+		const uint8_t* src = static_cast<const uint8_t*>(source);
+		uint8_t* dst = static_cast<uint8_t*>(destination);
+		for (size_t v = 0; v < vertexCount; ++v) {
+			if (remap[v] != UINT32_MAX) {
+				std::memcpy(dst + remap[v] * elementSize, src + v * sourceStride, elementSize);
+			}
+		}
+	}
+
+}
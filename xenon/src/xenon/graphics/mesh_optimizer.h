@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace xe {
+
+	// Post-transform cache size assumed by the optimizer and statistics (FIFO)
+	#define XE_VERTEX_CACHE_SIZE 16
+	// Overdraw optimization may make the vertex cache efficiency at most this much worse (1.05 = 5%)
+	#define XE_OVERDRAW_THRESHOLD 1.05f
+
+	//----------------------------------------
+	// SECTION: Mesh statistics
+	//----------------------------------------
+
+	struct VertexCacheStats {
+		float acmr = 0.0f;  // Average cache miss ratio, transformed vertices per triangle (0.5 - 3.0)
+		float atvr = 0.0f;  // Average transform to vertex ratio, transformed vertices per referenced vertex (1.0 is optimal)
+	};
+
+	VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = XE_VERTEX_CACHE_SIZE);
+
+
+	//----------------------------------------
+	// SECTION: Mesh optimization
+	//----------------------------------------
+
+	/*
+		Import time triangle list optimization, intended to be run in order:
+		1. optimizeVertexCache reorders triangles for the post-transform vertex cache (Tipsify, Sander et al. 2007)
+		2. optimizeOverdraw reorders clusters of triangles front to back while keeping most of the cache efficiency
+		3. optimizeVertexFetch reorders vertices by first use so vertex fetches are mostly sequential
+	*/
+
+	void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = XE_VERTEX_CACHE_SIZE);
+
+	// positions: float xyz per vertex, positionStride in bytes (0 = tightly packed)
+	void optimizeOverdraw(std::vector<uint32_t>& indices, const float* positions, size_t vertexCount, size_t positionStride, float threshold = XE_OVERDRAW_THRESHOLD);
+
+	// Rewrites the indices and returns the old to new vertex remap table, unreferenced vertices map to UINT32_MAX
+	std::vector<uint32_t> optimizeVertexFetch(std::vector<uint32_t>& indices, size_t vertexCount, size_t& outputVertexCount);
+
+	// Copies vertexCount elements of elementSize bytes (source stride in bytes) into tightly packed destination order
+	void remapVertexBuffer(void* destination, const void* source, size_t vertexCount, size_t elementSize, size_t sourceStride, const std::vector<uint32_t>& remap);
+
+}
@@ -0,0 +1,280 @@
+#include "mesh_simplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+
+namespace xe {
+
+	//----------------------------------------
+	// SECTION: Quadrics
+	//----------------------------------------
+
+	// NOTE: Quadrics are accumulated in double precision, float is not enough for large meshes
+	struct Quadric {
+		// Upper triangle of the symmetric 4x4 matrix
+		double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+		double a11 = 0, a12 = 0, a13 = 0;
+		double a22 = 0, a23 = 0;
+		double a33 = 0;
+	};
+
+	static void addPlaneQuadric(Quadric& q, double a, double b, double c, double d) {
+		q.a00 += a * a; q.a01 += a * b; q.a02 += a * c; q.a03 += a * d;
+		q.a11 += b * b; q.a12 += b * c; q.a13 += b * d;
+		q.a22 += c * c; q.a23 += c * d;
+		q.a33 += d * d;
+	}
+
+	static void addQuadric(Quadric& target, const Quadric& q) {
+		target.a00 += q.a00; target.a01 += q.a01; target.a02 += q.a02; target.a03 += q.a03;
+		target.a11 += q.a11; target.a12 += q.a12; target.a13 += q.a13;
+		target.a22 += q.a22; target.a23 += q.a23;
+		target.a33 += q.a33;
+	}
+
+	// Sum of squared distances from the point to all planes in the quadric
+	static double evaluateQuadric(const Quadric& q, const float* p) {
+		double x = p[0], y = p[1], z = p[2];
+		return q.a00 * x * x + 2 * q.a01 * x * y + 2 * q.a02 * x * z + 2 * q.a03 * x
+			+ q.a11 * y * y + 2 * q.a12 * y * z + 2 * q.a13 * y
+			+ q.a22 * z * z + 2 * q.a23 * z
+			+ q.a33;
+	}
+
+	static void triangleNormal(const float* p0, const float* p1, const float* p2, double* normal) {
+		double e1[3] = { (double)p1[0] - p0[0], (double)p1[1] - p0[1], (double)p1[2] - p0[2] };
+		double e2[3] = { (double)p2[0] - p0[0], (double)p2[1] - p0[1], (double)p2[2] - p0[2] };
+		normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+		normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+		normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+	}
+
+
+	//----------------------------------------
+	// SECTION: Mesh simplification
+	//----------------------------------------
+
+	struct PositionKey {
+		uint32_t x, y, z;
+
+		bool operator==(const PositionKey& other) const {
+			return x == other.x && y == other.y && z == other.z;
+		}
+	};
+
+	struct PositionKeyHash {
+		size_t operator()(const PositionKey& key) const {
+			return (size_t)key.x * 73856093u ^ (size_t)key.y * 19349663u ^ (size_t)key.z * 83492791u;
+		}
+	};
+
+	struct Collapse {
+		uint32_t from;
+		uint32_t to;
+		double cost;
+	};
+
+	SimplifyResult simplifyMesh(const std::vector<uint32_t>& indices, const float* positions, size_t vertexCount, size_t positionStride, size_t targetIndexCount) {
+		SimplifyResult result;
+		result.indices = indices;
+
+		if (indices.size() <= targetIndexCount || indices.size() % 3 != 0 || vertexCount == 0) {
+			return result;
+		}
+		if (positionStride == 0) {
+			positionStride = sizeof(float) * 3;
+		}
+
+		auto position = [&](uint32_t vertex) {
+			return reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + vertex * positionStride);
+		};
+
+		// Vertices sharing a position (attribute seams) are grouped under a canonical vertex
+		std::vector<uint32_t> canonical(vertexCount);
+		std::vector<uint8_t> locked(vertexCount, 0);  // Indexed by canonical vertex
+		{
+			std::unordered_map<PositionKey, uint32_t, PositionKeyHash> positionMap;
+			positionMap.reserve(vertexCount);
+			for (uint32_t v = 0; v < vertexCount; ++v) {
+				PositionKey key;
+				std::memcpy(&key, position(v), sizeof(PositionKey));
+				auto [it, inserted] = positionMap.emplace(key, v);
+				canonical[v] = it->second;
+				if (!inserted) {
+					locked[it->second] = 1;
+				}
+			}
+		}
+
+		// Lock border vertices (edges only used by a single triangle)
+		{
+			std::unordered_map<uint64_t, uint32_t> edgeCounts;
+			edgeCounts.reserve(indices.size());
+			for (size_t i = 0; i < indices.size(); i += 3) {
+				for (size_t e = 0; e < 3; ++e) {
+					uint64_t a = canonical[indices[i + e]];
+					uint64_t b = canonical[indices[i + (e + 1) % 3]];
+					++edgeCounts[a < b ? (a << 32 | b) : (b << 32 | a)];
+				}
+			}
+			for (const auto& [edge, count] : edgeCounts) {
+				if (count == 1) {
+					locked[edge >> 32] = 1;
+					locked[edge & 0xFFFFFFFF] = 1;
+				}
+			}
+		}
+
+		// Plane quadrics, accumulated per canonical vertex
+		std::vector<Quadric> quadrics(vertexCount);
+		for (size_t i = 0; i < indices.size(); i += 3) {
+			const float* p0 = position(indices[i + 0]);
+			double normal[3];
+			triangleNormal(p0, position(indices[i + 1]), position(indices[i + 2]), normal);
+			double length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			if (length == 0.0) {
+				continue;
+			}
+			double a = normal[0] / length, b = normal[1] / length, c = normal[2] / length;
+			double d = -(a * p0[0] + b * p0[1] + c * p0[2]);
+			for (size_t k = 0; k < 3; ++k) {
+				addPlaneQuadric(quadrics[canonical[indices[i + k]]], a, b, c, d);
+			}
+		}
+
+		std::vector<uint32_t>& current = result.indices;
+		std::vector<uint32_t> remap(vertexCount);
+		std::vector<uint8_t> touched(vertexCount);
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+		std::vector<uint32_t> adjacency;
+		std::vector<Collapse> collapses;
+		double maxCost = 0.0;
+
+		// Each pass collapses a set of non-overlapping edges, cheapest first
+		while (current.size() > targetIndexCount) {
+			size_t triangleCount = current.size() / 3;
+
+			// Vertex to triangle adjacency
+			std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+			for (uint32_t index : current) {
+				++adjacencyOffsets[index + 1];
+			}
+			std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+			adjacency.resize(current.size());
+			{
+				std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+				for (size_t i = 0; i < current.size(); ++i) {
+					adjacency[fill[current[i]]++] = (uint32_t)(i / 3);
+				}
+			}
+
+			// Collapse candidates
+			collapses.clear();
+			for (size_t i = 0; i < current.size(); i += 3) {
+				for (size_t e = 0; e < 3; ++e) {
+					uint32_t a = current[i + e];
+					uint32_t b = current[i + (e + 1) % 3];
+					for (int direction = 0; direction < 2; ++direction) {
+						uint32_t from = direction == 0 ? a : b;
+						uint32_t to = direction == 0 ? b : a;
+						if (locked[canonical[from]] || canonical[from] == canonical[to]) {
+							continue;
+						}
+						Quadric q = quadrics[canonical[from]];
+						addQuadric(q, quadrics[canonical[to]]);
+						collapses.push_back(Collapse{ from, to, std::max(evaluateQuadric(q, position(to)), 0.0) });
+					}
+				}
+			}
+			if (collapses.empty()) {
+				break;
+			}
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+			size_t trianglesToRemove = (current.size() - targetIndexCount + 2) / 3;
+			size_t removed = 0;
+			std::fill(touched.begin(), touched.end(), 0);
+			std::iota(remap.begin(), remap.end(), 0);
+
+			for (const Collapse& collapse : collapses) {
+				if (removed >= trianglesToRemove) {
+					break;
+				}
+				if (touched[collapse.from] || touched[collapse.to]) {
+					continue;
+				}
+
+				// Reject collapses that flip or degenerate neighbouring triangles
+				bool valid = true;
+				size_t collapsedTriangles = 0;
+				for (uint32_t a = adjacencyOffsets[collapse.from]; a < adjacencyOffsets[collapse.from + 1] && valid; ++a) {
+					const uint32_t* triangle = &current[adjacency[a] * 3];
+					if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to) {
+						++collapsedTriangles;
+						continue;
+					}
+
+					const float* before[3];
+					const float* after[3];
+					for (size_t k = 0; k < 3; ++k) {
+						if (remap[triangle[k]] != triangle[k]) {
+							valid = false;  // Neighbour already moved this pass
+						}
+						before[k] = position(triangle[k]);
+						after[k] = triangle[k] == collapse.from ? position(collapse.to) : before[k];
+					}
+
+					double normalBefore[3], normalAfter[3];
+					triangleNormal(before[0], before[1], before[2], normalBefore);
+					triangleNormal(after[0], after[1], after[2], normalAfter);
+					double dot = normalBefore[0] * normalAfter[0] + normalBefore[1] * normalAfter[1] + normalBefore[2] * normalAfter[2];
+					double lengthAfter = normalAfter[0] * normalAfter[0] + normalAfter[1] * normalAfter[1] + normalAfter[2] * normalAfter[2];
+					if (dot <= 0.0 || lengthAfter == 0.0) {
+						valid = false;
+					}
+				}
+				if (!valid) {
+					continue;
+				}
+
+				remap[collapse.from] = collapse.to;
+				touched[collapse.from] = 1;
+				touched[collapse.to] = 1;
+				for (uint32_t a = adjacencyOffsets[collapse.from]; a < adjacencyOffsets[collapse.from + 1]; ++a) {
+					const uint32_t* triangle = &current[adjacency[a] * 3];
+					touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = 1;
+				}
+
+				addQuadric(quadrics[canonical[collapse.to]], quadrics[canonical[collapse.from]]);
+				maxCost = std::max(maxCost, collapse.cost);
+				removed += collapsedTriangles;
+			}
+
+			// Apply collapses and drop degenerate triangles
+			size_t write = 0;
+			for (size_t i = 0; i < current.size(); i += 3) {
+				uint32_t a = remap[current[i + 0]];
+				uint32_t b = remap[current[i + 1]];
+				uint32_t c = remap[current[i + 2]];
+				if (a == b || b == c || a == c) {
+					continue;
+				}
+				current[write++] = a;
+				current[write++] = b;
+				current[write++] = c;
+			}
+			current.resize(write);
+
+			if (current.size() / 3 == triangleCount) {
+				break;  // No progress possible
+			}
+		}
+
+		result.error = (float)std::sqrt(maxCost);
+		return result;
+	}
+
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace xe {
+
+	//----------------------------------------
+	// SECTION: Mesh simplification
+	//----------------------------------------
+
+	/*
+		Quadric error metric edge collapse simplification (Garland & Heckbert). Vertices are only collapsed onto
+		other existing vertices, so the result is a new index buffer that references the original vertex data.
+		Vertices on attribute seams and mesh borders are locked to keep the silhouette and UV layout intact.
+	*/
+
+	struct SimplifyResult {
+		std::vector<uint32_t> indices;
+		float error = 0.0f;  // Largest collapse error in object space units
+	};
+
+	// positions: float xyz per vertex, positionStride in bytes (0 = tightly packed)
+	SimplifyResult simplifyMesh(const std::vector<uint32_t>& indices, const float* positions, size_t vertexCount, size_t positionStride, size_t targetIndexCount);
+
+}
@@ -0,0 +1,262 @@
+#include "mipmap.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+#include <ktx.h>
+#include <glad/gl.h>
+
+#include "xenon/core/log.h"
+#include "xenon/core/hash.h"
+#include "xenon/core/job_system.h"
+#include "xenon/core/profiler.h"
+
+namespace xe {
+
+	// VK_FORMAT_R8G8B8_UNORM / _SRGB and VK_FORMAT_R8G8B8A8_UNORM / _SRGB, KTX2 files describe their format with Vulkan formats
+	#define XE_MIPMAP_VK_FORMAT_RGB 23
+	#define XE_MIPMAP_VK_FORMAT_SRGB 29
+	#define XE_MIPMAP_VK_FORMAT_RGBA 37
+	#define XE_MIPMAP_VK_FORMAT_SRGBA 43
+
+	//----------------------------------------
+	// SECTION: Mipmap
+	//----------------------------------------
+
+	const std::array<float, 256>& getSRGBDecodeTable() {
+		static const std::array<float, 256> table = []() {
+			std::array<float, 256> values;
+			for (int i = 0; i < 256; ++i) {
+				float c = i / 255.0f;
+				values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+			}
+			return values;
+		}();
+		return table;
+	}
+
+	uint8_t encodeUnorm8(float value) {
+		return (uint8_t)(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+	}
+
+	uint8_t encodeSRGB8(float linear) {
+		float c = linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+		return encodeUnorm8(c);
+	}
+
+	void filterNormalTexel(const uint8_t* const texels[4], uint8_t* target) {
+		float n[3] = { 0.0f, 0.0f, 0.0f };
+		for (int i = 0; i < 4; ++i) {
+			for (int c = 0; c < 3; ++c) {
+				n[c] += texels[i][c] / 255.0f * 2.0f - 1.0f;
+			}
+		}
+
+		// Opposing normals cancel out, the flat normal is the least wrong answer then
+		float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		if (length < 1e-6f) {
+			n[0] = 0.0f;
+			n[1] = 0.0f;
+			n[2] = 1.0f;
+			length = 1.0f;
+		}
+		for (int c = 0; c < 3; ++c) {
+			target[c] = encodeUnorm8(n[c] / length * 0.5f + 0.5f);
+		}
+	}
+
+	MipmapFilter getTextureMipmapFilter(TextureFormat format, TextureUsage usage) {
+		if (usage == TextureUsage::NORMAL) {
+			return MipmapFilter::NORMAL;
+		}
+		if (format == TextureFormat::SRGB || format == TextureFormat::SRGBA) {
+			return MipmapFilter::SRGB;
+		}
+		return MipmapFilter::LINEAR;
+	}
+
+	int getMipLevelCount(int width, int height) {
+		int levels = 1;
+		for (int size = std::max(width, height); size > 1; size /= 2) {
+			++levels;
+		}
+		return levels;
+	}
+
+	void downsampleMipLevel(const uint8_t* source, int width, int height, int channels, MipmapFilter filter, MipLevel& target) {
+		target.width = std::max(width / 2, 1);
+		target.height = std::max(height / 2, 1);
+		target.pixels.resize((size_t)target.width * target.height * channels);
+
+		const std::array<float, 256>& decode = getSRGBDecodeTable();
+		// Alpha is stored linearly by GL_SRGB8_ALPHA8 and normal maps alike
+		int vectorChannels = channels == 4 ? 3 : channels;
+		bool normal = filter == MipmapFilter::NORMAL && channels >= 3;
+
+		parallelFor((uint32_t)target.height, XE_MIPMAP_ROWS_PER_JOB, [&](uint32_t begin, uint32_t end) {
+			XE_PROFILE_SCOPE("downsampleMipLevel rows");
+			for (uint32_t y = begin; y < end; ++y) {
+				const uint8_t* row0 = source + (size_t)std::min((int)y * 2, height - 1) * width * channels;
+				const uint8_t* row1 = source + (size_t)std::min((int)y * 2 + 1, height - 1) * width * channels;
+				uint8_t* out = target.pixels.data() + (size_t)y * target.width * channels;
+
+				for (int x = 0; x < target.width; ++x, out += channels) {
+					int x0 = std::min(x * 2, width - 1) * channels;
+					int x1 = std::min(x * 2 + 1, width - 1) * channels;
+					const uint8_t* const texels[4] = { row0 + x0, row0 + x1, row1 + x0, row1 + x1 };
+
+					int c = 0;
+					if (normal) {
+						filterNormalTexel(texels, out);
+						c = 3;
+					}
+					else if (filter == MipmapFilter::SRGB) {
+						for (; c < vectorChannels; ++c) {
+							float sum = decode[texels[0][c]] + decode[texels[1][c]] + decode[texels[2][c]] + decode[texels[3][c]];
+							out[c] = encodeSRGB8(sum * 0.25f);
+						}
+					}
+					for (; c < channels; ++c) {
+						out[c] = (uint8_t)((texels[0][c] + texels[1][c] + texels[2][c] + texels[3][c] + 2) / 4);
+					}
+				}
+			}
+		});
+	}
+
+	std::vector<MipLevel> generateMipChain(const uint8_t* pixels, int width, int height, int channels, MipmapFilter filter) {
+		XE_PROFILE_FUNCTION();
+		std::vector<MipLevel> levels(getMipLevelCount(width, height) - 1);
+
+		const uint8_t* source = pixels;
+		for (MipLevel& level : levels) {
+			downsampleMipLevel(source, width, height, channels, filter, level);
+			source = level.pixels.data();
+			width = level.width;
+			height = level.height;
+		}
+		return levels;
+	}
+
+
+	//----------------------------------------
+	// SECTION: Mip chain cache
+	//----------------------------------------
+
+	uint32_t getMipChainVkFormat(int channels, MipmapFilter filter) {
+		bool srgb = filter == MipmapFilter::SRGB;
+		if (channels == 3) {
+			return srgb ? XE_MIPMAP_VK_FORMAT_SRGB : XE_MIPMAP_VK_FORMAT_RGB;
+		}
+		return srgb ? XE_MIPMAP_VK_FORMAT_SRGBA : XE_MIPMAP_VK_FORMAT_RGBA;
+	}
+
+	std::string getMipChainCachePath(uint64_t key) {
+		char name[32];
+		std::snprintf(name, sizeof(name), "%016llx.ktx2", (unsigned long long)key);
+		return std::string(XE_MIPMAP_CACHE_DIRECTORY) + name;
+	}
+
+	uint64_t hashMipChainSource(const uint8_t* pixels, int width, int height, int channels, MipmapFilter filter) {
+		XE_PROFILE_FUNCTION();
+		uint64_t hash = hashBytes(pixels, (size_t)width * height * channels);
+		hash = hashValue(hash, XE_MIPMAP_CACHE_VERSION);
+		hash = hashValue(hash, (uint64_t)width);
+		hash = hashValue(hash, (uint64_t)height);
+		hash = hashValue(hash, (uint64_t)channels);
+		return hashValue(hash, (uint64_t)filter);
+	}
+
+	bool loadMipChainCache(uint64_t key, int width, int height, int channels, MipmapFilter filter, std::vector<MipLevel>& levels) {
+		XE_PROFILE_FUNCTION();
+		if (channels != 3 && channels != 4) {
+			return false;
+		}
+
+		std::string path = getMipChainCachePath(key);
+		ktxTexture* cache = nullptr;
+		if (!std::filesystem::exists(path)
+			|| ktxTexture_CreateFromNamedFile(path.c_str(), KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, &cache) != KTX_SUCCESS) {
+			return false;
+		}
+
+		int count = getMipLevelCount(width, height) - 1;
+		bool valid = count > 0
+			&& cache->classId == ktxTexture2_c
+			&& ((ktxTexture2*)cache)->vkFormat == getMipChainVkFormat(channels, filter)
+			&& cache->numLevels == (ktx_uint32_t)count
+			&& cache->baseWidth == (ktx_uint32_t)std::max(width / 2, 1)
+			&& cache->baseHeight == (ktx_uint32_t)std::max(height / 2, 1);
+
+		if (valid) {
+			const uint8_t* data = ktxTexture_GetData(cache);
+			ktx_size_t dataSize = ktxTexture_GetDataSize(cache);
+			levels.resize(count);
+			for (int i = 0; i < count && valid; ++i) {
+				MipLevel& level = levels[i];
+				level.width = std::max((int)cache->baseWidth >> i, 1);
+				level.height = std::max((int)cache->baseHeight >> i, 1);
+				size_t size = (size_t)level.width * level.height * channels;
+
+				ktx_size_t offset = 0;
+				valid = ktxTexture_GetImageOffset(cache, i, 0, 0, &offset) == KTX_SUCCESS && offset + size <= dataSize;
+				if (valid) {
+					level.pixels.assign(data + offset, data + offset + size);
+				}
+			}
+		}
+		ktxTexture_Destroy(cache);
+
+		if (!valid) {
+			XE_LOG_WARN_F("MIPMAP: Cache {} does not match its source, generating again", path);
+			levels.clear();
+		}
+		return valid;
+	}
+
+	void writeMipChainCache(uint64_t key, int channels, MipmapFilter filter, std::vector<MipLevel> levels) {
+		if (levels.empty() || (channels != 3 && channels != 4)) {
+			return;
+		}
+
+		submitJob([key, channels, filter, levels = std::move(levels)]() {
+			XE_PROFILE_SCOPE("writeMipChainCache");
+			ktxTextureCreateInfo info = {};
+			info.glInternalformat = filter == MipmapFilter::SRGB
+				? (channels == 3 ? GL_SRGB8 : GL_SRGB8_ALPHA8)
+				: (channels == 3 ? GL_RGB8 : GL_RGBA8);
+			info.vkFormat = getMipChainVkFormat(channels, filter);
+			info.baseWidth = (ktx_uint32_t)levels[0].width;
+			info.baseHeight = (ktx_uint32_t)levels[0].height;
+			info.baseDepth = 1;
+			info.numDimensions = 2;
+			info.numLevels = (ktx_uint32_t)levels.size();
+			info.numLayers = 1;
+			info.numFaces = 1;
+			info.isArray = KTX_FALSE;
+			info.generateMipmaps = KTX_FALSE;
+
+			std::string path = getMipChainCachePath(key);
+			ktxTexture2* cache = nullptr;
+			if (ktxTexture2_Create(&info, KTX_TEXTURE_CREATE_ALLOC_STORAGE, &cache) != KTX_SUCCESS) {
+				XE_LOG_ERROR_F("MIPMAP: Failed to create the cache {}", path);
+				return;
+			}
+			for (size_t i = 0; i < levels.size(); ++i) {
+				ktxTexture_SetImageFromMemory(ktxTexture(cache), (ktx_uint32_t)i, 0, 0, levels[i].pixels.data(), levels[i].pixels.size());
+			}
+
+			std::error_code error;
+			std::filesystem::create_directories(XE_MIPMAP_CACHE_DIRECTORY, error);
+			if (ktxTexture_WriteToNamedFile(ktxTexture(cache), path.c_str()) != KTX_SUCCESS) {
+				XE_LOG_ERROR_F("MIPMAP: Failed to write the cache {}", path);
+			}
+			ktxTexture_Destroy(ktxTexture(cache));
+		});
+	}
+
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "xenon/graphics/texture.h"
+
+namespace xe {
+
+	// Rows of a destination level filtered by one job
+	#define XE_MIPMAP_ROWS_PER_JOB 16
+	// Directory of cached mip chains, relative to the working directory
+	#define XE_MIPMAP_CACHE_DIRECTORY "cache/textures/"
+	// Part of the cache key, increment when the filters change
+	#define XE_MIPMAP_CACHE_VERSION 1
+
+	//----------------------------------------
+	// SECTION: Mipmap
+	//----------------------------------------
+
+	/*
+		Mip chains of 8 bit textures generated on the CPU at import. glGenerateTextureMipmap averages the stored
+		values, which darkens sRGB textures and shortens normals, so the chains are filtered here instead:
+
+		- LINEAR: 2x2 box filter of the stored values (data textures, metallic roughness, occlusion).
+		- SRGB: color channels are decoded to linear light before averaging and encoded again, alpha is linear.
+		- NORMAL: the vectors are decoded from [0, 1] to [-1, 1], averaged and renormalized.
+
+		Each level is filtered from the one above it with the job system. Chains are cached as KTX2 files keyed by
+		a hash of the source pixels, so later imports only read them. The cache holds levels 1 to n, level 0 is
+		always the source itself.
+	*/
+
+	enum class MipmapFilter : uint8_t {
+		LINEAR	= 0,
+		SRGB	= 1,
+		NORMAL	= 2
+	};
+
+	struct MipLevel {
+		int width;
+		int height;
+		std::vector<uint8_t> pixels;
+	};
+
+	MipmapFilter getTextureMipmapFilter(TextureFormat format, TextureUsage usage);
+
+	// Levels of a full chain down to 1x1, level 0 included
+	int getMipLevelCount(int width, int height);
+
+	// Tightly packed level below source (half size, at least 1), odd edges are clamped
+	void downsampleMipLevel(const uint8_t* source, int width, int height, int channels, MipmapFilter filter, MipLevel& target);
+	// Levels 1 to n of the chain of the source
+	std::vector<MipLevel> generateMipChain(const uint8_t* pixels, int width, int height, int channels, MipmapFilter filter);
+
+
+	//----------------------------------------
+	// SECTION: Mip chain cache
+	//----------------------------------------
+
+	// Key of the chain, the source pixels and the filter settings
+	uint64_t hashMipChainSource(const uint8_t* pixels, int width, int height, int channels, MipmapFilter filter);
+
+	// Levels 1 to n from the cache, false when there is no valid cache for the key
+	bool loadMipChainCache(uint64_t key, int width, int height, int channels, MipmapFilter filter, std::vector<MipLevel>& levels);
+	// Writes the levels from a job, only 3 and 4 channel chains are cached
+	void writeMipChainCache(uint64_t key, int channels, MipmapFilter filter, std::vector<MipLevel> levels);
+
+}
@@ -1,31 +1,65 @@
 #include "model.h"
 
+#include <set>
+
 #include "xenon/core/log.h"
 #include "xenon/graphics/model_loader.h"
+#include "xenon/graphics/gl_state.h"
 
 namespace xe {
 
 	void destroyModel(Model* model) {
 		XE_LOG_TRACE_F("MODEL: Destroying model: {}", model->metadata.path);
 
+		// Buffer views can back several attributes and element buffers, each buffer is deleted once
+		std::set<GLuint> buffers;
 		for (const Primitive& primitive : model->primitives) {
+			forgetGLVertexArray(primitive.vao);
 			glDeleteVertexArrays(1, &primitive.vao);
 			if (primitive.ebo) {
-				glDeleteBuffers(1, &primitive.ebo);
+				buffers.insert(primitive.ebo);
 			}
 		}
 
 		for (const PrimitiveAttributeArray& attributeArray : model->primitiveAttributes) {
 			for (const PrimitiveAttribute& attribute : attributeArray) {
 				if (attribute.vbo) {
-					glDeleteBuffers(1, &attribute.vbo);
+					buffers.insert(attribute.vbo);
 				}
 			}
 		}
 
+		for (GLuint buffer : buffers) {
+			glDeleteBuffers(1, &buffer);
+		}
+
 		delete model;
 	}
 
+	void updateModelMatrices(Model* model) {
+		model->nodeMatrices.resize(model->nodes.size());
+		model->primitiveMatrices.resize(model->primitiveIndices.size());
+
+		size_t primitiveCounter = 0;
+		for (size_t i = 0; i < model->nodes.size(); ++i) {
+			const ModelNode& node = model->nodes[i];
+
+			// NOTE: Nodes are sorted so the parent matrix is always evaluated before its children
+			if (i == 0) {
+				model->nodeMatrices[i] = model->localPositions[i];
+			}
+			else {
+				model->nodeMatrices[i] = model->nodeMatrices[node.parent] * model->localPositions[i];
+			}
+
+			// pii = primitiveIndicesIndex
+			for (size_t pii = primitiveCounter; pii < primitiveCounter + node.primitiveCount; ++pii) {
+				model->primitiveMatrices[pii] = model->nodeMatrices[i];
+			}
+			primitiveCounter += node.primitiveCount;
+		}
+	}
+
 	void ModelSerializer::serialize(Asset* asset) const {
 		// TODO: Implement
 		XE_LOG_ERROR("Model serialization is not yet implemented.");
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <vector>
 
@@ -26,18 +27,37 @@ namespace xe {
 		std::vector<glm::mat4x4> localPositions;
 		std::vector<size_t> primitiveIndices;
 
+		// NOTE: Model space matrix for each entry in primitiveIndices (flattened node hierarchy)
+		std::vector<glm::mat4x4> primitiveMatrices;
+		// NOTE: Model space matrix for each node, kept to avoid allocations when the hierarchy is re-evaluated
+		std::vector<glm::mat4x4> nodeMatrices;
+		// Static models never change localPositions after load, primitiveMatrices is only evaluated once
+		bool isStatic = true;
+
+		// NOTE: Built once per glTF mesh primitive, nodes instancing the same mesh share them through primitiveIndices
 		std::vector<Primitive> primitives;
 		std::vector<Material> materials;
 		std::vector<PrimitiveAttributeArray> primitiveAttributes;
 
 		BoundingBox bounds;
+
+		// Largest primitive error for each detail level in model space (node scale applied), used for LOD selection
+		std::array<float, XE_MAX_PRIMITIVE_LODS> lodErrors = {};
+		uint8_t lodCount = 1;
 	};
 
 	void destroyModel(Model* model);
 
+	// Re-evaluates nodeMatrices and primitiveMatrices from localPositions
+	void updateModelMatrices(Model* model);
+
 	struct ModelComponent {
 		Model* model = nullptr;
 		bool wireframe = false;
+		float lodBias = 0.0f;  // Positive values switch to lower detail levels earlier
+
+		// Runtime
+		uint8_t currentLOD = 0;
 	};
 
 	struct ModelSerializer : AssetSerializer {
@@ -1,13 +1,18 @@
 #include "model_loader.h"
 
 #include <queue>
+#include <set>
 
 #include <tiny_gltf.h>
 #include <glm/gtc/type_ptr.hpp>
 
 #include "xenon/core/log.h"
 #include "xenon/core/assert.h"
+#include "xenon/core/profiler.h"
 #include "xenon/graphics/material.h"
+#include "xenon/graphics/mesh_optimizer.h"
+#include "xenon/graphics/mesh_simplifier.h"
+#include "xenon/graphics/vertex_quantization.h"
 
 #include "xenon/core/asset_manager.h"
 
@@ -33,7 +38,7 @@ namespace xe {
 	}
 
 	template<typename T>
-	Texture* loadTextureIfExists(AssetManager* manager, const tinygltf::Model& model, const T& info, const std::string& path, bool srgb = false) {
+	Texture* loadTextureIfExists(AssetManager* manager, const tinygltf::Model& model, const T& info, const std::string& path, bool srgb = false, TextureUsage usage = TextureUsage::COLOR) {
 		if (info.index == -1) {
 			return nullptr;
 		}
@@ -41,10 +46,12 @@ namespace xe {
 		const tinygltf::Texture& texture = model.textures[info.index];
 		const tinygltf::Image& image = model.images[texture.source];
 
+		// glTF leaves the filter to the implementation when it is undefined, trilinear keeps distant surfaces stable
 		TextureParameters textureParameters;
+		textureParameters.minFilter = GL_LINEAR_MIPMAP_LINEAR;
 		if (texture.sampler >= 0) {
 			const tinygltf::Sampler& sampler = model.samplers[texture.sampler];
-			textureParameters.minFilter = sampler.minFilter == -1 ? GL_LINEAR : sampler.minFilter;
+			textureParameters.minFilter = sampler.minFilter == -1 ? GL_LINEAR_MIPMAP_LINEAR : sampler.minFilter;
 			textureParameters.magFilter = sampler.magFilter == -1 ? GL_LINEAR : sampler.magFilter;
 			textureParameters.wrapS = sampler.wrapS;
 			textureParameters.wrapT = sampler.wrapT;
@@ -55,16 +62,297 @@ namespace xe {
 		// TODO: Add multi-texture-coordinate support: info.texCoord
 		// TODO: Improve texture signature
 		// std::string signature = TEXTURE_INTERNAL_SIGNATURE + std::to_string(info.index) + ":" + std::to_string((int)type) + ":" + path;
-		return createInternalTextureAsset(manager, path, std::to_string(info.index), image.image.data(), image.width, image.height, image.component, format, textureParameters);
+		return createInternalTextureAsset(manager, path, std::to_string(info.index), image.image.data(), image.width, image.height, image.component, format, textureParameters, usage);
 	}
 
+	std::vector<uint32_t> readIndices(const tinygltf::Model& model, const tinygltf::Accessor& accessor) {
+		const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
+		const unsigned char* data = model.buffers[bufferView.buffer].data.data() + bufferView.byteOffset + accessor.byteOffset;
+
+		std::vector<uint32_t> indices(accessor.count);
+		for (size_t i = 0; i < accessor.count; ++i) {
+			if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE) {
+				indices[i] = data[i];
+			}
+			else if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT) {
+				indices[i] = reinterpret_cast<const uint16_t*>(data)[i];
+			}
+			else {
+				indices[i] = reinterpret_cast<const uint32_t*>(data)[i];
+			}
+		}
+		return indices;
+	}
+
+	// Import time optimized copy of an indexed triangle primitive, attributes are reordered into tightly packed buffers
+	struct OptimizedMesh {
+		std::vector<uint32_t> indices;
+		std::vector<uint32_t> remap;  // Original to optimized vertex index
+		std::vector<float> positions;
+		size_t vertexCount = 0;
+
+		// VertexFormat::QUANTIZED, requires float attributes
+		bool quantized = false;
+		glm::vec3 positionOffset = glm::vec3(0.0f);
+		glm::vec3 positionScale = glm::vec3(1.0f);
+
+		VertexCacheStats before;
+		VertexCacheStats after;
+	};
+
+	bool canQuantizePrimitive(const tinygltf::Model& model, const tinygltf::Primitive& gltfPrimitive) {
+		for (const auto& [attribute, accessorIndex] : gltfPrimitive.attributes) {
+			const tinygltf::Accessor& accessor = model.accessors[accessorIndex];
+			int expectedType = -1;
+			if (attribute.compare("TANGENT") == 0) expectedType = TINYGLTF_TYPE_VEC4;
+			if (attribute.compare("NORMAL") == 0) expectedType = TINYGLTF_TYPE_VEC3;
+			if (attribute.compare("TEXCOORD_0") == 0) expectedType = TINYGLTF_TYPE_VEC2;
+
+			if (expectedType != -1 && (accessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT || accessor.type != expectedType)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool optimizePrimitiveMesh(const tinygltf::Model& model, const tinygltf::Primitive& gltfPrimitive, const ModelImportSettings& settings, OptimizedMesh& mesh) {
+		if (gltfPrimitive.mode != TINYGLTF_MODE_TRIANGLES || gltfPrimitive.indices < 0 || gltfPrimitive.attributes.count("POSITION") == 0) {
+			return false;
+		}
+
+		const tinygltf::Accessor& positionAccessor = model.accessors[gltfPrimitive.attributes.at("POSITION")];
+		if (positionAccessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT || positionAccessor.type != TINYGLTF_TYPE_VEC3) {
+			return false;
+		}
+		// Every attribute is rewritten, so they all need to be plain per vertex arrays
+		for (const auto& [attribute, accessorIndex] : gltfPrimitive.attributes) {
+			const tinygltf::Accessor& accessor = model.accessors[accessorIndex];
+			if (accessor.bufferView < 0 || accessor.sparse.isSparse || accessor.count != positionAccessor.count) {
+				return false;
+			}
+		}
+
+		const tinygltf::BufferView& positionView = model.bufferViews[positionAccessor.bufferView];
+		const float* positions = reinterpret_cast<const float*>(model.buffers[positionView.buffer].data.data() + positionView.byteOffset + positionAccessor.byteOffset);
+		size_t positionStride = positionAccessor.ByteStride(positionView);
+
+		mesh.indices = readIndices(model, model.accessors[gltfPrimitive.indices]);
+		mesh.before = analyzeVertexCache(mesh.indices, positionAccessor.count);
+
+		optimizeVertexCache(mesh.indices, positionAccessor.count);
+		optimizeOverdraw(mesh.indices, positions, positionAccessor.count, positionStride);
+		mesh.remap = optimizeVertexFetch(mesh.indices, positionAccessor.count, mesh.vertexCount);
+
+		mesh.positions.resize(mesh.vertexCount * 3);
+		remapVertexBuffer(mesh.positions.data(), positions, positionAccessor.count, sizeof(float) * 3, positionStride, mesh.remap);
+
+		mesh.after = analyzeVertexCache(mesh.indices, mesh.vertexCount);
+
+		if (settings.quantizeVertices && mesh.vertexCount > 0 && canQuantizePrimitive(model, gltfPrimitive)) {
+			glm::vec3 min = glm::make_vec3(mesh.positions.data());
+			glm::vec3 max = min;
+			for (size_t v = 1; v < mesh.vertexCount; ++v) {
+				glm::vec3 position = glm::make_vec3(&mesh.positions[v * 3]);
+				min = glm::min(min, position);
+				max = glm::max(max, position);
+			}
+			mesh.quantized = true;
+			mesh.positionOffset = min;
+			mesh.positionScale = max - min;
+		}
+		return true;
+	}
+
+	// See Primitive::uvDensity, measured in the units of the vertex positions like the primitive bounds
+	float computePrimitiveUVDensity(const tinygltf::Model& model, const tinygltf::Primitive& gltfPrimitive) {
+		auto positionIt = gltfPrimitive.attributes.find("POSITION");
+		auto texcoordIt = gltfPrimitive.attributes.find("TEXCOORD_0");
+		if (gltfPrimitive.mode != TINYGLTF_MODE_TRIANGLES || positionIt == gltfPrimitive.attributes.end() || texcoordIt == gltfPrimitive.attributes.end()) {
+			return 0.0f;
+		}
+
+		const tinygltf::Accessor& positionAccessor = model.accessors[positionIt->second];
+		const tinygltf::Accessor& texcoordAccessor = model.accessors[texcoordIt->second];
+		if (positionAccessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT || positionAccessor.type != TINYGLTF_TYPE_VEC3
+			|| texcoordAccessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT || texcoordAccessor.type != TINYGLTF_TYPE_VEC2
+			|| positionAccessor.bufferView < 0 || texcoordAccessor.bufferView < 0
+			|| positionAccessor.sparse.isSparse || texcoordAccessor.sparse.isSparse) {
+			return 0.0f;
+		}
+
+		const tinygltf::BufferView& positionView = model.bufferViews[positionAccessor.bufferView];
+		const tinygltf::BufferView& texcoordView = model.bufferViews[texcoordAccessor.bufferView];
+		const unsigned char* positions = model.buffers[positionView.buffer].data.data() + positionView.byteOffset + positionAccessor.byteOffset;
+		const unsigned char* texcoords = model.buffers[texcoordView.buffer].data.data() + texcoordView.byteOffset + texcoordAccessor.byteOffset;
+		size_t positionStride = positionAccessor.ByteStride(positionView);
+		size_t texcoordStride = texcoordAccessor.ByteStride(texcoordView);
+
+		std::vector<uint32_t> indices;
+		if (gltfPrimitive.indices >= 0) {
+			indices = readIndices(model, model.accessors[gltfPrimitive.indices]);
+		}
+		else {
+			indices.resize(positionAccessor.count);
+			for (size_t i = 0; i < indices.size(); ++i) {
+				indices[i] = (uint32_t)i;
+			}
+		}
+
+		double modelArea = 0.0;
+		double uvArea = 0.0;
+		for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+			glm::vec3 p[3];
+			glm::vec2 uv[3];
+			for (int corner = 0; corner < 3; ++corner) {
+				uint32_t index = indices[i + corner];
+				p[corner] = glm::make_vec3(reinterpret_cast<const float*>(positions + index * positionStride));
+				uv[corner] = glm::make_vec2(reinterpret_cast<const float*>(texcoords + index * texcoordStride));
+			}
+			modelArea += 0.5 * glm::length(glm::cross(p[1] - p[0], p[2] - p[0]));
+			glm::vec2 e1 = uv[1] - uv[0];
+			glm::vec2 e2 = uv[2] - uv[0];
+			uvArea += 0.5 * glm::abs(e1.x * e2.y - e1.y * e2.x);
+		}
+
+		if (modelArea <= 0.0 || uvArea <= 0.0) {
+			return 0.0f;
+		}
+		return (float)glm::sqrt(uvArea / modelArea);
+	}
+
+	// Creates a tightly packed copy of the attribute in optimized vertex order, quantized if the mesh is
+	GLuint createOptimizedAttributeBuffer(const tinygltf::Model& model, const tinygltf::Accessor& accessor, PrimitiveAttributeType type, const OptimizedMesh& mesh, size_t& outputStride) {
+		const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
+		const unsigned char* source = model.buffers[bufferView.buffer].data.data() + bufferView.byteOffset + accessor.byteOffset;
+		size_t elementSize = (size_t)tinygltf::GetComponentSizeInBytes(accessor.componentType) * tinygltf::GetNumComponentsInType(accessor.type);
+
+		std::vector<uint8_t> data(mesh.vertexCount * elementSize);
+		remapVertexBuffer(data.data(), source, accessor.count, elementSize, accessor.ByteStride(bufferView), mesh.remap);
+
+		if (mesh.quantized) {
+			const float* floats = reinterpret_cast<const float*>(data.data());
+			std::vector<uint8_t> quantized;
+			switch (type) {
+			case PrimitiveAttributeType::POSITION:
+				elementSize = sizeof(uint16_t) * 4;
+				quantized.resize(mesh.vertexCount * elementSize);
+				quantizePositions(floats, mesh.vertexCount, mesh.positionOffset, mesh.positionScale, reinterpret_cast<uint16_t*>(quantized.data()));
+				break;
+			case PrimitiveAttributeType::TANGENT:
+				elementSize = sizeof(int16_t) * 2;
+				quantized.resize(mesh.vertexCount * elementSize);
+				encodeOctahedralTangents(floats, mesh.vertexCount, reinterpret_cast<int16_t*>(quantized.data()));
+				break;
+			case PrimitiveAttributeType::NORMAL:
+				elementSize = sizeof(int16_t) * 2;
+				quantized.resize(mesh.vertexCount * elementSize);
+				encodeOctahedralNormals(floats, mesh.vertexCount, reinterpret_cast<int16_t*>(quantized.data()));
+				break;
+			case PrimitiveAttributeType::TEXCOORD_0:
+				elementSize = sizeof(uint16_t) * 2;
+				quantized.resize(mesh.vertexCount * elementSize);
+				encodeHalfTexCoords(floats, mesh.vertexCount, reinterpret_cast<uint16_t*>(quantized.data()));
+				break;
+			default:
+				XE_ASSERT(false);
+			}
+			data = std::move(quantized);
+		}
+
+		GLuint vbo;
+		glCreateBuffers(1, &vbo);
+		glNamedBufferStorage(vbo, data.size(), data.data(), 0);
+
+		outputStride = elementSize;
+		return vbo;
+	}
+
+	// Attribute layout of VertexFormat::QUANTIZED, must match pbr.vert (XE_QUANTIZED_VERTICES)
+	void setQuantizedAttributeFormat(GLuint vao, PrimitiveAttributeType type) {
+		GLuint vaa = (GLuint)type;
+		switch (type) {
+		case PrimitiveAttributeType::POSITION:
+			glVertexArrayAttribFormat(vao, vaa, 3, GL_UNSIGNED_SHORT, GL_TRUE, 0);
+			break;
+		case PrimitiveAttributeType::TANGENT:
+			glVertexArrayAttribIFormat(vao, vaa, 2, GL_SHORT, 0);
+			break;
+		case PrimitiveAttributeType::NORMAL:
+			glVertexArrayAttribFormat(vao, vaa, 2, GL_SHORT, GL_TRUE, 0);
+			break;
+		case PrimitiveAttributeType::TEXCOORD_0:
+			glVertexArrayAttribFormat(vao, vaa, 2, GL_HALF_FLOAT, GL_FALSE, 0);
+			break;
+		default:
+			XE_ASSERT(false);
+		}
+	}
+
+	// Appends simplified detail levels of the optimized mesh to allIndices
+	void generatePrimitiveLODs(const OptimizedMesh& mesh, std::vector<uint32_t>& allIndices, Primitive& primitive) {
+		std::vector<uint32_t> previous = mesh.indices;
+		float error = 0.0f;
+
+		for (uint8_t level = 1; level < XE_MAX_PRIMITIVE_LODS; ++level) {
+			size_t target = previous.size() / 2 / 3 * 3;
+			if (target < XE_MIN_LOD_TRIANGLES * 3) {
+				break;
+			}
+
+			SimplifyResult result = simplifyMesh(previous, mesh.positions.data(), mesh.vertexCount, 0, target);
+			// Stop when simplification is blocked (locked seams/borders), the level would not be worth its memory
+			if (result.indices.size() > previous.size() * 9 / 10) {
+				break;
+			}
+
+			error = std::max(error, result.error);
+			primitive.lods[level] = PrimitiveLOD{ (GLsizei)result.indices.size(), allIndices.size() * sizeof(uint32_t), error };
+			primitive.lodCount = level + 1;
+
+			optimizeVertexCache(result.indices, mesh.vertexCount);
+			allIndices.insert(allIndices.end(), result.indices.begin(), result.indices.end());
+			previous = std::move(result.indices);
+		}
+
+		if (primitive.lodCount > 1) {
+			XE_LOG_TRACE_F("MODEL_LOADER: Generated {} LODs, triangles {} -> {} (error {})", primitive.lodCount, primitive.lods[0].count / 3, primitive.lods[primitive.lodCount - 1].count / 3, error);
+		}
+	}
+
+	// Triangle weighted vertex cache statistics of all optimized primitives in a model
+	struct MeshOptimizationStats {
+		size_t triangles = 0;
+		double acmrBefore = 0.0, atvrBefore = 0.0;
+		double acmrAfter = 0.0, atvrAfter = 0.0;
+		size_t quantizedPrimitives = 0;
+	};
+
+	// First index in Model::primitives of the primitives built for each glTF mesh, meshes used by several nodes are built once
+	typedef std::map<int, size_t> MeshPrimitiveCache;
+
 	size_t processPrimitives(const tinygltf::Model& model,
-		const tinygltf::Mesh& mesh,
+		int meshIndex,
 		const std::map<size_t, GLuint>& bufferVBOs,
 		const std::string& path,
-		const size_t basePrimitiveIndex,
 		const glm::mat4& globalPosition,
-		Model* outputModel) {
+		Model* outputModel,
+		const ModelImportSettings& settings,
+		MeshOptimizationStats& optimizationStats,
+		MeshPrimitiveCache& meshPrimitives) {
+
+		const tinygltf::Mesh& mesh = model.meshes[meshIndex];
+
+		// Instanced mesh, only the node matrix differs
+		auto cached = meshPrimitives.find(meshIndex);
+		if (cached != meshPrimitives.end()) {
+			for (size_t i = 0; i < mesh.primitives.size(); ++i) {
+				const Primitive& primitive = outputModel->primitives[cached->second + i];
+				outputModel->bounds = outputModel->bounds + BoundingBox(primitive.bounds) * globalPosition;
+				outputModel->primitiveIndices.push_back(cached->second + i);
+			}
+			return mesh.primitives.size();
+		}
+		meshPrimitives.emplace(meshIndex, outputModel->primitives.size());
 
 		size_t primitiveCount = 0;
 
@@ -72,6 +360,20 @@ namespace xe {
 			GLuint vao;
 			glCreateVertexArrays(1, &vao);
 
+			OptimizedMesh optimizedMesh;
+			bool optimized = optimizePrimitiveMesh(model, primitive, settings, optimizedMesh);
+			if (optimized) {
+				double triangles = (double)(optimizedMesh.indices.size() / 3);
+				optimizationStats.triangles += optimizedMesh.indices.size() / 3;
+				optimizationStats.acmrBefore += optimizedMesh.before.acmr * triangles;
+				optimizationStats.atvrBefore += optimizedMesh.before.atvr * triangles;
+				optimizationStats.acmrAfter += optimizedMesh.after.acmr * triangles;
+				optimizationStats.atvrAfter += optimizedMesh.after.atvr * triangles;
+				if (optimizedMesh.quantized) {
+					++optimizationStats.quantizedPrimitives;
+				}
+			}
+
 			PrimitiveAttributeArray primitiveAttributeArray;
 
 			BoundingBox primitiveBounds;
@@ -82,13 +384,15 @@ namespace xe {
 				int byteStride = accessor.ByteStride(model.bufferViews[accessor.bufferView]);
 				int size = accessor.type == TINYGLTF_TYPE_SCALAR ? 1 : accessor.type;
 				GLuint vbo = bufferVBOs.at(accessor.bufferView);
+				GLintptr offset = (GLintptr)accessor.byteOffset;
+				GLsizei count = (GLsizei)accessor.count;
 
 				PrimitiveAttributeType type = PrimitiveAttributeType::INVALID;
 				if (attribute.compare("POSITION") == 0) {
 					type = PrimitiveAttributeType::POSITION;
 					primitiveBounds = BoundingBox {
-						globalPosition * glm::vec4(accessor.minValues[0], accessor.minValues[1], accessor.minValues[2], 1),
-						globalPosition * glm::vec4(accessor.maxValues[0], accessor.maxValues[1], accessor.maxValues[2], 1)
+						glm::vec3(accessor.minValues[0], accessor.minValues[1], accessor.minValues[2]),
+						glm::vec3(accessor.maxValues[0], accessor.maxValues[1], accessor.maxValues[2])
 					};
 				}
 				if (attribute.compare("TANGENT") == 0) type = PrimitiveAttributeType::TANGENT;
@@ -101,14 +405,27 @@ namespace xe {
 				//if (attribute.compare("WEIGHTS_0") == 0) type = PrimitiveAttributeType::WEIGHTS_0;
 
 				if (type != PrimitiveAttributeType::INVALID) {
+					if (optimized) {
+						size_t stride;
+						vbo = createOptimizedAttributeBuffer(model, accessor, type, optimizedMesh, stride);
+						byteStride = (int)stride;
+						offset = 0;
+						count = (GLsizei)optimizedMesh.vertexCount;
+					}
+
 					GLuint vaa = (GLuint)type;
 					glEnableVertexArrayAttrib(vao, vaa);
-					glVertexArrayAttribFormat(vao, vaa, size, accessor.componentType, accessor.normalized, 0);
+					if (optimized && optimizedMesh.quantized) {
+						setQuantizedAttributeFormat(vao, type);
+					}
+					else {
+						glVertexArrayAttribFormat(vao, vaa, size, accessor.componentType, accessor.normalized, 0);
+					}
 					glVertexArrayAttribBinding(vao, vaa, vaa);
-					glVertexArrayVertexBuffer(vao, vaa, vbo, (GLintptr)((char*)NULL + accessor.byteOffset), byteStride);
+					glVertexArrayVertexBuffer(vao, vaa, vbo, offset, byteStride);
 
 					// NOTE: Casting size_t to GLsizei is neccesary to comply with the limit set by OpenGL
-					primitiveAttributeArray[(uint8_t)type] = PrimitiveAttribute{ vbo, (GLsizei)accessor.count };
+					primitiveAttributeArray[(uint8_t)type] = PrimitiveAttribute{ vbo, count };
 				}
 				else {
 					XE_LOG_WARN_F("MODEL_LOADER: Model contains primitive with unsupported attribute: {}", attribute);
@@ -118,10 +435,28 @@ namespace xe {
 			outputModel->primitiveAttributes.push_back(primitiveAttributeArray);
 			
 			// TODO: Fix issue with bounding box being initialized as zero,zero
-			outputModel->bounds = outputModel->bounds + primitiveBounds;
+			outputModel->bounds = outputModel->bounds + primitiveBounds * globalPosition;
 
 			// Check if primitive is indexed or not
-			if (primitive.indices >= 0) {
+			if (optimized) {
+				// All detail levels share one element buffer owned by the primitive
+				GLuint ebo;
+				glCreateBuffers(1, &ebo);
+
+				Primitive outputPrimitive = Primitive{ vao, (GLenum)primitive.mode, (GLsizei)optimizedMesh.indices.size(), primitive.material, primitiveBounds, ebo, GL_UNSIGNED_INT };
+				std::vector<uint32_t> allIndices = optimizedMesh.indices;
+				generatePrimitiveLODs(optimizedMesh, allIndices, outputPrimitive);
+				if (optimizedMesh.quantized) {
+					outputPrimitive.vertexFormat = VertexFormat::QUANTIZED;
+					outputPrimitive.positionOffset = optimizedMesh.positionOffset;
+					outputPrimitive.positionScale = optimizedMesh.positionScale;
+				}
+
+				glNamedBufferStorage(ebo, allIndices.size() * sizeof(uint32_t), allIndices.data(), 0);
+				glVertexArrayElementBuffer(vao, ebo);
+				outputModel->primitives.push_back(outputPrimitive);
+			}
+			else if (primitive.indices >= 0) {
 				const tinygltf::Accessor& indexAccessor = model.accessors[primitive.indices];
 				GLuint ebo = bufferVBOs.at(indexAccessor.bufferView);
 				glVertexArrayElementBuffer(vao, ebo);
@@ -140,8 +475,10 @@ namespace xe {
 				XE_ASSERT(attribute.vbo != 0);
 				outputModel->primitives.push_back(Primitive{ vao, (GLenum)primitive.mode, attribute.count, primitive.material, primitiveBounds });
 			}
+			outputModel->primitives.back().uvDensity = computePrimitiveUVDensity(model, primitive);
+
 			// Add primitive index
-			outputModel->primitiveIndices.push_back(basePrimitiveIndex + primitiveCount);
+			outputModel->primitiveIndices.push_back(outputModel->primitives.size() - 1);
 
 			// Increment counter
 			++primitiveCount;
@@ -150,7 +487,8 @@ namespace xe {
 		return primitiveCount;
 	}
 
-	Model* loadModel(const std::string& path) {
+	Model* loadModel(const std::string& path, const ModelImportSettings& settings) {
+		XE_PROFILE_FUNCTION();
 		tinygltf::TinyGLTF loader;
 		tinygltf::Model gltfModel;
 		std::string err, warn;
@@ -198,11 +536,11 @@ namespace xe {
 			material.pbrMetallicRoughness.baseColorTexture = loadTextureIfExists<tinygltf::TextureInfo>(manager, gltfModel, pMaterial.pbrMetallicRoughness.baseColorTexture, path, true);
 			material.pbrMetallicRoughness.metallicFactor = pMaterial.pbrMetallicRoughness.metallicFactor;
 			material.pbrMetallicRoughness.roughnessFactor = pMaterial.pbrMetallicRoughness.roughnessFactor;
-			material.pbrMetallicRoughness.metallicRoughnessTexture = loadTextureIfExists<tinygltf::TextureInfo>(manager, gltfModel, pMaterial.pbrMetallicRoughness.metallicRoughnessTexture, path);
+			material.pbrMetallicRoughness.metallicRoughnessTexture = loadTextureIfExists<tinygltf::TextureInfo>(manager, gltfModel, pMaterial.pbrMetallicRoughness.metallicRoughnessTexture, path, false, TextureUsage::METALLIC_ROUGHNESS);
 
-			material.normalTexture = loadTextureIfExists<tinygltf::NormalTextureInfo>(manager, gltfModel, pMaterial.normalTexture, path);
+			material.normalTexture = loadTextureIfExists<tinygltf::NormalTextureInfo>(manager, gltfModel, pMaterial.normalTexture, path, false, TextureUsage::NORMAL);
 
-			material.occlusionTexture = loadTextureIfExists<tinygltf::OcclusionTextureInfo>(manager, gltfModel, pMaterial.occlusionTexture, path);
+			material.occlusionTexture = loadTextureIfExists<tinygltf::OcclusionTextureInfo>(manager, gltfModel, pMaterial.occlusionTexture, path, false, TextureUsage::OCCLUSION);
 
 			material.emissiveTexture = loadTextureIfExists<tinygltf::TextureInfo>(manager, gltfModel, pMaterial.emissiveTexture, path);
 			material.emissiveFactor = glm::make_vec3(pMaterial.emissiveFactor.data());
@@ -245,7 +583,9 @@ namespace xe {
 		
 		// Process nodes
 		uint16_t currentIndex = 1;
-		size_t currentPrimitiveIndex = 0;
+
+		MeshOptimizationStats optimizationStats;
+		MeshPrimitiveCache meshPrimitives;
 
 		std::vector<glm::mat4x4> globalPositions;
 		globalPositions.emplace_back(glm::mat4x4(1.0f));
@@ -266,9 +606,7 @@ namespace xe {
 			// Check if node has valid mesh
 			uint8_t primitiveCount = 0;
 			if (node.mesh >= 0 && node.mesh < gltfModel.meshes.size()) {
-				size_t count = processPrimitives(gltfModel, gltfModel.meshes[node.mesh], bufferVBOs, path, currentPrimitiveIndex, globalPosition, model);
-				primitiveCount += count;
-				currentPrimitiveIndex += count;
+				primitiveCount += processPrimitives(gltfModel, node.mesh, bufferVBOs, path, globalPosition, model, settings, optimizationStats, meshPrimitives);
 			}
 
 			// Queue children
@@ -283,6 +621,47 @@ namespace xe {
 			queuedNodes.pop();
 		}
 
+		// Flatten node hierarchy
+		updateModelMatrices(model);
+
+		// Model detail levels
+		for (const Primitive& primitive : model->primitives) {
+			model->lodCount = std::max(model->lodCount, primitive.lodCount);
+		}
+		// Errors are measured in the units of the primitive vertices, scale them to model space by their node matrix
+		for (size_t pii = 0; pii < model->primitiveIndices.size(); ++pii) {
+			const Primitive& primitive = model->primitives[model->primitiveIndices[pii]];
+			const glm::mat4& matrix = model->primitiveMatrices[pii];
+			float scale = std::max(glm::length(glm::vec3(matrix[0])), std::max(glm::length(glm::vec3(matrix[1])), glm::length(glm::vec3(matrix[2]))));
+			for (uint8_t level = 0; level < model->lodCount; ++level) {
+				const PrimitiveLOD& lod = primitive.lods[std::min<uint8_t>(level, primitive.lodCount - 1)];
+				model->lodErrors[level] = std::max(model->lodErrors[level], lod.error * scale);
+			}
+		}
+
+		if (optimizationStats.triangles > 0) {
+			double triangles = (double)optimizationStats.triangles;
+			XE_LOG_INFO_F("MODEL_LOADER: Optimized {} triangles, ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}, {} quantized primitives ({})", optimizationStats.triangles,
+				optimizationStats.acmrBefore / triangles, optimizationStats.acmrAfter / triangles,
+				optimizationStats.atvrBefore / triangles, optimizationStats.atvrAfter / triangles, optimizationStats.quantizedPrimitives, path);
+		}
+
+		// Release buffer views that are not referenced by the model (replaced index and vertex buffers, image data)
+		std::set<GLuint> usedBuffers;
+		for (const Primitive& primitive : model->primitives) {
+			usedBuffers.insert(primitive.ebo);
+		}
+		for (const PrimitiveAttributeArray& attributeArray : model->primitiveAttributes) {
+			for (const PrimitiveAttribute& attribute : attributeArray) {
+				usedBuffers.insert(attribute.vbo);
+			}
+		}
+		for (const auto& [view, vbo] : bufferVBOs) {
+			if (usedBuffers.find(vbo) == usedBuffers.end()) {
+				glDeleteBuffers(1, &vbo);
+			}
+		}
+
 		XE_LOG_TRACE_F("MODEL_LOADER: Loaded model: {}", path);
 		return model;
 	}
@@ -6,7 +6,15 @@
 
 namespace xe {
 
-	Model* loadModel(const std::string& path);
+	// Primitives with fewer triangles than this are not simplified further
+	#define XE_MIN_LOD_TRIANGLES 64
+
+	struct ModelImportSettings {
+		// Store optimized primitives in VertexFormat::QUANTIZED, requires the quantized shader permutation
+		bool quantizeVertices = true;
+	};
+
+	Model* loadModel(const std::string& path, const ModelImportSettings& settings = ModelImportSettings());
 
 }
 
@@ -0,0 +1,389 @@
+#include "occlusion_culling.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "xenon/core/log.h"
+#include "xenon/core/assert.h"
+#include "xenon/graphics/gl_state.h"
+#include "xenon/graphics/render_stats.h"
+
+namespace xe {
+
+	// Size of one readback region in floats, large enough for any level chosen by XE_OCCLUSION_READBACK_WIDTH
+	#define XE_OCCLUSION_READBACK_REGION (XE_OCCLUSION_READBACK_WIDTH * XE_OCCLUSION_READBACK_WIDTH)
+
+	//----------------------------------------
+	// SECTION: Occlusion culling
+	//----------------------------------------
+
+	OcclusionCuller* createOcclusionCuller() {
+		OcclusionCuller* culler = new OcclusionCuller();
+
+		culler->buildShader = loadComputeShader("assets/shaders/hiz_build.comp");
+		culler->testShader = loadComputeShader("assets/shaders/hiz_test.comp");
+		if (!culler->buildShader || !culler->testShader) {
+			XE_LOG_ERROR("OCCLUSION: Failed to load depth pyramid shaders, occlusion culling is disabled");
+		}
+
+		const GLbitfield readFlags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		const GLbitfield writeFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+		GLsizeiptr readbackSize = sizeof(float) * XE_OCCLUSION_READBACK_REGION * XE_OCCLUSION_FRAMES;
+		glCreateBuffers(1, &culler->readbackBuffer);
+		glNamedBufferStorage(culler->readbackBuffer, readbackSize, nullptr, readFlags);
+		culler->readbackMemory = static_cast<float*>(glMapNamedBufferRange(culler->readbackBuffer, 0, readbackSize, readFlags));
+
+		GLsizeiptr candidateSize = sizeof(OcclusionCandidate) * XE_OCCLUSION_MAX_CANDIDATES * XE_OCCLUSION_FRAMES;
+		glCreateBuffers(1, &culler->candidateBuffer);
+		glNamedBufferStorage(culler->candidateBuffer, candidateSize, nullptr, writeFlags);
+		culler->candidateMemory = static_cast<OcclusionCandidate*>(glMapNamedBufferRange(culler->candidateBuffer, 0, candidateSize, writeFlags));
+
+		GLsizeiptr visibilitySize = sizeof(uint32_t) * XE_OCCLUSION_MAX_CANDIDATES * XE_OCCLUSION_FRAMES;
+		glCreateBuffers(1, &culler->visibilityBuffer);
+		glNamedBufferStorage(culler->visibilityBuffer, visibilitySize, nullptr, readFlags);
+		culler->visibilityMemory = static_cast<uint32_t*>(glMapNamedBufferRange(culler->visibilityBuffer, 0, visibilitySize, readFlags));
+
+		return culler;
+	}
+
+	void destroyOcclusionCuller(OcclusionCuller* culler) {
+		for (GLsync& fence : culler->fences) {
+			if (fence) {
+				glDeleteSync(fence);
+				fence = nullptr;
+			}
+		}
+
+		glUnmapNamedBuffer(culler->readbackBuffer);
+		glUnmapNamedBuffer(culler->candidateBuffer);
+		glUnmapNamedBuffer(culler->visibilityBuffer);
+		glDeleteBuffers(1, &culler->readbackBuffer);
+		glDeleteBuffers(1, &culler->candidateBuffer);
+		glDeleteBuffers(1, &culler->visibilityBuffer);
+
+		if (culler->pyramidTexture) {
+			forgetGLTexture(culler->pyramidTexture);
+			glDeleteTextures(1, &culler->pyramidTexture);
+		}
+
+		if (culler->buildShader) destroyShader(culler->buildShader);
+		if (culler->testShader) destroyShader(culler->testShader);
+
+		delete culler;
+	}
+
+
+	//----------------------------------------
+	// SECTION: Occlusion test
+	//----------------------------------------
+
+	// Screen space rectangle (0-1) and nearest window depth of the bounds, false if the box crosses the near plane
+	static bool projectBounds(const glm::mat4& modelViewProjection, const BoundingBox& bounds, glm::vec2& rectMin, glm::vec2& rectMax, float& nearestDepth) {
+		rectMin = glm::vec2(1.0f);
+		rectMax = glm::vec2(0.0f);
+		nearestDepth = 1.0f;
+
+		for (int corner = 0; corner < 8; ++corner) {
+			glm::vec4 position = glm::vec4(
+				corner & 1 ? bounds.max.x : bounds.min.x,
+				corner & 2 ? bounds.max.y : bounds.min.y,
+				corner & 4 ? bounds.max.z : bounds.min.z,
+				1.0f);
+			glm::vec4 clip = modelViewProjection * position;
+			if (clip.w <= 1e-5f) {
+				return false;
+			}
+
+			glm::vec3 ndc = glm::vec3(clip) / clip.w;
+			glm::vec2 screen = glm::vec2(ndc) * 0.5f + 0.5f;
+			rectMin = glm::min(rectMin, screen);
+			rectMax = glm::max(rectMax, screen);
+			nearestDepth = glm::min(nearestDepth, ndc.z * 0.5f + 0.5f);
+		}
+
+		rectMin = glm::clamp(rectMin, 0.0f, 1.0f);
+		rectMax = glm::clamp(rectMax, 0.0f, 1.0f);
+		return rectMin.x < rectMax.x && rectMin.y < rectMax.y;
+	}
+
+	static bool isOccludedCPU(const OcclusionCuller* culler, const BoundingBox& bounds, const glm::mat4& transform) {
+		glm::vec2 rectMin, rectMax;
+		float nearestDepth;
+		if (!projectBounds(culler->cpuViewProjection * transform, bounds, rectMin, rectMax, nearestDepth)) {
+			return false;
+		}
+
+		// Level where the rectangle covers at most 2x2 texels
+		glm::vec2 extent = (rectMax - rectMin) * glm::vec2(culler->cpuPyramidSizes[0]);
+		int level = (int)std::ceil(std::log2(std::max(std::max(extent.x, extent.y), 1.0f)));
+		level = std::clamp(level, 0, (int)culler->cpuPyramid.size() - 1);
+
+		const std::vector<float>& depths = culler->cpuPyramid[level];
+		glm::ivec2 size = culler->cpuPyramidSizes[level];
+		glm::ivec2 texelMin = glm::min(glm::ivec2(rectMin * glm::vec2(size)), size - 1);
+		glm::ivec2 texelMax = glm::min(glm::ivec2(rectMax * glm::vec2(size)), size - 1);
+
+		for (int y = texelMin.y; y <= texelMax.y; ++y) {
+			for (int x = texelMin.x; x <= texelMax.x; ++x) {
+				if (nearestDepth <= depths[(size_t)y * size.x + x]) {
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	// Reduces the read back level into the remaining pyramid levels
+	static void buildCPUPyramid(OcclusionCuller* culler, const float* data, glm::ivec2 size) {
+		culler->cpuPyramid.resize(1);
+		culler->cpuPyramidSizes.resize(1);
+		culler->cpuPyramid[0].assign(data, data + (size_t)size.x * size.y);
+		culler->cpuPyramidSizes[0] = size;
+
+		while (size.x > 1 || size.y > 1) {
+			glm::ivec2 sourceSize = size;
+			size = glm::max(size / 2, glm::ivec2(1));
+
+			const std::vector<float>& source = culler->cpuPyramid.back();
+			std::vector<float> target((size_t)size.x * size.y);
+			for (int y = 0; y < size.y; ++y) {
+				for (int x = 0; x < size.x; ++x) {
+					// Odd source sizes, the last texel also covers the remaining row/column
+					int xEnd = std::min(x == size.x - 1 ? sourceSize.x : x * 2 + 2, sourceSize.x);
+					int yEnd = std::min(y == size.y - 1 ? sourceSize.y : y * 2 + 2, sourceSize.y);
+					float depth = 0.0f;
+					for (int sy = y * 2; sy < yEnd; ++sy) {
+						for (int sx = x * 2; sx < xEnd; ++sx) {
+							depth = std::max(depth, source[(size_t)sy * sourceSize.x + sx]);
+						}
+					}
+					target[(size_t)y * size.x + x] = depth;
+				}
+			}
+
+			culler->cpuPyramid.push_back(std::move(target));
+			culler->cpuPyramidSizes.push_back(size);
+		}
+	}
+
+	static void consumeOcclusionResults(OcclusionCuller* culler, size_t slot) {
+		if (culler->mode == OcclusionCullingMode::CPU) {
+			glm::ivec2 size = culler->readbackSizes[slot];
+			if (size.x > 0 && size.y > 0) {
+				buildCPUPyramid(culler, culler->readbackMemory + slot * XE_OCCLUSION_READBACK_REGION, size);
+				culler->cpuViewProjection = culler->viewProjections[slot];
+				culler->cpuPyramidValid = true;
+			}
+		}
+		else if (culler->mode == OcclusionCullingMode::GPU) {
+			const std::vector<UUID>& ids = culler->candidateIDs[slot];
+			const uint32_t* results = culler->visibilityMemory + slot * XE_OCCLUSION_MAX_CANDIDATES;
+			for (size_t i = 0; i < ids.size(); ++i) {
+				// Entries pruned while the result was in flight stay pruned
+				auto it = culler->visibility.find(ids[i]);
+				if (it != culler->visibility.end()) {
+					it->second.visible = results[i] != 0;
+				}
+			}
+		}
+	}
+
+
+	//----------------------------------------
+	// SECTION: Occlusion culling functions
+	//----------------------------------------
+
+	void beginOcclusionFrame(OcclusionCuller* culler, OcclusionCullingMode mode) {
+		culler->lastFrameStats = culler->frameStats;
+		culler->frameStats = OcclusionCullingStats();
+
+		if (!culler->buildShader || !culler->testShader) {
+			mode = OcclusionCullingMode::NONE;
+		}
+
+		// Results in flight belong to the previous mode, drop them
+		if (mode != culler->mode) {
+			culler->mode = mode;
+			culler->visibility.clear();
+			culler->cpuPyramidValid = false;
+			culler->readbackSizes = {};
+			for (std::vector<UUID>& ids : culler->candidateIDs) {
+				ids.clear();
+			}
+		}
+
+		// Oldest slot first, it is the one written this frame so it has to be finished
+		for (size_t k = 0; k < XE_OCCLUSION_FRAMES; ++k) {
+			size_t slot = (culler->frame + k) % XE_OCCLUSION_FRAMES;
+			GLsync& fence = culler->fences[slot];
+			if (!fence) {
+				continue;
+			}
+
+			GLenum result = glClientWaitSync(fence, 0, 0);
+			if (k == 0) {
+				while (result == GL_TIMEOUT_EXPIRED) {
+					result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1 ms
+				}
+			}
+			if (result == GL_TIMEOUT_EXPIRED) {
+				break;  // Newer frames can not be finished either
+			}
+
+			consumeOcclusionResults(culler, slot);
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+
+		culler->candidateIDs[culler->frame % XE_OCCLUSION_FRAMES].clear();
+		culler->readbackSizes[culler->frame % XE_OCCLUSION_FRAMES] = glm::ivec2(0);
+
+		// Forget entities that are no longer tested (deleted, hidden or frustum culled)
+		for (auto it = culler->visibility.begin(); it != culler->visibility.end();) {
+			if (culler->frame - it->second.lastTestedFrame > XE_OCCLUSION_FRAMES) {
+				it = culler->visibility.erase(it);
+			}
+			else {
+				++it;
+			}
+		}
+	}
+
+	bool testOcclusion(OcclusionCuller* culler, UUID id, const BoundingBox& bounds, const glm::mat4& transform) {
+		if (culler->mode == OcclusionCullingMode::NONE) {
+			return true;
+		}
+		++culler->frameStats.tested;
+
+		bool visible = true;
+		if (culler->mode == OcclusionCullingMode::CPU) {
+			visible = !culler->cpuPyramidValid || !isOccludedCPU(culler, bounds, transform);
+		}
+		else {
+			// Queue for the GPU test of this frame, the result is used once it has been read back
+			size_t slot = culler->frame % XE_OCCLUSION_FRAMES;
+			std::vector<UUID>& ids = culler->candidateIDs[slot];
+			if (ids.size() < XE_OCCLUSION_MAX_CANDIDATES) {
+				culler->candidateMemory[slot * XE_OCCLUSION_MAX_CANDIDATES + ids.size()] = OcclusionCandidate{ glm::vec4(bounds.min, 1.0f), glm::vec4(bounds.max, 1.0f), transform };
+				ids.push_back(id);
+				recordBufferUpload(sizeof(OcclusionCandidate));
+			}
+
+			// Entities without results yet are visible
+			OcclusionVisibility& entry = culler->visibility[id];
+			entry.lastTestedFrame = culler->frame;
+			visible = entry.visible;
+		}
+
+		if (!visible) {
+			++culler->frameStats.culled;
+		}
+		return visible;
+	}
+
+	static void resizeDepthPyramid(OcclusionCuller* culler, glm::ivec2 size) {
+		if (culler->pyramidTexture) {
+			forgetGLTexture(culler->pyramidTexture);
+			glDeleteTextures(1, &culler->pyramidTexture);
+		}
+
+		culler->pyramidSize = size;
+		culler->pyramidLevels = (int)std::floor(std::log2((float)std::max(size.x, size.y))) + 1;
+
+		glCreateTextures(GL_TEXTURE_2D, 1, &culler->pyramidTexture);
+		glTextureStorage2D(culler->pyramidTexture, culler->pyramidLevels, GL_R32F, size.x, size.y);
+		glTextureParameteri(culler->pyramidTexture, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+		glTextureParameteri(culler->pyramidTexture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTextureParameteri(culler->pyramidTexture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTextureParameteri(culler->pyramidTexture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		// Results built for the previous size are still valid, they are all in normalized coordinates
+	}
+
+	void endOcclusionFrame(OcclusionCuller* culler, const Framebuffer& framebuffer, const Camera& camera) {
+		if (culler->mode == OcclusionCullingMode::NONE) {
+			return;
+		}
+
+		auto depthAttachment = framebuffer.attachments.find(GL_DEPTH_ATTACHMENT);
+		if (depthAttachment == framebuffer.attachments.end() || !depthAttachment->second.texture) {
+			XE_LOG_WARN("OCCLUSION: Framebuffer has no depth attachment, skipping depth pyramid");
+			return;
+		}
+
+		glm::ivec2 size = glm::ivec2(framebuffer.viewportWidth, framebuffer.viewportHeight);
+		if (size != culler->pyramidSize) {
+			resizeDepthPyramid(culler, size);
+		}
+
+		size_t slot = culler->frame % XE_OCCLUSION_FRAMES;
+		XE_ASSERT(culler->fences[slot] == nullptr);
+
+		// Depth pyramid, level 0 is the (max of all samples) depth, every level reduces 2x2 texels
+		const Shader& build = *culler->buildShader;
+		bindShader(build);
+		bool multisampled = framebuffer.samples > 1;
+		bindGLTextureUnit(multisampled ? 1 : 0, depthAttachment->second.texture->textureID);
+		loadInt(build, "mode", multisampled ? 1 : 0);
+		loadInt(build, "samples", framebuffer.samples);
+		loadIVec2(build, "targetSize", size);
+		glBindImageTexture(1, culler->pyramidTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+		glDispatchCompute((size.x + 7) / 8, (size.y + 7) / 8, 1);
+
+		loadInt(build, "mode", 2);
+		glm::ivec2 levelSize = size;
+		for (int level = 1; level < culler->pyramidLevels; ++level) {
+			glm::ivec2 sourceSize = levelSize;
+			levelSize = glm::max(levelSize / 2, glm::ivec2(1));
+
+			glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+			glBindImageTexture(0, culler->pyramidTexture, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+			glBindImageTexture(1, culler->pyramidTexture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+			loadIVec2(build, "sourceSize", sourceSize);
+			loadIVec2(build, "targetSize", levelSize);
+			glDispatchCompute((levelSize.x + 7) / 8, (levelSize.y + 7) / 8, 1);
+		}
+
+		culler->viewProjections[slot] = camera.projection * camera.inverseTransform;
+
+		if (culler->mode == OcclusionCullingMode::CPU) {
+			int level = 0;
+			while (std::max(size.x >> level, size.y >> level) > XE_OCCLUSION_READBACK_WIDTH) {
+				++level;
+			}
+			glm::ivec2 readbackSize = glm::max(glm::ivec2(size.x >> level, size.y >> level), glm::ivec2(1));
+
+			glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT | GL_PIXEL_BUFFER_BARRIER_BIT);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, culler->readbackBuffer);
+			size_t offset = slot * XE_OCCLUSION_READBACK_REGION * sizeof(float);
+			glGetTextureImage(culler->pyramidTexture, level, GL_RED, GL_FLOAT, XE_OCCLUSION_READBACK_REGION * sizeof(float), (void*)offset);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+			culler->readbackSizes[slot] = readbackSize;
+		}
+		else {
+			GLuint count = (GLuint)culler->candidateIDs[slot].size();
+			if (count > 0) {
+				const Shader& test = *culler->testShader;
+				glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+				bindShader(test);
+				bindGLTextureUnit(0, culler->pyramidTexture);
+				loadMat4(test, "viewProjection", culler->viewProjections[slot]);
+				loadInt(test, "candidateCount", (int)count);
+				loadInt(test, "pyramidLevels", culler->pyramidLevels);
+				loadIVec2(test, "pyramidSize", culler->pyramidSize);
+
+				glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, culler->candidateBuffer, slot * XE_OCCLUSION_MAX_CANDIDATES * sizeof(OcclusionCandidate), count * sizeof(OcclusionCandidate));
+				glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 1, culler->visibilityBuffer, slot * XE_OCCLUSION_MAX_CANDIDATES * sizeof(uint32_t), count * sizeof(uint32_t));
+				glDispatchCompute((count + 63) / 64, 1, 1);
+			}
+		}
+
+		glMemoryBarrier(GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT);
+		culler->fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		++culler->frame;
+	}
+
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include "xenon/core/uuid.h"
+#include "xenon/graphics/camera.h"
+#include "xenon/graphics/framebuffer.h"
+#include "xenon/graphics/primitive.h"
+#include "xenon/graphics/shader.h"
+
+namespace xe {
+
+	// Number of frames of results in flight, culling uses the newest finished frame
+	#define XE_OCCLUSION_FRAMES 3
+	// The CPU variant reads back the first pyramid level that is at most this wide
+	#define XE_OCCLUSION_READBACK_WIDTH 256
+	// Candidates per frame the GPU variant can test, remaining candidates are always drawn
+	#define XE_OCCLUSION_MAX_CANDIDATES 16384
+
+	//----------------------------------------
+	// SECTION: Occlusion culling
+	//----------------------------------------
+
+	/*
+		Hierarchical-Z occlusion culling against the depth of the previous frames. At the end of a frame the
+		depth attachment is reduced into a max-depth pyramid, candidates are tested by projecting their bounds
+		with the camera of the frame the pyramid was built from (reprojection) and comparing the nearest depth of
+		the box against the pyramid level where the box covers at most 2x2 texels.
+
+		CPU: a small pyramid level is read back asynchronously and the test runs on the CPU.
+		GPU: a compute shader tests the candidates of the frame against the full pyramid and only the visibility
+		     results are read back.
+		Either way the results are a few frames old, objects that become visible can appear with that delay.
+	*/
+
+	enum class OcclusionCullingMode : uint8_t {
+		NONE	= 0,
+		CPU		= 1,
+		GPU		= 2
+	};
+
+	struct OcclusionCullingStats {
+		uint32_t tested = 0;
+		uint32_t culled = 0;
+	};
+
+	// NOTE: std430 layout, must match Candidate in hiz_test.comp
+	struct OcclusionCandidate {
+		glm::vec4 min;
+		glm::vec4 max;
+		glm::mat4 transform;
+	};
+
+	struct OcclusionVisibility {
+		bool visible = true;
+		// Entries not tested for XE_OCCLUSION_FRAMES frames are pruned, their entities may have been deleted
+		uint64_t lastTestedFrame = 0;
+	};
+
+	struct OcclusionCuller {
+		OcclusionCullingMode mode = OcclusionCullingMode::NONE;
+
+		Shader* buildShader = nullptr;
+		Shader* testShader = nullptr;
+
+		// Max depth pyramid of the last rendered frame
+		GLuint pyramidTexture = 0;
+		glm::ivec2 pyramidSize = glm::ivec2(0);
+		int pyramidLevels = 0;
+
+		uint64_t frame = 0;
+		std::array<GLsync, XE_OCCLUSION_FRAMES> fences = {};
+		std::array<glm::mat4, XE_OCCLUSION_FRAMES> viewProjections = {};
+
+		// CPU: readback of one pyramid level, the smaller levels are reduced on the CPU
+		GLuint readbackBuffer = 0;
+		float* readbackMemory = nullptr;
+		std::array<glm::ivec2, XE_OCCLUSION_FRAMES> readbackSizes = {};
+		std::vector<std::vector<float>> cpuPyramid;
+		std::vector<glm::ivec2> cpuPyramidSizes;
+		int cpuPyramidBaseLevel = 0;
+		glm::mat4 cpuViewProjection = glm::mat4(1.0f);
+		bool cpuPyramidValid = false;
+
+		// GPU: candidates of each frame and their visibility results
+		GLuint candidateBuffer = 0;
+		OcclusionCandidate* candidateMemory = nullptr;
+		GLuint visibilityBuffer = 0;
+		uint32_t* visibilityMemory = nullptr;
+		std::array<std::vector<UUID>, XE_OCCLUSION_FRAMES> candidateIDs;
+		std::unordered_map<UUID, OcclusionVisibility> visibility;
+
+		OcclusionCullingStats frameStats;
+		OcclusionCullingStats lastFrameStats;
+	};
+
+	OcclusionCuller* createOcclusionCuller();
+	void destroyOcclusionCuller(OcclusionCuller* culler);
+
+
+	//----------------------------------------
+	// SECTION: Occlusion culling functions
+	//----------------------------------------
+
+	// Collects finished results, call before testing the candidates of the frame
+	void beginOcclusionFrame(OcclusionCuller* culler, OcclusionCullingMode mode);
+	// Returns false when the bounds (model space, placed with transform) were occluded in the newest results
+	bool testOcclusion(OcclusionCuller* culler, UUID id, const BoundingBox& bounds, const glm::mat4& transform);
+	// Builds the depth pyramid from the depth attachment rendered with camera and starts the readback
+	void endOcclusionFrame(OcclusionCuller* culler, const Framebuffer& framebuffer, const Camera& camera);
+
+}
@@ -17,10 +17,14 @@ namespace xe {
 	}
 
 	Primitive::Primitive(GLuint vao, GLenum mode, GLsizei count, int material, const BoundingBox& bounds)
-		: vao(vao), mode(mode), count(count), material(material), bounds(bounds) {}
+		: vao(vao), mode(mode), count(count), material(material), bounds(bounds) {
+		lods[0] = PrimitiveLOD{ count, 0, 0.0f };
+	}
 
 	Primitive::Primitive(GLuint vao, GLenum mode, GLsizei count, int material, const BoundingBox& bounds, GLuint ebo, GLenum indexType)
-		: vao(vao), mode(mode), count(count), material(material), bounds(bounds), ebo(ebo), indexType(indexType) {}
+		: vao(vao), mode(mode), count(count), material(material), bounds(bounds), ebo(ebo), indexType(indexType) {
+		lods[0] = PrimitiveLOD{ count, 0, 0.0f };
+	}
 
 }
 
@@ -24,6 +24,18 @@ namespace xe {
 		INVALID			= UINT8_MAX
 	};
 
+	enum class VertexFormat : uint8_t {
+		FLOAT			= 0,	// Attributes as provided by the source file
+		/*
+			Compact format produced at import, decoded in the shader permutation XE_SHADER_PERMUTATION_QUANTIZED_VERTICES
+			POSITION:	4x unorm16, dequantized with Primitive::positionOffset and Primitive::positionScale
+			TANGENT:	2x int16 octahedral, handedness stored in the lowest bit of y
+			NORMAL:		2x snorm16 octahedral
+			TEXCOORD_0:	2x half float
+		*/
+		QUANTIZED		= 1
+	};
+
 	struct PrimitiveAttribute {
 		GLuint vbo = 0;
 		GLsizei count = 0;
@@ -39,16 +51,38 @@ namespace xe {
 		BoundingBox operator+ (const BoundingBox& other);
 	};
 
+	// Maximum number of detail levels per primitive, including the full resolution level
+	#define XE_MAX_PRIMITIVE_LODS 4
+
+	struct PrimitiveLOD {
+		GLsizei count = 0;
+		size_t indexOffset = 0;  // Byte offset into the element buffer
+		float error = 0.0f;  // Simplification error in the units of the vertex positions
+	};
+
 	struct Primitive {
 		GLuint vao;
 		GLenum mode;  // Type of primitive
 		GLsizei count;
 		int material;
+		// In the units of the vertex positions, nodes sharing the primitive apply their own matrix
 		BoundingBox bounds;
 
 		GLuint ebo = 0;
 		GLenum indexType = 0;
 
+		// NOTE: lods[0] is always the full resolution primitive, all levels share the vertex data and element buffer
+		std::array<PrimitiveLOD, XE_MAX_PRIMITIVE_LODS> lods;
+		uint8_t lodCount = 1;
+
+		VertexFormat vertexFormat = VertexFormat::FLOAT;
+		// Quantized positions: position = positionOffset + positionScale * unorm16
+		glm::vec3 positionOffset = glm::vec3(0.0f);
+		glm::vec3 positionScale = glm::vec3(1.0f);
+
+		// TEXCOORD_0 units per vertex position unit, the square root of the ratio of their areas (0 when unknown)
+		float uvDensity = 0.0f;
+
 		// DrawArrays
 		Primitive(GLuint vao, GLenum mode, GLsizei count, int material, const BoundingBox& bounds);
 		// DrawElements
@@ -71,6 +71,7 @@ namespace xe {
 		model->primitives.push_back(primitive);
 		model->materials.push_back(Material());
 		model->primitiveAttributes.push_back(attributeArray);
+		updateModelMatrices(model);
 
 		return model;
 	}
@@ -170,6 +171,7 @@ namespace xe {
 		model->primitives.push_back(primitive);
 		model->materials.push_back(Material());
 		model->primitiveAttributes.push_back(attributeArray);
+		updateModelMatrices(model);
 
 		return model;
 	}
@@ -0,0 +1,84 @@
+#include "render_stats.h"
+
+#include "xenon/core/assert.h"
+#include "xenon/graphics/gl_state.h"
+
+namespace xe {
+
+	static RenderStats s_frameStats;
+	// GL state counters at the start of the frame, they are reset independently of the render frame
+	static GLStateCounters s_frameStartCounters;
+
+	//----------------------------------------
+	// SECTION: Render stats
+	//----------------------------------------
+
+	void pushRenderStatsHistory(RenderStatsHistory& history, const RenderStats& stats) {
+		history.frames[history.next] = stats;
+		history.next = (history.next + 1) % XE_RENDER_STATS_HISTORY;
+		if (history.count < XE_RENDER_STATS_HISTORY) {
+			++history.count;
+		}
+	}
+
+	const RenderStats& getRenderStatsHistoryFrame(const RenderStatsHistory& history, uint32_t age) {
+		XE_ASSERT(age < history.count);
+		return history.frames[(history.next + XE_RENDER_STATS_HISTORY - 1 - age) % XE_RENDER_STATS_HISTORY];
+	}
+
+
+	//----------------------------------------
+	// SECTION: Render stats recording
+	//----------------------------------------
+
+	void beginRenderStatsFrame() {
+		s_frameStats = RenderStats();
+		s_frameStartCounters = getGLStateCounters();
+	}
+
+	RenderStats endRenderStatsFrame() {
+		const GLStateCounters& counters = getGLStateCounters();
+		// Counters reset during the frame restart from zero
+		auto delta = [](uint32_t current, uint32_t start) { return current >= start ? current - start : current; };
+
+		RenderStats stats = s_frameStats;
+		stats.shaderBinds = delta(counters.programBinds, s_frameStartCounters.programBinds);
+		stats.vertexArrayBinds = delta(counters.vertexArrayBinds, s_frameStartCounters.vertexArrayBinds);
+		stats.textureBinds = delta(counters.textureBinds, s_frameStartCounters.textureBinds);
+		return stats;
+	}
+
+	void recordDrawCall(GLenum mode, GLsizei vertexCount, GLsizei instances) {
+		++s_frameStats.drawCalls;
+		if (instances > 1) {
+			++s_frameStats.instancedDrawCalls;
+		}
+
+		uint64_t primitives = 0;
+		switch (mode) {
+		case GL_TRIANGLES:		primitives = vertexCount / 3; break;
+		case GL_TRIANGLE_STRIP:
+		case GL_TRIANGLE_FAN:	primitives = vertexCount > 2 ? vertexCount - 2 : 0; break;
+		}
+		s_frameStats.triangles += primitives * instances;
+		s_frameStats.vertices += (uint64_t)vertexCount * instances;
+	}
+
+	void recordUniformUpload() {
+		++s_frameStats.uniformUploads;
+	}
+
+	void recordBufferUpload(size_t bytes) {
+		s_frameStats.bufferBytesUploaded += bytes;
+	}
+
+	void recordFramebufferBlit() {
+		++s_frameStats.framebufferBlits;
+	}
+
+	void recordVisibility(uint32_t visible, uint32_t culled) {
+		s_frameStats.visibleObjects += visible;
+		s_frameStats.culledObjects += culled;
+	}
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <glad/gl.h>
+
+namespace xe {
+
+	// Frames kept in the render stats history
+	#define XE_RENDER_STATS_HISTORY 240
+
+	//----------------------------------------
+	// SECTION: Render stats
+	//----------------------------------------
+
+	struct RenderStats {
+		uint32_t drawCalls = 0;
+		uint32_t instancedDrawCalls = 0;
+		uint64_t triangles = 0;
+		uint64_t vertices = 0;
+
+		// Binds forwarded to GL by the state cache, see GLStateCounters
+		uint32_t shaderBinds = 0;
+		uint32_t vertexArrayBinds = 0;
+		uint32_t textureBinds = 0;
+
+		uint32_t uniformUploads = 0;
+		uint64_t bufferBytesUploaded = 0;
+
+		uint32_t visibleObjects = 0;
+		uint32_t culledObjects = 0;
+
+		uint32_t framebufferBlits = 0;
+	};
+
+	// Ring of the stats of the last frames
+	struct RenderStatsHistory {
+		std::array<RenderStats, XE_RENDER_STATS_HISTORY> frames = {};
+		uint32_t next = 0;
+		uint32_t count = 0;
+	};
+
+	void pushRenderStatsHistory(RenderStatsHistory& history, const RenderStats& stats);
+	// age 0 is the newest frame, age has to be below history.count
+	const RenderStats& getRenderStatsHistoryFrame(const RenderStatsHistory& history, uint32_t age);
+
+
+	//----------------------------------------
+	// SECTION: Render stats recording
+	//----------------------------------------
+
+	// Everything recorded between the two calls is counted for the frame, the renderer calls them from
+	// beginRenderFrame and endRenderFrame
+	void beginRenderStatsFrame();
+	RenderStats endRenderStatsFrame();
+
+	// GL calls that do not go through the state cache are reported by the code issuing them
+	void recordDrawCall(GLenum mode, GLsizei vertexCount, GLsizei instances = 1);
+	void recordUniformUpload();
+	void recordBufferUpload(size_t bytes);
+	void recordFramebufferBlit();
+	void recordVisibility(uint32_t visible, uint32_t culled);
+
+}
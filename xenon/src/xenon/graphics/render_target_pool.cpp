@@ -0,0 +1,128 @@
+#include "render_target_pool.h"
+
+#include <glm/glm.hpp>
+
+#include "xenon/core/log.h"
+#include "xenon/core/assert.h"
+#include "xenon/graphics/gl_state.h"
+
+namespace xe {
+
+	//----------------------------------------
+	// SECTION: Render target pool
+	//----------------------------------------
+
+	RenderTargetPool* createRenderTargetPool() {
+		return new RenderTargetPool();
+	}
+
+	void deleteRenderTarget(RenderTarget& target) {
+		forgetGLTexture(target.texture->textureID);
+		glDeleteTextures(1, &target.texture->textureID);
+		delete target.texture;
+		target.texture = nullptr;
+	}
+
+	void destroyRenderTargetPool(RenderTargetPool* pool) {
+		for (RenderTarget& target : pool->targets) {
+			if (target.inUse) {
+				XE_LOG_WARN_F("RENDER TARGET POOL: Render target {} is still in use", target.texture->textureID);
+			}
+			deleteRenderTarget(target);
+		}
+		delete pool;
+	}
+
+
+	//----------------------------------------
+	// SECTION: Render target pool functions
+	//----------------------------------------
+
+	GLuint getRenderTargetBucketSize(GLuint size) {
+		return ((glm::max(size, 1u) + XE_RENDER_TARGET_BUCKET_SIZE - 1) / XE_RENDER_TARGET_BUCKET_SIZE) * XE_RENDER_TARGET_BUCKET_SIZE;
+	}
+
+	bool operator==(const TextureParameters& a, const TextureParameters& b) {
+		return a.minFilter == b.minFilter && a.magFilter == b.magFilter && a.wrapS == b.wrapS && a.wrapT == b.wrapT && a.wrapR == b.wrapR;
+	}
+
+	bool operator==(const RenderTargetKey& a, const RenderTargetKey& b) {
+		return a.width == b.width && a.height == b.height && a.format == b.format && a.samples == b.samples && a.params == b.params;
+	}
+
+	size_t getTextureFormatPixelSize(TextureFormat format) {
+		// NOTE: Estimates, drivers usually pad three channel formats to four
+		switch (format) {
+		case TextureFormat::RGB_FLOAT:
+		case TextureFormat::RGBA_FLOAT:
+			return 8;
+		default:
+			return 4;
+		}
+	}
+
+	Texture* acquireRenderTarget(RenderTargetPool* pool, GLuint width, GLuint height, TextureFormat format, const TextureParameters& params, int samples) {
+		RenderTargetKey key = { getRenderTargetBucketSize(width), getRenderTargetBucketSize(height), format, samples, params };
+
+		for (RenderTarget& target : pool->targets) {
+			if (!target.inUse && target.key == key) {
+				target.inUse = true;
+				target.lastUsedFrame = pool->frame;
+				++pool->stats.reuses;
+				return target.texture;
+			}
+		}
+
+		RenderTarget target;
+		target.key = key;
+		target.texture = createEmptyTexture(key.width, key.height, format, params, samples);
+		target.size = (size_t)key.width * key.height * samples * getTextureFormatPixelSize(format);
+		target.lastUsedFrame = pool->frame;
+		target.inUse = true;
+		pool->targets.push_back(target);
+		++pool->stats.allocations;
+		return target.texture;
+	}
+
+	void releaseRenderTarget(RenderTargetPool* pool, Texture* texture) {
+		for (RenderTarget& target : pool->targets) {
+			if (target.texture == texture) {
+				XE_ASSERT(target.inUse);
+				target.inUse = false;
+				target.lastUsedFrame = pool->frame;
+				return;
+			}
+		}
+		XE_LOG_ERROR_F("RENDER TARGET POOL: Released texture {} does not belong to the pool", texture->textureID);
+	}
+
+	void updateRenderTargetPool(RenderTargetPool* pool) {
+		++pool->frame;
+
+		RenderTargetPoolStats& stats = pool->stats;
+		stats.targets = 0;
+		stats.idleTargets = 0;
+		stats.memory = 0;
+		stats.idleMemory = 0;
+
+		for (size_t i = 0; i < pool->targets.size();) {
+			RenderTarget& target = pool->targets[i];
+			if (!target.inUse && pool->frame - target.lastUsedFrame > XE_RENDER_TARGET_IDLE_FRAMES) {
+				deleteRenderTarget(target);
+				pool->targets[i] = pool->targets.back();
+				pool->targets.pop_back();
+				++stats.evictions;
+				continue;
+			}
+
+			++stats.targets;
+			stats.memory += target.size;
+			if (!target.inUse) {
+				++stats.idleTargets;
+				stats.idleMemory += target.size;
+			}
+			++i;
+		}
+	}
+
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glad/gl.h>
+
+#include "xenon/graphics/texture.h"
+
+namespace xe {
+
+	// Render target sizes are rounded up to multiples of this, resizes within a bucket reuse the same textures
+	#define XE_RENDER_TARGET_BUCKET_SIZE 128
+	// Released render targets that are not acquired again within this many frames are deleted
+	#define XE_RENDER_TARGET_IDLE_FRAMES 120
+
+	//----------------------------------------
+	// SECTION: Render target pool
+	//----------------------------------------
+
+	struct RenderTargetKey {
+		GLuint width = 0, height = 0;	// Bucket size
+		TextureFormat format = TextureFormat::UNKNOWN;
+		int samples = 1;
+		TextureParameters params;
+	};
+
+	struct RenderTarget {
+		RenderTargetKey key;
+		Texture* texture = nullptr;
+		size_t size = 0;				// Estimated memory in bytes
+		uint64_t lastUsedFrame = 0;
+		bool inUse = false;
+	};
+
+	struct RenderTargetPoolStats {
+		uint32_t targets = 0;
+		uint32_t idleTargets = 0;
+		size_t memory = 0;				// Estimated, bytes
+		size_t idleMemory = 0;
+
+		// Since the pool was created
+		uint32_t allocations = 0;
+		uint32_t reuses = 0;
+		uint32_t evictions = 0;
+	};
+
+	struct RenderTargetPool {
+		std::vector<RenderTarget> targets;
+		uint64_t frame = 0;
+		RenderTargetPoolStats stats;
+	};
+
+	RenderTargetPool* createRenderTargetPool();
+	// All render targets must have been released
+	void destroyRenderTargetPool(RenderTargetPool* pool);
+
+
+	//----------------------------------------
+	// SECTION: Render target pool functions
+	//----------------------------------------
+
+	GLuint getRenderTargetBucketSize(GLuint size);
+
+	// Returns an idle texture of the bucket of (width, height) or allocates one, the texture can be larger than requested
+	Texture* acquireRenderTarget(RenderTargetPool* pool, GLuint width, GLuint height, TextureFormat format, const TextureParameters& params, int samples = 1);
+	void releaseRenderTarget(RenderTargetPool* pool, Texture* texture);
+
+	// Advances the frame and evicts idle render targets, call once per frame
+	void updateRenderTargetPool(RenderTargetPool* pool);
+
+}
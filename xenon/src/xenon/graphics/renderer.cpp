@@ -3,8 +3,12 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "xenon/core/log.h"
+#include "xenon/core/assert.h"
+#include "xenon/core/profiler.h"
 #include "xenon/graphics/primitives.h"
 #include "xenon/graphics/brdf.h"
+#include "xenon/graphics/gl_state.h"
+#include "xenon/graphics/render_stats.h"
 
 #include "xenon/core/input.h"
 
@@ -14,16 +18,86 @@ namespace xe {
 	// SECTION: Renderer
 	//----------------------------------------
 
-	Renderer* createRenderer(Shader* shader, Shader* envShader) {
-		Texture* brdfLUT = generateBRDFLUT(512, 512);
-
-		return new Renderer{ shader, envShader, brdfLUT };
+	Renderer* createRenderer(Shader* shader, Shader* envShader, Shader* quantizedShader) {
+		Texture* brdfLUT = loadBRDFLUT();
+
+		Renderer* renderer = new Renderer{ shader, envShader, brdfLUT };
+		renderer->uploadBuffer = createUploadRingBuffer(XE_RENDERER_UPLOAD_REGION_SIZE);
+		renderer->quantizedShader = quantizedShader;
+		renderer->occlusionCuller = createOcclusionCuller();
+		renderer->renderTargetPool = createRenderTargetPool();
+		renderer->gpuProfiler = createGPUProfiler();
+		setActiveGPUProfiler(renderer->gpuProfiler);
+		renderer->textureStreamer = createTextureStreamer();
+		setActiveTextureStreamer(renderer->textureStreamer);
+		for (ShaderPermutationKey key = 0; key < renderer->depthShaders.size(); ++key) {
+			renderer->depthShaders[key] = loadShader("assets/shaders/depth.vert", "assets/shaders/depth.frag", key);
+		}
+		return renderer;
 	}
 
 	void destroyRenderer(Renderer* renderer) {
+		if (renderer->brdfLUT) {
+			destroyTexture(renderer->brdfLUT);
+		}
+		if (renderer->uploadBuffer) {
+			destroyUploadRingBuffer(renderer->uploadBuffer);
+		}
+		if (renderer->occlusionCuller) {
+			destroyOcclusionCuller(renderer->occlusionCuller);
+		}
+		for (Shader* shader : renderer->depthShaders) {
+			if (shader) {
+				destroyShader(shader);
+			}
+		}
+		if (renderer->renderTargetPool) {
+			destroyRenderTargetPool(renderer->renderTargetPool);
+		}
+		if (renderer->gpuProfiler) {
+			destroyGPUProfiler(renderer->gpuProfiler);
+		}
+		if (renderer->textureStreamer) {
+			destroyTextureStreamer(renderer->textureStreamer);
+		}
 		delete renderer;
 	}
 
+	void beginRenderFrame(Renderer* renderer) {
+		beginRenderStatsFrame();
+		if (renderer->gpuProfiler) {
+			beginGPUProfilerFrame(renderer->gpuProfiler);
+		}
+		if (renderer->uploadBuffer) {
+			beginUploadFrame(renderer->uploadBuffer);
+		}
+		if (renderer->renderTargetPool) {
+			updateRenderTargetPool(renderer->renderTargetPool);
+		}
+		if (renderer->textureStreamer) {
+			updateTextureStreamer(renderer->textureStreamer);
+		}
+	}
+
+	void endRenderFrame(Renderer* renderer) {
+		if (renderer->uploadBuffer) {
+			endUploadFrame(renderer->uploadBuffer);
+		}
+		if (renderer->gpuProfiler) {
+			endGPUProfilerFrame(renderer->gpuProfiler);
+		}
+		renderer->stats = endRenderStatsFrame();
+		pushRenderStatsHistory(renderer->statsHistory, renderer->stats);
+	}
+
+	const RenderStats& getRenderStats(const Renderer& renderer) {
+		return renderer.stats;
+	}
+
+	const RenderStatsHistory& getRenderStatsHistory(const Renderer& renderer) {
+		return renderer.statsHistory;
+	}
+
 	//----------------------------------------
 	// SECTION: Renderer functions
 	//----------------------------------------
@@ -39,66 +113,229 @@ namespace xe {
 		//loadInt(shader, "usingAttribWeights0", attributeArray[(GLuint)PrimitiveAttributeType::WEIGHTS_0].vbo == 0);
 	}
 
+	glm::mat3 computeNormalMatrix(const glm::mat4& transform) {
+		glm::mat3 linear = glm::mat3(transform);
+
+		// Fast path: rotation with uniform scale. The inverse transpose is then the matrix itself scaled by
+		// 1 / scale^2, which does not matter since normals are re-normalized in the vertex shader.
+		const float epsilon = 1e-4f;
+		float lengthX = glm::dot(linear[0], linear[0]);
+		float lengthY = glm::dot(linear[1], linear[1]);
+		float lengthZ = glm::dot(linear[2], linear[2]);
+		if (glm::abs(lengthX - lengthY) <= epsilon * lengthX && glm::abs(lengthX - lengthZ) <= epsilon * lengthX
+			&& glm::abs(glm::dot(linear[0], linear[1])) <= epsilon * lengthX
+			&& glm::abs(glm::dot(linear[0], linear[2])) <= epsilon * lengthX
+			&& glm::abs(glm::dot(linear[1], linear[2])) <= epsilon * lengthX) {
+			return linear;
+		}
+
+		return glm::transpose(glm::inverse(linear));
+	}
+
+	void loadLighting(const Renderer& renderer, const LightingBlock& lighting) {
+		XE_ASSERT(renderer.uploadBuffer);
+		UploadAllocation allocation = writeUpload(renderer.uploadBuffer, &lighting, sizeof(LightingBlock));
+		if (allocation.data) {
+			glBindBufferRange(GL_UNIFORM_BUFFER, XE_LIGHTING_BLOCK_BINDING, allocation.buffer, allocation.offset, allocation.size);
+		}
+	}
+
+	const Shader& getPrimitiveShader(const Renderer& renderer, const Primitive& primitive) {
+		if (primitive.vertexFormat == VertexFormat::QUANTIZED) {
+			XE_ASSERT(renderer.quantizedShader);
+			return *renderer.quantizedShader;
+		}
+		return *renderer.shader;
+	}
+
 	void setObjectID(const Renderer& renderer, UUID id) {
-		bindShader(*renderer.shader);
-		loadInt(*renderer.shader, "objectID", id);
-		unbindShader();
+		// NOTE: Every PBR permutation receives the ID without binding it, renderModel picks the program per primitive
+		for (const Shader* shader : { renderer.shader, renderer.quantizedShader }) {
+			if (shader) {
+				glProgramUniform1i(shader->programID, glGetUniformLocation(shader->programID, "objectID"), (GLint)id);
+			}
+		}
+		for (const Shader* shader : renderer.depthShaders) {
+			if (shader && (shader->permutation & XE_SHADER_PERMUTATION_OBJECT_ID)) {
+				glProgramUniform1i(shader->programID, glGetUniformLocation(shader->programID, "objectID"), (GLint)id);
+			}
+		}
 	}
 
-	void renderModel(const Renderer& renderer, const Model& model, const glm::mat4& transform, const Camera& camera, bool ignoreMaterials) {
-		size_t primitiveCounter = 0;
+	uint8_t selectModelLOD(const Model& model, const glm::mat4& transform, const Camera& camera, float lodBias, uint8_t currentLOD) {
+		if (model.lodCount <= 1) {
+			return 0;
+		}
 
-		std::vector<glm::mat4x4> globalPositions;
-		globalPositions.reserve(model.localPositions.size());
+		// Bounding sphere in world space
+		glm::vec3 center = transform * glm::vec4((model.bounds.min + model.bounds.max) * 0.5f, 1.0f);
+		float scale = glm::max(glm::length(glm::vec3(transform[0])), glm::max(glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2]))));
+		float radius = glm::length(model.bounds.max - model.bounds.min) * 0.5f * scale;
 
-		bindShader(*renderer.shader);
-		loadMat4(*renderer.shader, "projection", camera.projection);
-		loadMat4(*renderer.shader, "view", camera.inverseTransform);
-		loadVec3(*renderer.shader, "camera.position", camera.transform[3]);
-		loadVec3(*renderer.shader, "camera.direction", camera.transform[2]);
-
-		for (size_t i = 0; i < model.nodes.size(); ++i) {
-			const ModelNode& node = model.nodes[i];
-			
-			const glm::mat4& parentMatrix = i == 0 ? glm::mat4(1.0f) : globalPositions[node.parent];
-			globalPositions.push_back(parentMatrix * model.localPositions[i]);
-			loadMat4(*renderer.shader, "transform", transform * globalPositions[i]);
-
-			// pii = primitiveIndicesIndex
-			for (size_t pii = primitiveCounter; pii < primitiveCounter + node.primitiveCount; ++pii) {
-				const Primitive& primitive = model.primitives[model.primitiveIndices[pii]];
-
-				loadUsedAttributes(*renderer.shader, model.primitiveAttributes[model.primitiveIndices[pii]]);
-
-				glBindVertexArray(primitive.vao);
-				if (!ignoreMaterials) {
-					if (primitive.material >= 0) {
-						loadMaterial(*renderer.shader, model.materials[primitive.material]);
-					}
-					else {
-						// TODO: Default material
-						loadMaterial(*renderer.shader, Material());
-					}
-				}
+		float distance = glm::distance(center, glm::vec3(camera.transform[3]));
+		if (distance <= radius) {
+			return 0;
+		}
+
+		// Size of one model space unit projected on the screen, as a fraction of the screen height
+		float projectedScale = scale * camera.projection[1][1] * 0.5f / distance * glm::exp2(-lodBias);
+
+		// Pick the lowest detail level with an acceptable error, lowering detail requires a margin (hysteresis)
+		for (uint8_t level = model.lodCount - 1; level > 0; --level) {
+			float threshold = level > currentLOD ? XE_LOD_SCREEN_ERROR * (1.0f - XE_LOD_HYSTERESIS) : XE_LOD_SCREEN_ERROR;
+			if (model.lodErrors[level] * projectedScale <= threshold) {
+				return level;
+			}
+		}
+		return 0;
+	}
 
-				// Render primitive
-				// Check if indexed
-				if (primitive.ebo != 0) {
-					glDrawElements(primitive.mode, primitive.count, primitive.indexType, 0);
+	const Material& getPrimitiveMaterial(const Model& model, const Primitive& primitive) {
+		// TODO: Default material
+		static const Material defaultMaterial;
+		return primitive.material >= 0 ? model.materials[primitive.material] : defaultMaterial;
+	}
+
+	void renderModel(const Renderer& renderer, const Model& model, const glm::mat4& transform, const Camera& camera, bool ignoreMaterials, uint8_t lod, bool depthPrepassed) {
+		XE_PROFILE_FUNCTION();
+		XE_ASSERT(model.primitiveMatrices.size() == model.primitiveIndices.size());
+
+		const Shader* shader = nullptr;
+
+		// Primitives of the same node share their matrix, only upload when it changes
+		const glm::mat4* previousMatrix = nullptr;
+
+		// pii = primitiveIndicesIndex
+		for (size_t pii = 0; pii < model.primitiveIndices.size(); ++pii) {
+			const Primitive& primitive = model.primitives[model.primitiveIndices[pii]];
+
+			// Switch shader permutation when the vertex format changes
+			const Shader& primitiveShader = getPrimitiveShader(renderer, primitive);
+			if (shader != &primitiveShader) {
+				shader = &primitiveShader;
+				bindShader(*shader);
+				loadMat4(*shader, "projection", camera.projection);
+				loadMat4(*shader, "view", camera.inverseTransform);
+				loadVec3(*shader, "camera.position", camera.transform[3]);
+				loadVec3(*shader, "camera.direction", camera.transform[2]);
+				previousMatrix = nullptr;
+			}
+
+			const glm::mat4& primitiveMatrix = model.primitiveMatrices[pii];
+			if (!previousMatrix || *previousMatrix != primitiveMatrix) {
+				glm::mat4 worldMatrix = transform * primitiveMatrix;
+				loadMat4(*shader, "transform", worldMatrix);
+				loadMat3(*shader, "normalMatrix", computeNormalMatrix(worldMatrix));
+				previousMatrix = &primitiveMatrix;
+			}
+
+			if (primitive.vertexFormat == VertexFormat::QUANTIZED) {
+				loadVec3(*shader, "positionOffset", primitive.positionOffset);
+				loadVec3(*shader, "positionScale", primitive.positionScale);
+			}
+
+			loadUsedAttributes(*shader, model.primitiveAttributes[model.primitiveIndices[pii]]);
+
+			if (depthPrepassed) {
+				setGLDepthFunc(getPrimitiveMaterial(model, primitive).alphaMode == AlphaMode::BLEND ? GL_LEQUAL : GL_EQUAL);
+			}
+
+			bindGLVertexArray(primitive.vao);
+			if (!ignoreMaterials) {
+				if (primitive.material >= 0) {
+					loadMaterial(*shader, model.materials[primitive.material]);
 				}
 				else {
-					glDrawArrays(primitive.mode, 0, primitive.count);
+					// TODO: Default material
+					loadMaterial(*shader, Material());
+				}
+
+				// Binding the texture before its levels arrive is fine, the streamer swaps the object on the next frame
+				if (renderer.textureStreamer && primitive.material >= 0) {
+					float lodOffset = computeTextureLODOffset(primitive, transform * primitiveMatrix, camera, renderer.textureStreamer->viewportHeight);
+					requestMaterialTextureLevels(renderer.textureStreamer, model.materials[primitive.material], lodOffset);
 				}
 			}
-			glBindVertexArray(0);
 
-			primitiveCounter += node.primitiveCount;
+			// Render primitive
+			// Check if indexed
+			if (primitive.ebo != 0) {
+				const PrimitiveLOD& level = primitive.lods[glm::min<uint8_t>(lod, primitive.lodCount - 1)];
+				glDrawElements(primitive.mode, level.count, primitive.indexType, (const void*)level.indexOffset);
+				recordDrawCall(primitive.mode, level.count);
+			}
+			else {
+				glDrawArrays(primitive.mode, 0, primitive.count);
+				recordDrawCall(primitive.mode, primitive.count);
+			}
 		}
+	}
+
+	void renderModelDepth(const Renderer& renderer, const Model& model, const glm::mat4& transform, const Camera& camera, uint8_t lod, ShaderPermutationKey permutation) {
+		XE_ASSERT(model.primitiveMatrices.size() == model.primitiveIndices.size());
+
+		const Shader* shader = nullptr;
+		const glm::mat4* previousMatrix = nullptr;
+
+		// pii = primitiveIndicesIndex
+		for (size_t pii = 0; pii < model.primitiveIndices.size(); ++pii) {
+			const Primitive& primitive = model.primitives[model.primitiveIndices[pii]];
+			const Material& material = getPrimitiveMaterial(model, primitive);
+			// Transparent surfaces stay pickable, the object ID pass draws them as opaque
+			if (material.alphaMode == AlphaMode::BLEND && !(permutation & XE_SHADER_PERMUTATION_OBJECT_ID)) {
+				continue;
+			}
+
+			ShaderPermutationKey key = permutation;
+			if (primitive.vertexFormat == VertexFormat::QUANTIZED) key |= XE_SHADER_PERMUTATION_QUANTIZED_VERTICES;
+			if (material.alphaMode == AlphaMode::MASK) key |= XE_SHADER_PERMUTATION_ALPHA_CUTOUT;
+
+			const Shader* primitiveShader = renderer.depthShaders[key];
+			XE_ASSERT(primitiveShader);
+			if (shader != primitiveShader) {
+				shader = primitiveShader;
+				bindShader(*shader);
+				loadMat4(*shader, "projection", camera.projection);
+				loadMat4(*shader, "view", camera.inverseTransform);
+				previousMatrix = nullptr;
+			}
+
+			const glm::mat4& primitiveMatrix = model.primitiveMatrices[pii];
+			if (!previousMatrix || *previousMatrix != primitiveMatrix) {
+				loadMat4(*shader, "transform", transform * primitiveMatrix);
+				previousMatrix = &primitiveMatrix;
+			}
+
+			if (primitive.vertexFormat == VertexFormat::QUANTIZED) {
+				loadVec3(*shader, "positionOffset", primitive.positionOffset);
+				loadVec3(*shader, "positionScale", primitive.positionScale);
+			}
 
-		unbindShader();
+			if (key & XE_SHADER_PERMUTATION_ALPHA_CUTOUT) {
+				const Texture* albedo = material.pbrMetallicRoughness.baseColorTexture;
+				if (albedo) {
+					bindGLTextureUnit(0, albedo->textureID);
+				}
+				loadInt(*shader, "usingAlbedoMap", albedo != nullptr);
+				loadVec4(*shader, "baseColorFactor", material.pbrMetallicRoughness.baseColorFactor);
+				loadFloat(*shader, "alphaCutoff", material.alphaCutoff);
+			}
+
+			bindGLVertexArray(primitive.vao);
+			if (primitive.ebo != 0) {
+				const PrimitiveLOD& level = primitive.lods[glm::min<uint8_t>(lod, primitive.lodCount - 1)];
+				glDrawElements(primitive.mode, level.count, primitive.indexType, (const void*)level.indexOffset);
+				recordDrawCall(primitive.mode, level.count);
+			}
+			else {
+				glDrawArrays(primitive.mode, 0, primitive.count);
+				recordDrawCall(primitive.mode, primitive.count);
+			}
+		}
 	}
 
 	void renderEnvironment(Renderer* renderer, const Environment& environment, const Camera& camera) {
+		XE_GPU_SCOPE("Environment");
 		if (!renderer->envCubeModel) {
 			renderer->envCubeModel = generateCubeModel(glm::vec3(1.0f));
 		}
@@ -107,17 +344,14 @@ namespace xe {
 		loadMat4(*renderer->envShader, "projection", camera.projection);
 		loadMat4(*renderer->envShader, "view", camera.inverseTransform);
 
-		glBindTextureUnit(0, environment.environmentCubemap->textureID);
+		bindGLTextureUnit(0, environment.environmentCubemap->textureID);
 
-		glDisable(GL_CULL_FACE);
+		setGLCapability(GL_CULL_FACE, false);
 		const Primitive& primitive = renderer->envCubeModel->primitives[0];
-		glBindVertexArray(primitive.vao);
+		bindGLVertexArray(primitive.vao);
 		glDrawArrays(primitive.mode, 0, primitive.count);
-		glBindVertexArray(0);
-		glEnable(GL_CULL_FACE);
-
-		glBindTextureUnit(0, 0);
-		unbindShader();
+		recordDrawCall(primitive.mode, primitive.count);
+		setGLCapability(GL_CULL_FACE, true);
 	}
 
 	void renderGrid(Shader* shader, Model* model, const Camera& camera) {
@@ -128,11 +362,9 @@ namespace xe {
 		loadFloat(*shader, "far", camera.far);
 
 		const Primitive& primitive = model->primitives[0];
-		glBindVertexArray(primitive.vao);
+		bindGLVertexArray(primitive.vao);
 		glDrawArrays(primitive.mode, 0, primitive.count);
-		glBindVertexArray(0);
-
-		unbindShader();
+		recordDrawCall(primitive.mode, primitive.count);
 	}
 
 
@@ -160,17 +392,13 @@ namespace xe {
 	void renderFramebufferToScreen(const FramebufferRenderer& renderer, const Framebuffer& framebuffer) {
 		bindShader(*renderer.shader);
 
-		glBindTextureUnit(0, framebuffer.attachments.at(GL_COLOR_ATTACHMENT0).texture->textureID);
+		bindGLTextureUnit(0, framebuffer.attachments.at(GL_COLOR_ATTACHMENT0).texture->textureID);
 
 		const Primitive& primitive = renderer.planeModel->primitives[0];
 
-		glBindVertexArray(primitive.vao);
+		bindGLVertexArray(primitive.vao);
 		glDrawArrays(primitive.mode, 0, primitive.count);
-		glBindVertexArray(0);
-
-		glBindTextureUnit(0, 0);
-
-		unbindShader();
+		recordDrawCall(primitive.mode, primitive.count);
 	}
 
 }
@@ -1,11 +1,20 @@
 #pragma once
 
+#include <array>
+
 #include "xenon/graphics/shader.h"
 #include "xenon/graphics/model.h"
 #include "xenon/graphics/material.h"
 #include "xenon/graphics/camera.h"
 #include "xenon/graphics/framebuffer.h"
 #include "xenon/graphics/environment.h"
+#include "xenon/graphics/light.h"
+#include "xenon/graphics/upload_buffer.h"
+#include "xenon/graphics/occlusion_culling.h"
+#include "xenon/graphics/render_target_pool.h"
+#include "xenon/graphics/render_stats.h"
+#include "xenon/graphics/gpu_profiler.h"
+#include "xenon/graphics/texture_streaming.h"
 
 #include "xenon/core/uuid.h"
 
@@ -15,23 +24,84 @@ namespace xe {
 	// SECTION: Renderer
 	//----------------------------------------
 
+	#define XE_MAX_POINT_LIGHTS 4
+	#define XE_LIGHTING_BLOCK_BINDING 0
+
+	// Size of the per-frame region of the renderer upload buffer
+	#define XE_RENDERER_UPLOAD_REGION_SIZE (1024 * 1024)
+
+	// NOTE: std140 layout, must match LightingBlock in pbr.frag
+	struct LightingBlock {
+		struct {
+			glm::vec4 position;
+			glm::vec4 color;
+		} pointLights[XE_MAX_POINT_LIGHTS];
+		// Environment irradiance, rgb = coefficient (vec4 for the std140 array stride)
+		glm::vec4 irradianceSH[XE_SH_COEFFICIENTS];
+		int pointLightsUsed;
+		// std140 rounds the block size up to a multiple of 16, the bound range must cover all of it
+		int padding[3];
+	};
+	static_assert(sizeof(LightingBlock) % 16 == 0, "LightingBlock must match the std140 block size");
+
 	struct Renderer {
 		Shader* shader;
 		Shader* envShader;
 		Texture* brdfLUT;
 		Model* envCubeModel = nullptr;
+		UploadRingBuffer* uploadBuffer = nullptr;
+		// PBR permutation for VertexFormat::QUANTIZED primitives (XE_SHADER_PERMUTATION_QUANTIZED_VERTICES)
+		Shader* quantizedShader = nullptr;
+		OcclusionCuller* occlusionCuller = nullptr;
+		// Depth shader permutations, indexed by their ShaderPermutationKey (quantized vertices, alpha cutout, object ID)
+		std::array<Shader*, 8> depthShaders = {};
+		// Textures of transient and resizable framebuffers, see createFramebuffer
+		RenderTargetPool* renderTargetPool = nullptr;
+		// Counters of the last finished frame and the frames before it
+		RenderStats stats;
+		RenderStatsHistory statsHistory;
+		// Active GPU profiler while the renderer exists, see XE_GPU_SCOPE
+		GPUProfiler* gpuProfiler = nullptr;
+		// Active texture streamer while the renderer exists, renderModel records the levels materials need
+		TextureStreamer* textureStreamer = nullptr;
 	};
 
-	Renderer* createRenderer(Shader* shader, Shader* envShader);
+	Renderer* createRenderer(Shader* shader, Shader* envShader, Shader* quantizedShader = nullptr);
 	void destroyRenderer(Renderer* renderer);
 
+	// Frame boundaries for per-frame GPU data, all rendering using the renderer should happen in between
+	void beginRenderFrame(Renderer* renderer);
+	void endRenderFrame(Renderer* renderer);
+	// Stats of the last frame finished with endRenderFrame
+	const RenderStats& getRenderStats(const Renderer& renderer);
+	const RenderStatsHistory& getRenderStatsHistory(const Renderer& renderer);
+
 
 	//----------------------------------------
 	// SECTION: Renderer functions
 	//----------------------------------------
 
+	glm::mat3 computeNormalMatrix(const glm::mat4& transform);
+
+	void loadLighting(const Renderer& renderer, const LightingBlock& lighting);
+
+	const Shader& getPrimitiveShader(const Renderer& renderer, const Primitive& primitive);
+
 	void setObjectID(const Renderer& renderer, UUID id);
-	void renderModel(const Renderer& renderer, const Model& model, const glm::mat4& transform, const Camera& camera, bool ignoreMaterials = false);
+	// LOD selection error threshold as a fraction of the screen height (~1 pixel at 1080p)
+	#define XE_LOD_SCREEN_ERROR 0.001f
+	// Switching to a lower detail level requires the error to be this much below the threshold
+	#define XE_LOD_HYSTERESIS 0.25f
+
+	uint8_t selectModelLOD(const Model& model, const glm::mat4& transform, const Camera& camera, float lodBias, uint8_t currentLOD);
+
+	// When depthPrepassed is set the depth of the model is already in the depth buffer (renderModelDepth) and the
+	// main pass tests with GL_EQUAL, primitives that were skipped by the prepass are tested with GL_LEQUAL
+	void renderModel(const Renderer& renderer, const Model& model, const glm::mat4& transform, const Camera& camera, bool ignoreMaterials = false, uint8_t lod = 0, bool depthPrepassed = false);
+	// Depth only rendering for the depth prepass, AlphaMode::BLEND primitives are skipped unless the object ID is
+	// written. Additional permutation bits (XE_SHADER_PERMUTATION_OBJECT_ID) select the shader together with the
+	// bits of each primitive.
+	void renderModelDepth(const Renderer& renderer, const Model& model, const glm::mat4& transform, const Camera& camera, uint8_t lod = 0, ShaderPermutationKey permutation = 0);
 	void renderEnvironment(Renderer* renderer, const Environment& environment, const Camera& camera);
 
 	void renderGrid(Shader* shader, Model* model, const Camera& camera);
@@ -5,6 +5,9 @@
 
 #include "xenon/core/log.h"
 #include "xenon/core/filesystem.h"
+#include "xenon/core/profiler.h"
+#include "xenon/graphics/gl_state.h"
+#include "xenon/graphics/render_stats.h"
 
 namespace xe {
 
@@ -57,13 +60,33 @@ namespace xe {
 		return true;
 	}
 
-	Shader* loadShader(const std::string& vertexShaderPath, const std::string& fragmentShaderPath) {
+	// Inserts the permutation defines after the #version directive
+	void applyPermutation(std::string& source, ShaderPermutationKey permutation) {
+		if (permutation == 0) {
+			return;
+		}
+
+		std::string defines;
+		if (permutation & XE_SHADER_PERMUTATION_QUANTIZED_VERTICES) defines += "#define XE_QUANTIZED_VERTICES\n";
+		if (permutation & XE_SHADER_PERMUTATION_ALPHA_CUTOUT) defines += "#define XE_ALPHA_CUTOUT\n";
+		if (permutation & XE_SHADER_PERMUTATION_OBJECT_ID) defines += "#define XE_OBJECT_ID\n";
+
+		size_t version = source.find("#version");
+		size_t position = version == std::string::npos ? 0 : source.find('\n', version);
+		position = position == std::string::npos ? source.size() : position + 1;
+		source.insert(position, defines);
+	}
+
+	Shader* loadShader(const std::string& vertexShaderPath, const std::string& fragmentShaderPath, ShaderPermutationKey permutation) {
+		XE_PROFILE_FUNCTION();
 		std::string vSource;
 		std::string fSource;
 		if (!loadTextResource(vertexShaderPath, vSource) || !loadTextResource(fragmentShaderPath, fSource)) {
 			XE_LOG_ERROR_F("SHADER: Failed to load shader");
 			return nullptr;
 		}
+		applyPermutation(vSource, permutation);
+		applyPermutation(fSource, permutation);
 
 		GLuint vertexShader = compileShader(vSource.c_str(), GL_VERTEX_SHADER);
 		GLuint fragmentShader = compileShader(fSource.c_str(), GL_FRAGMENT_SHADER);
@@ -97,10 +120,40 @@ namespace xe {
 		glDeleteShader(vertexShader);
 		glDeleteShader(fragmentShader);
 
-		return new Shader{ programID };
+		return new Shader{ programID, permutation };
+	}
+
+	Shader* loadComputeShader(const std::string& computeShaderPath, ShaderPermutationKey permutation) {
+		std::string cSource;
+		if (!loadTextResource(computeShaderPath, cSource)) {
+			XE_LOG_ERROR("SHADER: Failed to load compute shader");
+			return nullptr;
+		}
+		applyPermutation(cSource, permutation);
+
+		GLuint computeShader = compileShader(cSource.c_str(), GL_COMPUTE_SHADER);
+		if (computeShader == -1) {
+			XE_LOG_ERROR("SHADER: Failed to compile compute shader");
+			return nullptr;
+		}
+
+		GLuint programID = glCreateProgram();
+		glAttachShader(programID, computeShader);
+		glLinkProgram(programID);
+		if (!checkStatus(programID, GL_LINK_STATUS)) {
+			glDeleteProgram(programID);
+			glDeleteShader(computeShader);
+			return nullptr;
+		}
+
+		glDetachShader(programID, computeShader);
+		glDeleteShader(computeShader);
+
+		return new Shader{ programID, permutation };
 	}
 
 	void destroyShader(Shader* shader) {
+		forgetGLProgram(shader->programID);
 		glDeleteProgram(shader->programID);
 		delete shader;
 	}
@@ -111,36 +164,52 @@ namespace xe {
 	//----------------------------------------
 
 	void bindShader(const Shader& shader) {
-		glUseProgram(shader.programID);
+		bindGLProgram(shader.programID);
 	}
 
 	void unbindShader() {
-		glUseProgram(0);
+		bindGLProgram(0);
 	}
 
 
 	void loadInt(const Shader& shader, const char* name, int value) {
 		glUniform1i(glGetUniformLocation(shader.programID, name), value);
+		recordUniformUpload();
 	}
 
 	void loadFloat(const Shader& shader, const char* name, float value) {
 		glUniform1f(glGetUniformLocation(shader.programID, name), value);
+		recordUniformUpload();
+	}
+
+	void loadIVec2(const Shader& shader, const char* name, glm::ivec2 value) {
+		glUniform2i(glGetUniformLocation(shader.programID, name), value.x, value.y);
+		recordUniformUpload();
 	}
 
 	void loadVec2(const Shader& shader, const char* name, glm::vec2 value) {
 		glUniform2f(glGetUniformLocation(shader.programID, name), value.x, value.y);
+		recordUniformUpload();
 	}
 
 	void loadVec3(const Shader& shader, const char* name, glm::vec3 value) {
 		glUniform3f(glGetUniformLocation(shader.programID, name), value.x, value.y, value.z);
+		recordUniformUpload();
 	}
 
 	void loadVec4(const Shader& shader, const char* name, glm::vec4 value) {
 		glUniform4f(glGetUniformLocation(shader.programID, name), value.x, value.y, value.z, value.w);
+		recordUniformUpload();
+	}
+
+	void loadMat3(const Shader& shader, const char* name, glm::mat3 value) {
+		glUniformMatrix3fv(glGetUniformLocation(shader.programID, name), 1, GL_FALSE, glm::value_ptr(value));
+		recordUniformUpload();
 	}
 
 	void loadMat4(const Shader& shader, const char* name, glm::mat4 value) {
 		glUniformMatrix4fv(glGetUniformLocation(shader.programID, name), 1, GL_FALSE, glm::value_ptr(value));
+		recordUniformUpload();
 	}
 
 
@@ -148,7 +217,7 @@ namespace xe {
 		loadVec4(shader, "baseColorFactor", material.pbrMetallicRoughness.baseColorFactor);
 
 		if (material.pbrMetallicRoughness.baseColorTexture) {
-			glBindTextureUnit(0, material.pbrMetallicRoughness.baseColorTexture->textureID);
+			bindGLTextureUnit(0, material.pbrMetallicRoughness.baseColorTexture->textureID);
 			loadInt(shader, "usingAlbedoMap", true);
 		}
 		else {
@@ -159,7 +228,7 @@ namespace xe {
 		loadFloat(shader, "roughnessFactor", material.pbrMetallicRoughness.roughnessFactor);
 
 		if (material.pbrMetallicRoughness.metallicRoughnessTexture) {
-			glBindTextureUnit(1, material.pbrMetallicRoughness.metallicRoughnessTexture->textureID);
+			bindGLTextureUnit(1, material.pbrMetallicRoughness.metallicRoughnessTexture->textureID);
 			loadInt(shader, "usingMetallicRoughnessMap", true);
 		}
 		else {
@@ -167,7 +236,7 @@ namespace xe {
 		}
 
 		if (material.normalTexture) {
-			glBindTextureUnit(2, material.normalTexture->textureID);
+			bindGLTextureUnit(2, material.normalTexture->textureID);
 			loadInt(shader, "usingNormalMap", true);
 		}
 		else {
@@ -175,7 +244,7 @@ namespace xe {
 		}
 
 		if (material.occlusionTexture) {
-			glBindTextureUnit(3, material.occlusionTexture->textureID);
+			bindGLTextureUnit(3, material.occlusionTexture->textureID);
 			loadInt(shader, "usingAOMap", true);
 		}
 		else {
@@ -183,7 +252,7 @@ namespace xe {
 		}
 
 		if (material.emissiveTexture) {
-			glBindTextureUnit(4, material.emissiveTexture->textureID);
+			bindGLTextureUnit(4, material.emissiveTexture->textureID);
 			loadInt(shader, "usingEmissiveMap", true);
 		}
 		else {
@@ -196,9 +265,5 @@ namespace xe {
 		loadInt(shader, "doubleSided", material.doubleSided);  // bool = int
 	}
 
-	void loadLight(const Shader& shader, const glm::vec3& position, const PointLightComponent& light, int index) {
-		loadVec3(shader, ("pointLights[" + std::to_string(index) + "].position").c_str(), position);
-		loadVec3(shader, ("pointLights[" + std::to_string(index) + "].color").c_str(), light.color);
-	}
 }
 
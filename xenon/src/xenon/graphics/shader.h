@@ -1,10 +1,10 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <glm/glm.hpp>
 
 #include "xenon/graphics/material.h"
-#include "xenon/graphics/light.h"
 
 namespace xe {
 
@@ -12,11 +12,20 @@ namespace xe {
 	// SECTION: Shader
 	//----------------------------------------
 
+	// Shader permutation key, every set bit adds its define to both stages when compiling
+	typedef uint32_t ShaderPermutationKey;
+
+	#define XE_SHADER_PERMUTATION_QUANTIZED_VERTICES	(1 << 0)	// XE_QUANTIZED_VERTICES, see VertexFormat::QUANTIZED
+	#define XE_SHADER_PERMUTATION_ALPHA_CUTOUT			(1 << 1)	// XE_ALPHA_CUTOUT, see AlphaMode::MASK
+	#define XE_SHADER_PERMUTATION_OBJECT_ID				(1 << 2)	// XE_OBJECT_ID, object ID output of the depth shader
+
 	struct Shader {
 		unsigned int programID;
+		ShaderPermutationKey permutation = 0;
 	};
 
-	Shader* loadShader(const std::string& vertexShaderPath, const std::string& fragmentShaderPath);
+	Shader* loadShader(const std::string& vertexShaderPath, const std::string& fragmentShaderPath, ShaderPermutationKey permutation = 0);
+	Shader* loadComputeShader(const std::string& computeShaderPath, ShaderPermutationKey permutation = 0);
 	void destroyShader(Shader* shader);
 
 	//----------------------------------------
@@ -28,12 +37,13 @@ namespace xe {
 
 	void loadInt(const Shader& shader, const char* name, int value);
 	void loadFloat(const Shader& shader, const char* name, float value);
+	void loadIVec2(const Shader& shader, const char* name, glm::ivec2 value);
 	void loadVec2(const Shader& shader, const char* name, glm::vec2 value);
 	void loadVec3(const Shader& shader, const char* name, glm::vec3 value);
 	void loadVec4(const Shader& shader, const char* name, glm::vec4 value);
+	void loadMat3(const Shader& shader, const char* name, glm::mat3 value);
 	void loadMat4(const Shader& shader, const char* name, glm::mat4 value);
 
 	void loadMaterial(const Shader& shader, const Material& material);
-	void loadLight(const Shader& shader, const glm::vec3& position, const PointLightComponent& light, int index);
 
 }
@@ -0,0 +1,155 @@
+#include "spherical_harmonics.h"
+
+#include <vector>
+
+#include <glm/gtc/constants.hpp>
+
+#include "xenon/core/log.h"
+#include "xenon/core/job_system.h"
+#include "xenon/core/profiler.h"
+
+namespace xe {
+
+	// Rows of a face projected by one job
+	#define XE_SH_ROWS_PER_JOB 8
+
+	//----------------------------------------
+	// SECTION: Spherical harmonics
+	//----------------------------------------
+
+	void evaluateSHBasis(const glm::vec3& direction, float basis[XE_SH_COEFFICIENTS]) {
+		float x = direction.x, y = direction.y, z = direction.z;
+		basis[0] = 0.282095f;
+		basis[1] = 0.488603f * y;
+		basis[2] = 0.488603f * z;
+		basis[3] = 0.488603f * x;
+		basis[4] = 1.092548f * x * y;
+		basis[5] = 1.092548f * y * z;
+		basis[6] = 0.315392f * (3.0f * z * z - 1.0f);
+		basis[7] = 1.092548f * x * z;
+		basis[8] = 0.546274f * (x * x - y * y);
+	}
+
+	glm::vec3 evaluateSH(const SphericalHarmonics& sh, const glm::vec3& direction) {
+		float basis[XE_SH_COEFFICIENTS];
+		evaluateSHBasis(direction, basis);
+		glm::vec3 result = glm::vec3(0.0f);
+		for (int i = 0; i < XE_SH_COEFFICIENTS; ++i) {
+			result += sh.coefficients[i] * basis[i];
+		}
+		return result;
+	}
+
+	// Direction through the texel at (u, v) in [-1, 1], same mapping as the GL cubemap lookup
+	glm::vec3 getCubemapDirection(int face, float u, float v) {
+		switch (face) {
+		case 0: return glm::vec3(1.0f, -v, -u);
+		case 1: return glm::vec3(-1.0f, -v, u);
+		case 2: return glm::vec3(u, 1.0f, v);
+		case 3: return glm::vec3(u, -1.0f, -v);
+		case 4: return glm::vec3(u, -v, 1.0f);
+		default: return glm::vec3(-u, -v, -1.0f);
+		}
+	}
+
+	void projectCubemapFaceSH(SHProjection& projection, int face, const float* rgb, int size) {
+		uint32_t jobs = (uint32_t)(size + XE_SH_ROWS_PER_JOB - 1) / XE_SH_ROWS_PER_JOB;
+		std::vector<SHProjection> partials(jobs);
+
+		parallelFor((uint32_t)size, XE_SH_ROWS_PER_JOB, [&](uint32_t begin, uint32_t end) {
+			XE_PROFILE_SCOPE("projectCubemapFaceSH");
+			SHProjection& partial = partials[begin / XE_SH_ROWS_PER_JOB];
+			float basis[XE_SH_COEFFICIENTS];
+			float texelSize = 2.0f / size;
+
+			for (uint32_t y = begin; y < end; ++y) {
+				float v = (y + 0.5f) * texelSize - 1.0f;
+				const float* row = rgb + (size_t)y * size * 3;
+				for (int x = 0; x < size; ++x) {
+					float u = (x + 0.5f) * texelSize - 1.0f;
+					// Solid angle of the texel, projected area of the texel on the unit sphere
+					float distanceSquared = 1.0f + u * u + v * v;
+					float weight = 1.0f / (distanceSquared * glm::sqrt(distanceSquared));
+
+					evaluateSHBasis(glm::normalize(getCubemapDirection(face, u, v)), basis);
+					glm::vec3 radiance = glm::vec3(row[x * 3], row[x * 3 + 1], row[x * 3 + 2]) * weight;
+					for (int i = 0; i < XE_SH_COEFFICIENTS; ++i) {
+						partial.sh.coefficients[i] += radiance * basis[i];
+					}
+					partial.weight += weight;
+				}
+			}
+		});
+
+		for (const SHProjection& partial : partials) {
+			for (int i = 0; i < XE_SH_COEFFICIENTS; ++i) {
+				projection.sh.coefficients[i] += partial.sh.coefficients[i];
+			}
+			projection.weight += partial.weight;
+		}
+	}
+
+	SphericalHarmonics finishSHProjection(const SHProjection& projection) {
+		// The weights of all faces add up to the area of the sphere, normalizing removes the discretization error
+		SphericalHarmonics sh;
+		if (projection.weight <= 0.0f) {
+			return sh;
+		}
+		float scale = 4.0f * glm::pi<float>() / projection.weight;
+		for (int i = 0; i < XE_SH_COEFFICIENTS; ++i) {
+			sh.coefficients[i] = projection.sh.coefficients[i] * scale;
+		}
+		return sh;
+	}
+
+	int getSHSourceLevel(const Texture& cubemap, int& size) {
+		// First level not larger than the source resolution, or the smallest level the texture has
+		GLint level = 0, levelSize = 0;
+		glGetTextureLevelParameteriv(cubemap.textureID, 0, GL_TEXTURE_WIDTH, &levelSize);
+		size = levelSize;
+		while (size > XE_SH_SOURCE_RESOLUTION) {
+			glGetTextureLevelParameteriv(cubemap.textureID, level + 1, GL_TEXTURE_WIDTH, &levelSize);
+			if (levelSize == 0) {
+				break;
+			}
+			++level;
+			size = levelSize;
+		}
+		return level;
+	}
+
+	SphericalHarmonics projectCubemapSH(const Texture& cubemap) {
+		XE_PROFILE_FUNCTION();
+
+		int size = 0;
+		int level = getSHSourceLevel(cubemap, size);
+		if (size == 0) {
+			XE_LOG_ERROR("SPHERICAL_HARMONICS: Cubemap has no data");
+			return SphericalHarmonics{};
+		}
+
+		// Read one face at a time, large cubemaps without mip levels would need all six in memory otherwise
+		SHProjection projection;
+		std::vector<float> face((size_t)size * size * 3);
+		for (int i = 0; i < 6; ++i) {
+			glGetTextureSubImage(cubemap.textureID, level, 0, 0, i, size, size, 1, GL_RGB, GL_FLOAT, (GLsizei)(face.size() * sizeof(float)), face.data());
+			projectCubemapFaceSH(projection, i, face.data(), size);
+		}
+		return finishSHProjection(projection);
+	}
+
+	SphericalHarmonics convolveIrradianceSH(const SphericalHarmonics& radiance) {
+		// Clamped cosine lobe per band (pi, 2pi/3, pi/4), divided by pi
+		const float bands[XE_SH_COEFFICIENTS] = { 1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f };
+		SphericalHarmonics irradiance;
+		for (int i = 0; i < XE_SH_COEFFICIENTS; ++i) {
+			irradiance.coefficients[i] = radiance.coefficients[i] * bands[i];
+		}
+		return irradiance;
+	}
+
+	SphericalHarmonics computeIrradianceSH(const Texture& cubemap) {
+		return convolveIrradianceSH(projectCubemapSH(cubemap));
+	}
+
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "xenon/graphics/texture.h"
+
+namespace xe {
+
+	// Coefficients of an order 2 (L2) expansion
+	#define XE_SH_COEFFICIENTS 9
+	// Largest cubemap face projected, smaller mip levels of the source are used when it has them
+	#define XE_SH_SOURCE_RESOLUTION 128
+
+	//----------------------------------------
+	// SECTION: Spherical harmonics
+	//----------------------------------------
+
+	/*
+		Real spherical harmonics up to band 2, ordered (l, m) = (0, 0), (1, -1), (1, 0), (1, 1), (2, -2) ... (2, 2).
+		Diffuse lighting only needs the low bands, nine RGB coefficients reproduce the irradiance of any environment
+		with an average error of a few percent (Ramamoorthi and Hanrahan, "An Efficient Representation for
+		Irradiance Environment Maps").
+	*/
+
+	struct SphericalHarmonics {
+		glm::vec3 coefficients[XE_SH_COEFFICIENTS] = {};
+	};
+
+	// Sum of the projections of cubemap faces, weighted by the solid angle of each texel
+	struct SHProjection {
+		SphericalHarmonics sh;
+		float weight = 0.0f;
+	};
+
+	void evaluateSHBasis(const glm::vec3& direction, float basis[XE_SH_COEFFICIENTS]);
+	glm::vec3 evaluateSH(const SphericalHarmonics& sh, const glm::vec3& direction);
+
+	// Adds one face (GL face order +X, -X, +Y, -Y, +Z, -Z) of RGB float texels with rows in GL order to the projection
+	void projectCubemapFaceSH(SHProjection& projection, int face, const float* rgb, int size);
+	// Radiance expansion of all projected faces
+	SphericalHarmonics finishSHProjection(const SHProjection& projection);
+
+	// First mip level of the cubemap not larger than XE_SH_SOURCE_RESOLUTION and its size, the size is 0 when the
+	// cubemap has no data
+	int getSHSourceLevel(const Texture& cubemap, int& size);
+	// Reads the cubemap back and projects it, uses the level of getSHSourceLevel
+	SphericalHarmonics projectCubemapSH(const Texture& cubemap);
+
+	// Convolves radiance with the clamped cosine lobe and divides by pi, evaluating the result gives the value
+	// an irradiance map stores (diffuse = albedo * irradiance)
+	SphericalHarmonics convolveIrradianceSH(const SphericalHarmonics& radiance);
+
+	// Irradiance of an environment cubemap, ready for Environment::irradianceSH
+	SphericalHarmonics computeIrradianceSH(const Texture& cubemap);
+
+}
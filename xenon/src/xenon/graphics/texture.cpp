@@ -1,12 +1,26 @@
 #include "texture.h"
 
 #include <map>
+#include <vector>
 
 #include <stb_image.h>
 #include <ktx.h>
 
 #include "xenon/core/assert.h"
 #include "xenon/core/log.h"
+#include "xenon/core/profiler.h"
+#include "xenon/graphics/gl_state.h"
+#include "xenon/graphics/mipmap.h"
+#include "xenon/graphics/texture_compression.h"
+#include "xenon/graphics/texture_streaming.h"
+
+// S3TC is an extension, core profile loaders do not always define its formats
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
 
 namespace xe {
 
@@ -14,8 +28,40 @@ namespace xe {
 	// SECTION: Texture
 	//----------------------------------------
 
+	// Levels 1 to n of an 8 bit texture, filtered on the CPU and cached, see mipmap.h
+	void uploadTextureMipmaps(GLuint textureID, const unsigned char* data, int width, int height, int channels, TextureFormat format, TextureUsage usage) {
+		XE_PROFILE_FUNCTION();
+		bool cpuFilter = format == TextureFormat::RGB || format == TextureFormat::RGBA || format == TextureFormat::SRGB || format == TextureFormat::SRGBA;
+		if (!cpuFilter || (channels != 3 && channels != 4)) {
+			glGenerateTextureMipmap(textureID);
+			return;
+		}
+
+		MipmapFilter filter = getTextureMipmapFilter(format, usage);
+		uint64_t key = hashMipChainSource(data, width, height, channels, filter);
+		std::vector<MipLevel> levels;
+		bool cached = loadMipChainCache(key, width, height, channels, filter, levels);
+		if (!cached) {
+			levels = generateMipChain(data, width, height, channels, filter);
+		}
+
+		for (size_t i = 0; i < levels.size(); ++i) {
+			const MipLevel& level = levels[i];
+			glTextureSubImage2D(textureID, (GLint)i + 1, 0, 0, level.width, level.height, getTextureFormatBaseFormat(format), GL_UNSIGNED_BYTE, level.pixels.data());
+		}
+
+		if (!cached) {
+			writeMipChainCache(key, channels, filter, std::move(levels));
+		}
+	}
+
+	// Float and integer formats keep the driver filter
+	void uploadTextureMipmaps(GLuint textureID, const float* data, int width, int height, int channels, TextureFormat format, TextureUsage usage) {
+		glGenerateTextureMipmap(textureID);
+	}
+
 	template<typename T>
-	Texture* loadTextureInternal(const T* data, int width, int height, int channels, TextureFormat format, const TextureParameters& params) {
+	Texture* loadTextureInternal(const T* data, int width, int height, int channels, TextureFormat format, const TextureParameters& params, TextureUsage usage = TextureUsage::COLOR) {
 		// Create GL texture
 		GLuint textureID;
 		glCreateTextures(GL_TEXTURE_2D, 1, &textureID);
@@ -25,8 +71,17 @@ namespace xe {
 		glTextureParameteri(textureID, GL_TEXTURE_WRAP_S, params.wrapS);
 		glTextureParameteri(textureID, GL_TEXTURE_WRAP_T, params.wrapT);
 
-		glTextureStorage2D(textureID, 1, getTextureFormatInternalFormat(format), width, height);
+		// Only filters that sample them get a mip chain, the storage of others stays a single level
+		int levels = isMipmapFilter(params.minFilter) ? getMipLevelCount(width, height) : 1;
+		glTextureStorage2D(textureID, levels, getTextureFormatInternalFormat(format), width, height);
+
+		// Image rows and mip levels are tightly packed, RGB rows and small levels are not 4 byte aligned
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 		glTextureSubImage2D(textureID, 0, 0, 0, width, height, getTextureFormatBaseFormat(format), getTextureFormatDataType(format), data);
+		if (levels > 1) {
+			uploadTextureMipmaps(textureID, data, width, height, channels, format, usage);
+		}
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
 		return new Texture{ AssetMetadata(), AssetRuntimeData(), textureID, params, width, height, channels, format };
 	}
@@ -58,8 +113,17 @@ namespace xe {
 		return texture;
 	}
 
-	Texture* loadTexture(const unsigned char* data, int width, int height, int channels, TextureFormat format = TextureFormat::RGBA, const TextureParameters& params = TextureParameters{}) {
-		return loadTextureInternal(data, width, height, channels, format, params);
+	Texture* loadTexture(const unsigned char* data, int width, int height, int channels, TextureFormat format = TextureFormat::RGBA, const TextureParameters& params = TextureParameters{}, TextureUsage usage = TextureUsage::COLOR) {
+		// Block compressed from the derived data cache, the first import stays uncompressed while a job encodes it
+		if (isTextureCompressible(format, channels)) {
+			uint64_t key = hashCompressedTextureSource(data, width, height, channels, format, usage);
+			Texture* texture = loadCompressedTexture(key, width, height, channels, format, params, usage);
+			if (texture) {
+				return texture;
+			}
+			encodeCompressedTexture(key, data, width, height, channels, format, usage);
+		}
+		return loadTextureInternal(data, width, height, channels, format, params, usage);
 	}
 
 	Texture* loadKTXTexture(const std::string& path, const TextureParameters& params) {
@@ -118,7 +182,7 @@ namespace xe {
 		return new Texture{ AssetMetadata(), AssetRuntimeData(), textureID, params, width, height, 0, format };
 	}
 
-	Texture* createEmptyCubemapTexture(int resolution, TextureFormat format, const TextureParameters& params) {
+	Texture* createEmptyCubemapTexture(int resolution, TextureFormat format, const TextureParameters& params, int levels) {
 		GLuint textureID;
 		glCreateTextures(GL_TEXTURE_CUBE_MAP, 1, &textureID);
 
@@ -128,7 +192,7 @@ namespace xe {
 		glTextureParameteri(textureID, GL_TEXTURE_WRAP_T, params.wrapT);
 		glTextureParameteri(textureID, GL_TEXTURE_WRAP_R, params.wrapR);
 
-		glTextureStorage2D(textureID, 1, getTextureFormatInternalFormat(format), resolution, resolution);
+		glTextureStorage2D(textureID, levels, getTextureFormatInternalFormat(format), resolution, resolution);
 		/*for (int face = 0; face < 6; ++face) {
 			glTextureSubImage3D(textureID, 0, 0, 0, face, resolution, resolution, 1, getTextureFormatBaseFormat(format), getTextureFormatDataType(format), nullptr);
 		}*/
@@ -136,6 +200,15 @@ namespace xe {
 		return new Texture{ AssetMetadata(), AssetRuntimeData(), textureID, params, resolution, resolution, 0, format };
 	}
 
+	void destroyTexture(Texture* texture) {
+		if (TextureStreamer* streamer = getActiveTextureStreamer()) {
+			unregisterStreamedTexture(streamer, texture);
+		}
+		forgetGLTexture(texture->textureID);
+		glDeleteTextures(1, &texture->textureID);
+		delete texture;
+	}
+
 
 	//----------------------------------------
 	// SECTION: Texture functions
@@ -170,6 +243,9 @@ namespace xe {
 			return GL_RGBA8;
 		}
 		else if (format == TextureFormat::RED) {
+			return GL_R8;
+		}
+		else if (format == TextureFormat::RED_INTEGER) {
 			return GL_R32UI;
 		}
 		else if (format == TextureFormat::RGB_FLOAT) {
@@ -178,20 +254,44 @@ namespace xe {
 		else if (format == TextureFormat::RGBA_FLOAT) {
 			return GL_RGBA16F;
 		}
+		else if (format == TextureFormat::RG_FLOAT) {
+			return GL_RG16F;
+		}
 		else if (format == TextureFormat::DEPTH) {
 			return GL_DEPTH_COMPONENT24;
 		}
+		else if (format == TextureFormat::BC1) {
+			return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		}
+		else if (format == TextureFormat::BC1_SRGB) {
+			return GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;
+		}
+		else if (format == TextureFormat::BC4) {
+			return GL_COMPRESSED_RED_RGTC1;
+		}
+		else if (format == TextureFormat::BC5) {
+			return GL_COMPRESSED_RG_RGTC2;
+		}
+		else if (format == TextureFormat::BC7) {
+			return GL_COMPRESSED_RGBA_BPTC_UNORM;
+		}
+		else if (format == TextureFormat::BC7_SRGB) {
+			return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+		}
 		return GL_INVALID_ENUM;
 	}
 
 	GLenum getTextureFormatBaseFormat(TextureFormat format) {
-		if (format == TextureFormat::RGB || format == TextureFormat::SRGB || format == TextureFormat::RGB_FLOAT) {
+		if (format == TextureFormat::RGB || format == TextureFormat::SRGB || format == TextureFormat::RGB_FLOAT || format == TextureFormat::BC1 || format == TextureFormat::BC1_SRGB) {
 			return GL_RGB;
 		}
-		else if (format == TextureFormat::RGBA || format == TextureFormat::SRGBA || format == TextureFormat::RGBA_FLOAT) {
+		else if (format == TextureFormat::RGBA || format == TextureFormat::SRGBA || format == TextureFormat::RGBA_FLOAT || format == TextureFormat::BC7 || format == TextureFormat::BC7_SRGB) {
 			return GL_RGBA;
 		}
-		else if (format == TextureFormat::RED) {
+		else if (format == TextureFormat::RG_FLOAT || format == TextureFormat::BC5) {
+			return GL_RG;
+		}
+		else if (format == TextureFormat::RED || format == TextureFormat::RED_INTEGER || format == TextureFormat::BC4) {
 			return GL_RED;
 		}
 		else if (format == TextureFormat::DEPTH) {
@@ -201,35 +301,76 @@ namespace xe {
 	}
 
 	GLenum getTextureFormatDataType(TextureFormat format) {
-		if (format == TextureFormat::RED) {
+		if (format == TextureFormat::RED_INTEGER) {
 			return GL_UNSIGNED_INT;
 		}
-		else if (format == TextureFormat::RGB_FLOAT || format == TextureFormat::RGBA_FLOAT || format == TextureFormat::DEPTH) {
+		else if (format == TextureFormat::RGB_FLOAT || format == TextureFormat::RGBA_FLOAT || format == TextureFormat::RG_FLOAT || format == TextureFormat::DEPTH) {
 			return GL_FLOAT;
 		}
 		return GL_UNSIGNED_BYTE;
 	}
 
 	bool isTextureFormatFloatFormat(TextureFormat format) {
-		if (format == TextureFormat::RGB_FLOAT || format == TextureFormat::RGBA_FLOAT || format == TextureFormat::DEPTH) {
+		if (format == TextureFormat::RGB_FLOAT || format == TextureFormat::RGBA_FLOAT || format == TextureFormat::RG_FLOAT || format == TextureFormat::DEPTH) {
 			return true;
 		}
 		return false;
 	}
 
+	bool isTextureFormatCompressedFormat(TextureFormat format) {
+		return format == TextureFormat::BC1 || format == TextureFormat::BC1_SRGB || format == TextureFormat::BC4
+			|| format == TextureFormat::BC5 || format == TextureFormat::BC7 || format == TextureFormat::BC7_SRGB;
+	}
+
+	size_t getTextureLevelSize(TextureFormat format, int width, int height) {
+		size_t blocks = (size_t)((width + 3) / 4) * ((height + 3) / 4);
+		if (format == TextureFormat::BC1 || format == TextureFormat::BC1_SRGB || format == TextureFormat::BC4) {
+			return blocks * 8;
+		}
+		if (format == TextureFormat::BC5 || format == TextureFormat::BC7 || format == TextureFormat::BC7_SRGB) {
+			return blocks * 16;
+		}
+
+		size_t texels = (size_t)width * height;
+		switch (format) {
+		case TextureFormat::RED:
+			return texels;
+		case TextureFormat::RGB:
+		case TextureFormat::SRGB:
+			return texels * 3;
+		case TextureFormat::RED_INTEGER:
+		case TextureFormat::RGBA:
+		case TextureFormat::SRGBA:
+		case TextureFormat::RG_FLOAT:
+		case TextureFormat::DEPTH:
+			return texels * 4;
+		case TextureFormat::RGB_FLOAT:
+			return texels * 6;
+		case TextureFormat::RGBA_FLOAT:
+			return texels * 8;
+		default:
+			return 0;
+		}
+	}
+
+	bool isMipmapFilter(GLenum filter) {
+		return filter == GL_NEAREST_MIPMAP_NEAREST || filter == GL_LINEAR_MIPMAP_NEAREST
+			|| filter == GL_NEAREST_MIPMAP_LINEAR || filter == GL_LINEAR_MIPMAP_LINEAR;
+	}
+
 	//----------------------------------------
 	// SECTION: Texture asset functions
 	//----------------------------------------
 
-	Texture* createTextureAsset(AssetManager* manager, const std::string& path, const unsigned char* data, int width, int height, int channels, TextureFormat format, const TextureParameters& params) {
-		Texture* texture = loadTexture(data, width, height, channels, format, params);
+	Texture* createTextureAsset(AssetManager* manager, const std::string& path, const unsigned char* data, int width, int height, int channels, TextureFormat format, const TextureParameters& params, TextureUsage usage) {
+		Texture* texture = loadTexture(data, width, height, channels, format, params, usage);
 		Asset* asset = createAsset(manager, path, AssetType::Texture, UUID::None());
 		copyAssetMetaRuntimeData(asset, texture);
 		return texture;
 	}
 
-	Texture* createInternalTextureAsset(AssetManager* manager, const std::string& hostPath, const std::string& internalPath, const unsigned char* data, int width, int height, int channels, TextureFormat format, const TextureParameters& params) {
-		return createTextureAsset(manager, XE_HOST_PATH_BEGIN + hostPath + XE_HOST_PATH_END + internalPath, data, width, height, channels, format, params);
+	Texture* createInternalTextureAsset(AssetManager* manager, const std::string& hostPath, const std::string& internalPath, const unsigned char* data, int width, int height, int channels, TextureFormat format, const TextureParameters& params, TextureUsage usage) {
+		return createTextureAsset(manager, XE_HOST_PATH_BEGIN + hostPath + XE_HOST_PATH_END + internalPath, data, width, height, channels, format, params, usage);
 	}
 
 
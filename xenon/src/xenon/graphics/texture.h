@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 
 #include <glad/gl.h>
@@ -36,7 +37,8 @@ namespace xe {
 	};*/
 
 	enum class TextureFormat : GLenum {
-		RED = 0,
+		// 32 bit unsigned integers, object ID attachments
+		RED_INTEGER = 0,
 		RGB = 1,
 		RGBA = 2,
 
@@ -48,9 +50,30 @@ namespace xe {
 
 		DEPTH = 7,
 
+		RG_FLOAT = 8,
+
+		RED = 9,
+
+		// Block compressed, transcoded from the derived data cache (texture_compression.h)
+		BC1 = 10,
+		BC1_SRGB = 11,
+		BC4 = 12,
+		BC5 = 13,
+		BC7 = 14,
+		BC7_SRGB = 15,
+
 		UNKNOWN = -1
 	};
 
+	// What the texels hold, decides how derived data like mip levels is filtered
+	enum class TextureUsage : uint8_t {
+		COLOR = 0,
+		NORMAL = 1,
+		// glTF layout, roughness in green and metallic in blue
+		METALLIC_ROUGHNESS = 2,
+		OCCLUSION = 3
+	};
+
 	struct TextureParameters {
 		GLenum minFilter = GL_LINEAR;
 		GLenum magFilter = GL_LINEAR;
@@ -60,7 +83,8 @@ namespace xe {
 	};
 
 	struct Texture : Asset {
-		const GLuint textureID;
+		// Streamed textures get a new texture object when their resident levels change (texture_streaming.h)
+		GLuint textureID;
 		const TextureParameters params;
 
 		const int width;
@@ -80,7 +104,8 @@ namespace xe {
 	
 
 	Texture* createEmptyTexture(int width, int height, TextureFormat format = TextureFormat::RGBA, const TextureParameters& params = TextureParameters{}, int samples = 1);
-	Texture* createEmptyCubemapTexture(int resolution, TextureFormat format, const TextureParameters& params = TextureParameters{});
+	Texture* createEmptyCubemapTexture(int resolution, TextureFormat format, const TextureParameters& params = TextureParameters{}, int levels = 1);
+	void destroyTexture(Texture* texture);
 	
 
 	//----------------------------------------
@@ -92,13 +117,17 @@ namespace xe {
 	GLenum getTextureFormatBaseFormat(TextureFormat format);
 	GLenum getTextureFormatDataType(TextureFormat format);
 	bool isTextureFormatFloatFormat(TextureFormat format);
+	bool isTextureFormatCompressedFormat(TextureFormat format);
+	// Bytes of one level of the format, block formats round up to whole 4x4 blocks
+	size_t getTextureLevelSize(TextureFormat format, int width, int height);
+	bool isMipmapFilter(GLenum filter);
 
 	//----------------------------------------
 	// SECTION: Texture asset functions
 	//----------------------------------------
 
-	Texture* createTextureAsset(AssetManager* manager, const std::string& path, const unsigned char* data, int width, int height, int channels, TextureFormat format = TextureFormat::RGBA, const TextureParameters& params = TextureParameters{});
-	Texture* createInternalTextureAsset(AssetManager* manager, const std::string& hostPath, const std::string& internalPath, const unsigned char* data, int width, int height, int channels, TextureFormat format = TextureFormat::RGBA, const TextureParameters& params = TextureParameters{});
+	Texture* createTextureAsset(AssetManager* manager, const std::string& path, const unsigned char* data, int width, int height, int channels, TextureFormat format = TextureFormat::RGBA, const TextureParameters& params = TextureParameters{}, TextureUsage usage = TextureUsage::COLOR);
+	Texture* createInternalTextureAsset(AssetManager* manager, const std::string& hostPath, const std::string& internalPath, const unsigned char* data, int width, int height, int channels, TextureFormat format = TextureFormat::RGBA, const TextureParameters& params = TextureParameters{}, TextureUsage usage = TextureUsage::COLOR);
 
 	struct TextureSerializer : AssetSerializer {
 		void serialize(Asset* asset) const override;
@@ -0,0 +1,451 @@
+#include "texture_compression.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <ktx.h>
+
+#include "xenon/core/log.h"
+#include "xenon/core/hash.h"
+#include "xenon/core/job_system.h"
+#include "xenon/core/profiler.h"
+#include "xenon/graphics/mipmap.h"
+#include "xenon/graphics/texture_streaming.h"
+
+namespace xe {
+
+	// Uncompressed Vulkan formats of the encoder input, R8 / RGB8 / RGBA8 with their sRGB variants
+	#define XE_TEXTURE_VK_FORMAT_R8 9
+	#define XE_TEXTURE_VK_FORMAT_R8_SRGB 15
+	#define XE_TEXTURE_VK_FORMAT_RGB8 23
+	#define XE_TEXTURE_VK_FORMAT_RGB8_SRGB 29
+	#define XE_TEXTURE_VK_FORMAT_RGBA8 37
+	#define XE_TEXTURE_VK_FORMAT_RGBA8_SRGB 43
+	// KTX2 header in front of the level index, each index entry holds offset, length and uncompressed length
+	#define XE_KTX2_HEADER_SIZE 80
+	#define XE_KTX2_LEVEL_INDEX_ENTRY_SIZE 24
+
+	//----------------------------------------
+	// SECTION: Texture compression
+	//----------------------------------------
+
+	bool hasGLExtension(const char* name) {
+		GLint count = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+		for (GLint i = 0; i < count; ++i) {
+			const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+			if (extension && std::strcmp(extension, name) == 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	const TextureCompressionSupport& getTextureCompressionSupport() {
+		static const TextureCompressionSupport support = []() {
+			TextureCompressionSupport result;
+			// Core since OpenGL 4.2 and 3.0, the extensions are checked for drivers that report a lower version
+			GLint major = 0, minor = 0;
+			glGetIntegerv(GL_MAJOR_VERSION, &major);
+			glGetIntegerv(GL_MINOR_VERSION, &minor);
+			result.bptc = major > 4 || (major == 4 && minor >= 2) || hasGLExtension("GL_ARB_texture_compression_bptc");
+			result.rgtc = major >= 3 || hasGLExtension("GL_ARB_texture_compression_rgtc");
+			result.s3tc = hasGLExtension("GL_EXT_texture_compression_s3tc");
+			result.s3tcSRGB = result.s3tc && hasGLExtension("GL_EXT_texture_sRGB");
+			XE_LOG_INFO_F("TEXTURE: Block compression BPTC: {}, RGTC: {}, S3TC: {}, S3TC sRGB: {}", result.bptc, result.rgtc, result.s3tc, result.s3tcSRGB);
+			return result;
+		}();
+		return support;
+	}
+
+	bool isTextureCompressible(TextureFormat format, int channels) {
+		if (format == TextureFormat::RED) {
+			return channels == 1;
+		}
+		if (format == TextureFormat::RGB || format == TextureFormat::SRGB) {
+			return channels == 3;
+		}
+		if (format == TextureFormat::RGBA || format == TextureFormat::SRGBA) {
+			return channels == 4;
+		}
+		return false;
+	}
+
+	BasisCodec selectBasisCodec(TextureUsage usage, int channels) {
+		if (usage == TextureUsage::NORMAL || usage == TextureUsage::METALLIC_ROUGHNESS) {
+			return BasisCodec::UASTC;
+		}
+		return BasisCodec::ETC1S;
+	}
+
+	TextureFormat selectCompressedFormat(TextureFormat format, TextureUsage usage, int channels) {
+		const TextureCompressionSupport& support = getTextureCompressionSupport();
+		bool srgb = format == TextureFormat::SRGB || format == TextureFormat::SRGBA;
+
+		if (usage == TextureUsage::NORMAL || usage == TextureUsage::METALLIC_ROUGHNESS) {
+			if (support.rgtc) {
+				return TextureFormat::BC5;
+			}
+		}
+		else if (usage == TextureUsage::OCCLUSION || channels == 1) {
+			if (support.rgtc) {
+				return TextureFormat::BC4;
+			}
+		}
+		else if (channels == 3 && (srgb ? support.s3tcSRGB : support.s3tc)) {
+			return srgb ? TextureFormat::BC1_SRGB : TextureFormat::BC1;
+		}
+		else if (support.bptc) {
+			return srgb ? TextureFormat::BC7_SRGB : TextureFormat::BC7;
+		}
+		return srgb ? TextureFormat::SRGBA : TextureFormat::RGBA;
+	}
+
+	ktx_transcode_fmt_e getBasisTranscodeFormat(TextureFormat format) {
+		switch (format) {
+		case TextureFormat::BC1:
+		case TextureFormat::BC1_SRGB:
+			return KTX_TTF_BC1_RGB;
+		case TextureFormat::BC4:
+			return KTX_TTF_BC4_R;
+		case TextureFormat::BC5:
+			return KTX_TTF_BC5_RG;
+		case TextureFormat::BC7:
+		case TextureFormat::BC7_SRGB:
+			return KTX_TTF_BC7_RGBA;
+		default:
+			return KTX_TTF_RGBA32;
+		}
+	}
+
+	// The encoder input is swizzled so the transcoded channels hold the data, BC5 takes X from red and Y from alpha
+	const char* getBasisInputSwizzle(TextureUsage usage, int channels) {
+		if (channels < 3) {
+			return nullptr;
+		}
+		if (usage == TextureUsage::NORMAL) {
+			return "rrrg";
+		}
+		if (usage == TextureUsage::METALLIC_ROUGHNESS) {
+			return "gggb";
+		}
+		if (usage == TextureUsage::OCCLUSION) {
+			return "rrr1";
+		}
+		return nullptr;
+	}
+
+	// Moves the data back to the channels pbr.frag samples
+	void applyCompressedTextureSwizzle(GLuint textureID, TextureUsage usage, TextureFormat format) {
+		bool rgba = format == TextureFormat::RGBA || format == TextureFormat::SRGBA;
+		if (usage == TextureUsage::NORMAL && rgba) {
+			const GLint swizzle[4] = { GL_RED, GL_ALPHA, GL_ONE, GL_ONE };
+			glTextureParameteriv(textureID, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+		}
+		else if (usage == TextureUsage::METALLIC_ROUGHNESS) {
+			const GLint swizzle[4] = { GL_ONE, GL_RED, rgba ? GL_ALPHA : GL_GREEN, GL_ONE };
+			glTextureParameteriv(textureID, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+		}
+	}
+
+
+	//----------------------------------------
+	// SECTION: Compressed texture cache
+	//----------------------------------------
+
+	std::string getCompressedTextureCachePath(uint64_t key) {
+		char name[40];
+		std::snprintf(name, sizeof(name), "%016llx_basis.ktx2", (unsigned long long)key);
+		return std::string(XE_TEXTURE_COMPRESSION_CACHE_DIRECTORY) + name;
+	}
+
+	uint64_t hashCompressedTextureSource(const uint8_t* pixels, int width, int height, int channels, TextureFormat format, TextureUsage usage) {
+		XE_PROFILE_FUNCTION();
+		uint64_t hash = hashBytes(pixels, (size_t)width * height * channels);
+		hash = hashValue(hash, XE_TEXTURE_COMPRESSION_CACHE_VERSION);
+		hash = hashValue(hash, XE_MIPMAP_CACHE_VERSION);
+		hash = hashValue(hash, XE_TEXTURE_ETC1S_QUALITY);
+		hash = hashValue(hash, (uint64_t)width);
+		hash = hashValue(hash, (uint64_t)height);
+		hash = hashValue(hash, (uint64_t)channels);
+		hash = hashValue(hash, (uint64_t)format);
+		return hashValue(hash, (uint64_t)usage);
+	}
+
+	// Loaded and transcoded to the target format, nullptr when there is no usable file
+	ktxTexture2* openCompressedTextureCache(const std::string& path, int width, int height, TextureFormat target) {
+		ktxTexture2* cache = nullptr;
+		if (!std::filesystem::exists(path)
+			|| ktxTexture2_CreateFromNamedFile(path.c_str(), KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, &cache) != KTX_SUCCESS) {
+			return nullptr;
+		}
+
+		bool valid = cache->baseWidth == (ktx_uint32_t)width
+			&& cache->baseHeight == (ktx_uint32_t)height
+			&& cache->numLevels == (ktx_uint32_t)getMipLevelCount(width, height)
+			&& ktxTexture2_NeedsTranscoding(cache)
+			&& ktxTexture2_TranscodeBasis(cache, getBasisTranscodeFormat(target), 0) == KTX_SUCCESS;
+		if (!valid) {
+			XE_LOG_WARN_F("TEXTURE: Compressed cache {} is unusable", path);
+			ktxTexture_Destroy(ktxTexture(cache));
+			return nullptr;
+		}
+		return cache;
+	}
+
+	const char* getTranscodedTextureSuffix(TextureFormat format) {
+		switch (format) {
+		case TextureFormat::BC1: return "bc1.ktx2";
+		case TextureFormat::BC1_SRGB: return "bc1_srgb.ktx2";
+		case TextureFormat::BC4: return "bc4.ktx2";
+		case TextureFormat::BC5: return "bc5.ktx2";
+		case TextureFormat::BC7: return "bc7.ktx2";
+		case TextureFormat::BC7_SRGB: return "bc7_srgb.ktx2";
+		case TextureFormat::SRGBA: return "srgba.ktx2";
+		default: return "rgba.ktx2";
+		}
+	}
+
+	// The Basis file transcoded once for the format of this GPU, <key>_basis.ktx2 becomes <key>_bc7.ktx2
+	std::string getTranscodedTextureCachePath(const std::string& path, TextureFormat format) {
+		size_t suffix = path.rfind("basis.ktx2");
+		return path.substr(0, suffix == std::string::npos ? path.size() : suffix) + getTranscodedTextureSuffix(format);
+	}
+
+	// Written to a temporary file and renamed, loads and streaming jobs never see a partial file
+	void writeTranscodedTextureCache(ktxTexture2* cache, const std::string& path) {
+		XE_PROFILE_FUNCTION();
+		static std::atomic<uint32_t> s_nextTemporary{ 0 };
+		std::string temporary = path + "." + std::to_string(s_nextTemporary.fetch_add(1, std::memory_order_relaxed)) + ".tmp";
+		std::error_code error;
+		if (ktxTexture_WriteToNamedFile(ktxTexture(cache), temporary.c_str()) != KTX_SUCCESS) {
+			XE_LOG_ERROR_F("TEXTURE: Failed to write {}", path);
+			std::filesystem::remove(temporary, error);
+			return;
+		}
+		std::filesystem::rename(temporary, path, error);
+		if (error) {
+			std::filesystem::remove(temporary, error);
+		}
+	}
+
+	// Block data of levels [firstLevel, endLevel) of a transcoded texture in memory
+	void copyCompressedTextureLevels(ktxTexture2* cache, int width, int height, int firstLevel, int endLevel, std::vector<MipLevel>& levels) {
+		const uint8_t* data = ktxTexture_GetData(ktxTexture(cache));
+		levels.resize(endLevel - firstLevel);
+		for (int level = firstLevel; level < endLevel; ++level) {
+			ktx_size_t offset = 0;
+			ktxTexture_GetImageOffset(ktxTexture(cache), level, 0, 0, &offset);
+			ktx_size_t size = ktxTexture_GetImageSize(ktxTexture(cache), level);
+
+			MipLevel& target = levels[level - firstLevel];
+			target.width = std::max(width >> level, 1);
+			target.height = std::max(height >> level, 1);
+			target.pixels.assign(data + offset, data + offset + size);
+		}
+	}
+
+	// Only the header is parsed and the requested levels are read from the file, false when it is missing or stale
+	bool readTranscodedTextureLevels(const std::string& path, int width, int height, int firstLevel, int endLevel, std::vector<MipLevel>& levels) {
+		ktxTexture2* cache = nullptr;
+		if (!std::filesystem::exists(path)
+			|| ktxTexture2_CreateFromNamedFile(path.c_str(), KTX_TEXTURE_CREATE_NO_FLAGS, &cache) != KTX_SUCCESS) {
+			return false;
+		}
+
+		bool valid = cache->baseWidth == (ktx_uint32_t)width
+			&& cache->baseHeight == (ktx_uint32_t)height
+			&& cache->numLevels == (ktx_uint32_t)getMipLevelCount(width, height)
+			&& !ktxTexture2_NeedsTranscoding(cache)
+			&& cache->supercompressionScheme == KTX_SS_NONE;
+		std::ifstream file(path, std::ios::binary);
+		// Image offsets are relative to the smallest level, the first one in the file
+		uint64_t dataOffset = 0;
+		if (valid) {
+			file.seekg(XE_KTX2_HEADER_SIZE + (std::streamoff)(cache->numLevels - 1) * XE_KTX2_LEVEL_INDEX_ENTRY_SIZE);
+			file.read(reinterpret_cast<char*>(&dataOffset), sizeof(dataOffset));
+		}
+
+		levels.resize(endLevel - firstLevel);
+		for (int level = firstLevel; valid && file && level < endLevel; ++level) {
+			ktx_size_t offset = 0;
+			ktxTexture_GetImageOffset(ktxTexture(cache), level, 0, 0, &offset);
+			ktx_size_t size = ktxTexture_GetImageSize(ktxTexture(cache), level);
+
+			MipLevel& target = levels[level - firstLevel];
+			target.width = std::max(width >> level, 1);
+			target.height = std::max(height >> level, 1);
+			target.pixels.resize(size);
+			file.seekg((std::streamoff)(dataOffset + offset));
+			file.read(reinterpret_cast<char*>(target.pixels.data()), (std::streamsize)size);
+		}
+		ktxTexture_Destroy(ktxTexture(cache));
+
+		if (!valid || !file) {
+			XE_LOG_WARN_F("TEXTURE: Transcoded cache {} is unusable", path);
+			return false;
+		}
+		return true;
+	}
+
+	GLuint createCompressedTextureStorage(TextureFormat format, const TextureParameters& params, TextureUsage usage, int width, int height, int firstLevel, int levelCount) {
+		GLuint textureID;
+		glCreateTextures(GL_TEXTURE_2D, 1, &textureID);
+		glTextureParameteri(textureID, GL_TEXTURE_MIN_FILTER, params.minFilter);
+		glTextureParameteri(textureID, GL_TEXTURE_MAG_FILTER, params.magFilter);
+		glTextureParameteri(textureID, GL_TEXTURE_WRAP_S, params.wrapS);
+		glTextureParameteri(textureID, GL_TEXTURE_WRAP_T, params.wrapT);
+		applyCompressedTextureSwizzle(textureID, usage, format);
+
+		glTextureStorage2D(textureID, levelCount - firstLevel, getTextureFormatInternalFormat(format), std::max(width >> firstLevel, 1), std::max(height >> firstLevel, 1));
+		return textureID;
+	}
+
+	void uploadCompressedTextureLevel(GLuint textureID, TextureFormat format, int level, int width, int height, const uint8_t* data, size_t size) {
+		if (isTextureFormatCompressedFormat(format)) {
+			glCompressedTextureSubImage2D(textureID, level, 0, 0, width, height, getTextureFormatInternalFormat(format), (GLsizei)size, data);
+		}
+		else {
+			glTextureSubImage2D(textureID, level, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data);
+		}
+	}
+
+	Texture* loadCompressedTexture(uint64_t key, int width, int height, int channels, TextureFormat format, const TextureParameters& params, TextureUsage usage) {
+		XE_PROFILE_FUNCTION();
+		std::string path = getCompressedTextureCachePath(key);
+		TextureFormat target = selectCompressedFormat(format, usage, channels);
+
+		// With a streamer only the tail is uploaded, the streamer loads the levels above it on demand
+		int levelCount = isMipmapFilter(params.minFilter) ? getMipLevelCount(width, height) : 1;
+		TextureStreamer* streamer = getActiveTextureStreamer();
+		int firstLevel = streamer && levelCount > 1 ? getTextureStreamingTailLevel(width, height) : 0;
+
+		// Transcoding inflates the whole chain, it only runs until the transcoded file exists
+		std::string transcodedPath = getTranscodedTextureCachePath(path, target);
+		std::vector<MipLevel> levels;
+		if (!readTranscodedTextureLevels(transcodedPath, width, height, firstLevel, levelCount, levels)) {
+			ktxTexture2* cache = openCompressedTextureCache(path, width, height, target);
+			if (!cache) {
+				return nullptr;
+			}
+			copyCompressedTextureLevels(cache, width, height, firstLevel, levelCount, levels);
+			// The job owns the transcoded texture from here
+			submitJob([cache, transcodedPath]() {
+				writeTranscodedTextureCache(cache, transcodedPath);
+				ktxTexture_Destroy(ktxTexture(cache));
+			});
+		}
+
+		GLuint textureID = createCompressedTextureStorage(target, params, usage, width, height, firstLevel, levelCount);
+		for (int level = firstLevel; level < levelCount; ++level) {
+			const MipLevel& mip = levels[level - firstLevel];
+			uploadCompressedTextureLevel(textureID, target, level - firstLevel, mip.width, mip.height, mip.pixels.data(), mip.pixels.size());
+		}
+
+		Texture* texture = new Texture{ AssetMetadata(), AssetRuntimeData(), textureID, params, width, height, channels, target };
+		if (firstLevel > 0) {
+			registerStreamedTexture(streamer, texture, path, usage, (uint8_t)levelCount, (uint8_t)firstLevel);
+		}
+		return texture;
+	}
+
+	bool readCompressedTextureLevels(const std::string& path, int width, int height, TextureFormat format, int firstLevel, int endLevel, std::vector<MipLevel>& levels) {
+		XE_PROFILE_FUNCTION();
+		std::string transcodedPath = getTranscodedTextureCachePath(path, format);
+		if (readTranscodedTextureLevels(transcodedPath, width, height, firstLevel, endLevel, levels)) {
+			return true;
+		}
+
+		ktxTexture2* cache = openCompressedTextureCache(path, width, height, format);
+		if (!cache) {
+			return false;
+		}
+		copyCompressedTextureLevels(cache, width, height, firstLevel, endLevel, levels);
+		// Already on a job, later reads of this texture skip the transcode
+		writeTranscodedTextureCache(cache, transcodedPath);
+		ktxTexture_Destroy(ktxTexture(cache));
+		return true;
+	}
+
+	uint32_t getTextureVkFormat(int channels, bool srgb) {
+		if (channels == 1) {
+			return srgb ? XE_TEXTURE_VK_FORMAT_R8_SRGB : XE_TEXTURE_VK_FORMAT_R8;
+		}
+		if (channels == 3) {
+			return srgb ? XE_TEXTURE_VK_FORMAT_RGB8_SRGB : XE_TEXTURE_VK_FORMAT_RGB8;
+		}
+		return srgb ? XE_TEXTURE_VK_FORMAT_RGBA8_SRGB : XE_TEXTURE_VK_FORMAT_RGBA8;
+	}
+
+	void encodeCompressedTexture(uint64_t key, const uint8_t* pixels, int width, int height, int channels, TextureFormat format, TextureUsage usage) {
+		std::vector<uint8_t> source(pixels, pixels + (size_t)width * height * channels);
+		submitJob([key, source = std::move(source), width, height, channels, format, usage]() {
+			XE_PROFILE_SCOPE("encodeCompressedTexture");
+			std::string path = getCompressedTextureCachePath(key);
+			// The chain is filtered like uncompressed textures, Basis would average sRGB values and normals as they are
+			std::vector<MipLevel> levels = generateMipChain(source.data(), width, height, channels, getTextureMipmapFilter(format, usage));
+
+			ktxTextureCreateInfo info = {};
+			info.vkFormat = getTextureVkFormat(channels, format == TextureFormat::SRGB || format == TextureFormat::SRGBA);
+			info.baseWidth = (ktx_uint32_t)width;
+			info.baseHeight = (ktx_uint32_t)height;
+			info.baseDepth = 1;
+			info.numDimensions = 2;
+			info.numLevels = (ktx_uint32_t)levels.size() + 1;
+			info.numLayers = 1;
+			info.numFaces = 1;
+			info.isArray = KTX_FALSE;
+			info.generateMipmaps = KTX_FALSE;
+
+			ktxTexture2* texture = nullptr;
+			if (ktxTexture2_Create(&info, KTX_TEXTURE_CREATE_ALLOC_STORAGE, &texture) != KTX_SUCCESS) {
+				XE_LOG_ERROR_F("TEXTURE: Failed to create {}", path);
+				return;
+			}
+			ktxTexture_SetImageFromMemory(ktxTexture(texture), 0, 0, 0, source.data(), source.size());
+			for (size_t i = 0; i < levels.size(); ++i) {
+				ktxTexture_SetImageFromMemory(ktxTexture(texture), (ktx_uint32_t)i + 1, 0, 0, levels[i].pixels.data(), levels[i].pixels.size());
+			}
+
+			BasisCodec codec = selectBasisCodec(usage, channels);
+			ktxBasisParams params = {};
+			params.structSize = sizeof(params);
+			// Every texture is its own job, threads inside the encoder would compete with the other workers
+			params.threadCount = 1;
+			if (codec == BasisCodec::UASTC) {
+				params.uastc = KTX_TRUE;
+				params.uastcFlags = KTX_PACK_UASTC_LEVEL_DEFAULT;
+			}
+			else {
+				params.uastc = KTX_FALSE;
+				params.qualityLevel = XE_TEXTURE_ETC1S_QUALITY;
+				params.compressionLevel = KTX_ETC1S_DEFAULT_COMPRESSION_LEVEL;
+			}
+			if (const char* swizzle = getBasisInputSwizzle(usage, channels)) {
+				std::memcpy(params.inputSwizzle, swizzle, 4);
+			}
+
+			bool encoded = ktxTexture2_CompressBasisEx(texture, &params) == KTX_SUCCESS
+				&& (codec == BasisCodec::ETC1S || ktxTexture2_DeflateZstd(texture, XE_TEXTURE_UASTC_ZSTD_LEVEL) == KTX_SUCCESS);
+			if (!encoded) {
+				XE_LOG_ERROR_F("TEXTURE: Failed to encode {}", path);
+				ktxTexture_Destroy(ktxTexture(texture));
+				return;
+			}
+
+			std::error_code error;
+			std::filesystem::create_directories(XE_TEXTURE_COMPRESSION_CACHE_DIRECTORY, error);
+			if (ktxTexture_WriteToNamedFile(ktxTexture(texture), path.c_str()) != KTX_SUCCESS) {
+				XE_LOG_ERROR_F("TEXTURE: Failed to write {}", path);
+			}
+			ktxTexture_Destroy(ktxTexture(texture));
+		});
+	}
+
+}
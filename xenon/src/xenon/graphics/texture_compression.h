@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "xenon/graphics/texture.h"
+#include "xenon/graphics/mipmap.h"
+
+namespace xe {
+
+	// Directory of the encoded textures, relative to the working directory
+	#define XE_TEXTURE_COMPRESSION_CACHE_DIRECTORY "cache/textures/"
+	// Part of the cache key, increment when the encoder settings change
+	#define XE_TEXTURE_COMPRESSION_CACHE_VERSION 1
+	// ETC1S quality from 1 to 255, higher keeps more endpoints and selectors
+	#define XE_TEXTURE_ETC1S_QUALITY 128
+	// Zstandard level of UASTC files, UASTC alone barely compresses on disk
+	#define XE_TEXTURE_UASTC_ZSTD_LEVEL 18
+
+	//----------------------------------------
+	// SECTION: Texture compression
+	//----------------------------------------
+
+	/*
+		8 bit textures are encoded to Basis Universal KTX2 files with libktx once and transcoded to a block
+		format the GPU samples directly when they are loaded. Encoding is slow, so the first import uploads the
+		uncompressed texture and a job encodes it into the derived data cache, later imports load the cache.
+		Transcoding inflates the whole chain, so the first load also stores the result for the selected GPU format
+		and later loads and streaming read only the levels they need from that file.
+
+		Format selection follows what the channels hold:
+
+		- COLOR: ETC1S, BC7 with alpha and BC1 without (sRGB variants for sRGB textures).
+		- NORMAL: UASTC, X and Y in BC5 (pbr.frag reconstructs Z).
+		- METALLIC_ROUGHNESS: UASTC, roughness and metallic in BC5, swizzled back to green and blue.
+		- OCCLUSION and single channel textures: ETC1S, BC4.
+
+		Formats the driver lacks fall back to RGBA8.
+	*/
+
+	enum class BasisCodec : uint8_t {
+		// Small files, blocky on smooth gradients, fine for color
+		ETC1S	= 0,
+		// Close to BC7 quality, for data the shading depends on
+		UASTC	= 1
+	};
+
+	// Queried from the current context on first use
+	struct TextureCompressionSupport {
+		bool bptc = false;
+		bool rgtc = false;
+		bool s3tc = false;
+		bool s3tcSRGB = false;
+	};
+
+	const TextureCompressionSupport& getTextureCompressionSupport();
+
+	bool isTextureCompressible(TextureFormat format, int channels);
+	BasisCodec selectBasisCodec(TextureUsage usage, int channels);
+	// Format the cached file is transcoded to on this GPU
+	TextureFormat selectCompressedFormat(TextureFormat format, TextureUsage usage, int channels);
+
+	// Storage for levels [firstLevel, levelCount) of the chain, sized like firstLevel
+	GLuint createCompressedTextureStorage(TextureFormat format, const TextureParameters& params, TextureUsage usage, int width, int height, int firstLevel, int levelCount);
+	void uploadCompressedTextureLevel(GLuint textureID, TextureFormat format, int level, int width, int height, const uint8_t* data, size_t size);
+
+
+	//----------------------------------------
+	// SECTION: Compressed texture cache
+	//----------------------------------------
+
+	uint64_t hashCompressedTextureSource(const uint8_t* pixels, int width, int height, int channels, TextureFormat format, TextureUsage usage);
+
+	// Transcoded and uploaded from the cache, nullptr when the texture has not been encoded yet. While a texture
+	// streamer is active only the tail of the chain is uploaded and the texture is registered for streaming.
+	Texture* loadCompressedTexture(uint64_t key, int width, int height, int channels, TextureFormat format, const TextureParameters& params, TextureUsage usage);
+	// Copies the pixels and encodes them with their full mip chain from a job
+	void encodeCompressedTexture(uint64_t key, const uint8_t* pixels, int width, int height, int channels, TextureFormat format, TextureUsage usage);
+	// Transcoded block data of levels [firstLevel, endLevel) of a cached file, safe to call from jobs
+	bool readCompressedTextureLevels(const std::string& path, int width, int height, TextureFormat format, int firstLevel, int endLevel, std::vector<MipLevel>& levels);
+
+}
@@ -0,0 +1,273 @@
+#include "texture_streaming.h"
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+#include "xenon/core/log.h"
+#include "xenon/core/assert.h"
+#include "xenon/core/job_system.h"
+#include "xenon/core/profiler.h"
+#include "xenon/graphics/gl_state.h"
+#include "xenon/graphics/mipmap.h"
+#include "xenon/graphics/texture_compression.h"
+
+namespace xe {
+
+	static TextureStreamer* s_activeStreamer = nullptr;
+
+	struct TextureStreamLoad {
+		const Texture* texture;
+		uint64_t id;
+		uint8_t firstLevel;
+		uint64_t bytes;
+		bool failed = false;
+		// Levels [firstLevel, residentLevel) of the chain
+		std::vector<MipLevel> levels;
+	};
+
+	struct TextureStreamQueue {
+		std::mutex mutex;
+		std::vector<TextureStreamLoad> finished;
+	};
+
+	//----------------------------------------
+	// SECTION: Texture streaming
+	//----------------------------------------
+
+	TextureStreamer* createTextureStreamer(uint64_t budget) {
+		TextureStreamer* streamer = new TextureStreamer();
+		streamer->budget = budget;
+		streamer->queue = std::make_shared<TextureStreamQueue>();
+		return streamer;
+	}
+
+	void destroyTextureStreamer(TextureStreamer* streamer) {
+		// Running loads finish into the queue, which lives on until the last job releases it
+		if (s_activeStreamer == streamer) {
+			s_activeStreamer = nullptr;
+		}
+		delete streamer;
+	}
+
+	void setActiveTextureStreamer(TextureStreamer* streamer) {
+		s_activeStreamer = streamer;
+	}
+
+	TextureStreamer* getActiveTextureStreamer() {
+		return s_activeStreamer;
+	}
+
+
+	//----------------------------------------
+	// SECTION: Texture streaming functions
+	//----------------------------------------
+
+	int getTextureStreamingTailLevel(int width, int height) {
+		int level = 0;
+		while (std::max(width >> level, 1) > XE_TEXTURE_STREAMING_TAIL_SIZE || std::max(height >> level, 1) > XE_TEXTURE_STREAMING_TAIL_SIZE) {
+			++level;
+		}
+		return level;
+	}
+
+	// Video memory of levels [firstLevel, endLevel)
+	uint64_t getStreamedLevelsSize(const Texture& texture, int firstLevel, int endLevel) {
+		uint64_t size = 0;
+		for (int level = firstLevel; level < endLevel; ++level) {
+			size += getTextureLevelSize(texture.format, std::max(texture.width >> level, 1), std::max(texture.height >> level, 1));
+		}
+		return size;
+	}
+
+	void registerStreamedTexture(TextureStreamer* streamer, Texture* texture, const std::string& path, TextureUsage usage, uint8_t levelCount, uint8_t residentLevel) {
+		StreamedTexture streamed = StreamedTexture{ streamer->nextID++, texture, path, usage, levelCount, residentLevel, residentLevel, residentLevel, residentLevel };
+		streamer->residentBytes += getStreamedLevelsSize(*texture, residentLevel, levelCount);
+		streamer->textures.insert_or_assign(texture, std::move(streamed));
+	}
+
+	void unregisterStreamedTexture(TextureStreamer* streamer, const Texture* texture) {
+		auto it = streamer->textures.find(texture);
+		if (it == streamer->textures.end()) {
+			return;
+		}
+		// A running load is dropped when it finishes, its id no longer matches
+		streamer->residentBytes -= getStreamedLevelsSize(*texture, it->second.residentLevel, it->second.levelCount);
+		streamer->textures.erase(it);
+	}
+
+	void setTextureStreamingViewport(TextureStreamer* streamer, int height) {
+		streamer->viewportHeight = (float)std::max(height, 1);
+	}
+
+	float computeTextureLODOffset(const Primitive& primitive, const glm::mat4& transform, const Camera& camera, float viewportHeight) {
+		// Unknown density, the full resolution is the safe choice
+		if (primitive.uvDensity <= 0.0f) {
+			return -128.0f;
+		}
+
+		// Bounding sphere in world space, the nearest point decides
+		glm::vec3 center = transform * glm::vec4((primitive.bounds.min + primitive.bounds.max) * 0.5f, 1.0f);
+		float scale = glm::max(glm::length(glm::vec3(transform[0])), glm::max(glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2]))));
+		float radius = glm::length(primitive.bounds.max - primitive.bounds.min) * 0.5f * scale;
+		float distance = glm::max(glm::distance(center, glm::vec3(camera.transform[3])) - radius, glm::max(camera.near, 0.001f));
+
+		// Pixels covered by one vertex space unit, each unit spans uvDensity of TEXCOORD_0
+		float pixelsPerUnit = scale * camera.projection[1][1] * 0.5f * viewportHeight / distance;
+		return glm::log2(primitive.uvDensity / pixelsPerUnit);
+	}
+
+	void requestTextureLevel(TextureStreamer* streamer, const Texture* texture, float lodOffset) {
+		if (!texture) {
+			return;
+		}
+		auto it = streamer->textures.find(texture);
+		if (it == streamer->textures.end()) {
+			return;
+		}
+
+		StreamedTexture& streamed = it->second;
+		float lod = glm::log2((float)glm::max(texture->width, texture->height)) + lodOffset;
+		uint8_t level = lod <= 0.0f ? 0 : (uint8_t)glm::min((int)lod, (int)streamed.tailLevel);
+		if (!streamed.requested || level < streamed.requestedLevel) {
+			streamed.requestedLevel = level;
+			streamed.requested = true;
+		}
+	}
+
+	void requestMaterialTextureLevels(TextureStreamer* streamer, const Material& material, float lodOffset) {
+		requestTextureLevel(streamer, material.pbrMetallicRoughness.baseColorTexture, lodOffset);
+		requestTextureLevel(streamer, material.pbrMetallicRoughness.metallicRoughnessTexture, lodOffset);
+		requestTextureLevel(streamer, material.normalTexture, lodOffset);
+		requestTextureLevel(streamer, material.occlusionTexture, lodOffset);
+		requestTextureLevel(streamer, material.emissiveTexture, lodOffset);
+	}
+
+	// Replaces the texture object by one holding levels [residentLevel, levelCount), levels holds the new detail
+	// levels when residentLevel is more detailed than before
+	void reallocateStreamedTexture(TextureStreamer* streamer, StreamedTexture& streamed, uint8_t residentLevel, const std::vector<MipLevel>* levels) {
+		Texture* texture = streamed.texture;
+		GLuint textureID = createCompressedTextureStorage(texture->format, texture->params, streamed.usage, texture->width, texture->height, residentLevel, streamed.levelCount);
+
+		for (int level = std::max(residentLevel, streamed.residentLevel); level < streamed.levelCount; ++level) {
+			glCopyImageSubData(texture->textureID, GL_TEXTURE_2D, level - streamed.residentLevel, 0, 0, 0,
+				textureID, GL_TEXTURE_2D, level - residentLevel, 0, 0, 0,
+				std::max(texture->width >> level, 1), std::max(texture->height >> level, 1), 1);
+		}
+		if (levels) {
+			XE_ASSERT(levels->size() == (size_t)(streamed.residentLevel - residentLevel));
+			for (size_t i = 0; i < levels->size(); ++i) {
+				const MipLevel& level = (*levels)[i];
+				uploadCompressedTextureLevel(textureID, texture->format, (int)i, level.width, level.height, level.pixels.data(), level.pixels.size());
+			}
+		}
+
+		streamer->residentBytes -= getStreamedLevelsSize(*texture, streamed.residentLevel, streamed.levelCount);
+		streamer->residentBytes += getStreamedLevelsSize(*texture, residentLevel, streamed.levelCount);
+
+		forgetGLTexture(texture->textureID);
+		glDeleteTextures(1, &texture->textureID);
+		texture->textureID = textureID;
+		streamed.residentLevel = residentLevel;
+	}
+
+	void startTextureStreamLoad(TextureStreamer* streamer, StreamedTexture& streamed, uint8_t firstLevel, uint64_t bytes) {
+		streamed.loading = true;
+		++streamer->loadsInFlight;
+		streamer->pendingBytes += bytes;
+
+		const Texture* texture = streamed.texture;
+		submitJob([queue = streamer->queue, texture, id = streamed.id, path = streamed.path, width = texture->width, height = texture->height,
+			format = texture->format, firstLevel, endLevel = streamed.residentLevel, bytes]() {
+			XE_PROFILE_SCOPE("loadStreamedTextureLevels");
+			TextureStreamLoad load = TextureStreamLoad{ texture, id, firstLevel, bytes };
+			load.failed = !readCompressedTextureLevels(path, width, height, format, firstLevel, endLevel, load.levels);
+
+			std::lock_guard<std::mutex> lock(queue->mutex);
+			queue->finished.push_back(std::move(load));
+		});
+	}
+
+	void updateTextureStreamer(TextureStreamer* streamer) {
+		XE_PROFILE_FUNCTION();
+		++streamer->frame;
+
+		// Finished loads
+		std::vector<TextureStreamLoad> finished;
+		{
+			std::lock_guard<std::mutex> lock(streamer->queue->mutex);
+			finished.swap(streamer->queue->finished);
+		}
+		for (const TextureStreamLoad& load : finished) {
+			--streamer->loadsInFlight;
+			streamer->pendingBytes -= load.bytes;
+
+			auto it = streamer->textures.find(load.texture);
+			if (it == streamer->textures.end() || it->second.id != load.id) {
+				continue;
+			}
+			StreamedTexture& streamed = it->second;
+			streamed.loading = false;
+			if (load.failed) {
+				XE_LOG_WARN_F("TEXTURE_STREAMING: Failed to read {}, the texture stays at level {}", streamed.path, streamed.residentLevel);
+				streamed.failed = true;
+				continue;
+			}
+			streamer->streamedLevels += streamed.residentLevel - load.firstLevel;
+			reallocateStreamedTexture(streamer, streamed, load.firstLevel, &load.levels);
+		}
+
+		// Demand of the last frame, kept for a while when the texture was not drawn
+		std::vector<StreamedTexture*> candidates;
+		candidates.reserve(streamer->textures.size());
+		for (auto& [texture, streamed] : streamer->textures) {
+			if (streamed.requested) {
+				streamed.neededLevel = streamed.requestedLevel;
+				streamed.lastRequestFrame = streamer->frame;
+			}
+			else if (streamer->frame - streamed.lastRequestFrame > XE_TEXTURE_STREAMING_RETAIN_FRAMES) {
+				streamed.neededLevel = streamed.tailLevel;
+			}
+			streamed.requested = false;
+			streamed.requestedLevel = streamed.tailLevel;
+			candidates.push_back(&streamed);
+		}
+
+		// Eviction, textures holding the most levels they do not need first
+		if (streamer->residentBytes > streamer->budget) {
+			std::sort(candidates.begin(), candidates.end(), [](const StreamedTexture* a, const StreamedTexture* b) {
+				return a->neededLevel - a->residentLevel > b->neededLevel - b->residentLevel;
+			});
+			for (StreamedTexture* streamed : candidates) {
+				if (streamer->residentBytes <= streamer->budget || streamed->residentLevel >= streamed->neededLevel) {
+					break;
+				}
+				if (!streamed->loading) {
+					streamer->evictedLevels += streamed->neededLevel - streamed->residentLevel;
+					reallocateStreamedTexture(streamer, *streamed, streamed->neededLevel, nullptr);
+				}
+			}
+		}
+
+		// Loads, textures missing the most levels first, as detailed as the budget allows
+		std::sort(candidates.begin(), candidates.end(), [](const StreamedTexture* a, const StreamedTexture* b) {
+			return a->residentLevel - a->neededLevel > b->residentLevel - b->neededLevel;
+		});
+		for (StreamedTexture* streamed : candidates) {
+			if (streamer->loadsInFlight >= XE_TEXTURE_STREAMING_MAX_LOADS || streamed->neededLevel >= streamed->residentLevel) {
+				break;
+			}
+			if (streamed->loading || streamed->failed) {
+				continue;
+			}
+			for (uint8_t level = streamed->neededLevel; level < streamed->residentLevel; ++level) {
+				uint64_t bytes = getStreamedLevelsSize(*streamed->texture, level, streamed->residentLevel);
+				if (streamer->residentBytes + streamer->pendingBytes + bytes <= streamer->budget) {
+					startTextureStreamLoad(streamer, *streamed, level, bytes);
+					break;
+				}
+			}
+		}
+	}
+
+}
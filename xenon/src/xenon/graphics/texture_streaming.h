@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+
+#include "xenon/graphics/texture.h"
+#include "xenon/graphics/material.h"
+#include "xenon/graphics/primitive.h"
+#include "xenon/graphics/camera.h"
+
+namespace xe {
+
+	// Video memory of streamed textures, their resident tails included
+	#define XE_TEXTURE_STREAMING_DEFAULT_BUDGET (256ull * 1024 * 1024)
+	// Levels up to this size stay resident from load on and are never evicted
+	#define XE_TEXTURE_STREAMING_TAIL_SIZE 64
+	// Loads running on the job system at once
+	#define XE_TEXTURE_STREAMING_MAX_LOADS 4
+	// Frames a texture keeps its demand after it was last drawn, avoids reloading when it is briefly culled
+	#define XE_TEXTURE_STREAMING_RETAIN_FRAMES 120
+
+	//----------------------------------------
+	// SECTION: Texture streaming
+	//----------------------------------------
+
+	/*
+		Textures loaded from the compressed cache (texture_compression.h) while a streamer is active only upload the
+		tail of their mip chain. While rendering, renderModel requests the most detailed level each material texture
+		can show, estimated from the projected size of the primitive and the UV density of its TEXCOORD_0
+		(Primitive::uvDensity). Once per frame updateTextureStreamer:
+
+		1. Applies finished loads: a texture object holding the new levels is created, the levels that were already
+		   resident are copied on the GPU (glCopyImageSubData) and the new ones are uploaded. Texture::textureID is
+		   replaced, materials bind the new object from then on.
+		2. Evicts when over budget: textures holding levels more detailed than they need are cut back to the needed
+		   level, the ones with the largest surplus first.
+		3. Starts loads within the budget: the textures missing the most levels first, a job transcodes the
+		   missing levels from the cached file.
+
+		Storage is reallocated per change instead of using sparse textures, ARB_sparse_texture is missing on many
+		drivers and the copies are cheap next to the uploads.
+	*/
+
+	struct StreamedTexture {
+		// Distinguishes textures that reuse the address of a destroyed one while its load runs
+		uint64_t id;
+		Texture* texture;
+		// Transcodable KTX2 file in the derived data cache
+		std::string path;
+		TextureUsage usage;
+
+		uint8_t levelCount;
+		// First level of the tail, always resident
+		uint8_t tailLevel;
+		// Most detailed resident level
+		uint8_t residentLevel;
+		// Most detailed level the texture is shown at recently
+		uint8_t neededLevel;
+		// Most detailed level requested since the last update
+		uint8_t requestedLevel;
+		bool requested = false;
+		bool loading = false;
+		// The cache could not be read, the texture stays at its current levels
+		bool failed = false;
+		uint64_t lastRequestFrame = 0;
+	};
+
+	// Finished loads, shared with the jobs so the streamer can be destroyed while they run
+	struct TextureStreamQueue;
+
+	struct TextureStreamer {
+		uint64_t budget = XE_TEXTURE_STREAMING_DEFAULT_BUDGET;
+		uint64_t residentBytes = 0;
+		// Bytes of the loads in flight, reserved against the budget
+		uint64_t pendingBytes = 0;
+		uint32_t loadsInFlight = 0;
+		// Height in pixels of the viewport the scene is rendered to
+		float viewportHeight = 1080.0f;
+
+		uint64_t frame = 0;
+		uint64_t nextID = 1;
+		std::unordered_map<const Texture*, StreamedTexture> textures;
+		std::shared_ptr<TextureStreamQueue> queue;
+
+		// Totals since creation, for the stats panel
+		uint64_t streamedLevels = 0;
+		uint64_t evictedLevels = 0;
+	};
+
+	TextureStreamer* createTextureStreamer(uint64_t budget = XE_TEXTURE_STREAMING_DEFAULT_BUDGET);
+	void destroyTextureStreamer(TextureStreamer* streamer);
+
+	// Textures loaded while a streamer is active are streamed by it, the renderer activates its streamer
+	void setActiveTextureStreamer(TextureStreamer* streamer);
+	TextureStreamer* getActiveTextureStreamer();
+
+
+	//----------------------------------------
+	// SECTION: Texture streaming functions
+	//----------------------------------------
+
+	// First level of a chain that is at most XE_TEXTURE_STREAMING_TAIL_SIZE in both dimensions
+	int getTextureStreamingTailLevel(int width, int height);
+
+	// The texture object holds levels [residentLevel, levelCount) of the chain
+	void registerStreamedTexture(TextureStreamer* streamer, Texture* texture, const std::string& path, TextureUsage usage, uint8_t levelCount, uint8_t residentLevel);
+	void unregisterStreamedTexture(TextureStreamer* streamer, const Texture* texture);
+
+	void setTextureStreamingViewport(TextureStreamer* streamer, int height);
+
+	// log2 of the TEXCOORD_0 units per pixel of the primitive, adding log2 of a texture size gives its mip level.
+	// transform takes the primitive vertices to world space, node matrix included.
+	float computeTextureLODOffset(const Primitive& primitive, const glm::mat4& transform, const Camera& camera, float viewportHeight);
+	void requestTextureLevel(TextureStreamer* streamer, const Texture* texture, float lodOffset);
+	void requestMaterialTextureLevels(TextureStreamer* streamer, const Material& material, float lodOffset);
+
+	// Applies finished loads, evicts and starts loads, once per frame before rendering
+	void updateTextureStreamer(TextureStreamer* streamer);
+
+}
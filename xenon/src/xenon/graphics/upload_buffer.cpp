@@ -0,0 +1,133 @@
+#include "upload_buffer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "xenon/core/assert.h"
+#include "xenon/core/log.h"
+#include "xenon/graphics/render_stats.h"
+
+namespace xe {
+
+	//----------------------------------------
+	// SECTION: Upload ring buffer
+	//----------------------------------------
+
+	UploadRingBuffer* createUploadRingBuffer(size_t regionSize) {
+		UploadRingBuffer* buffer = new UploadRingBuffer();
+
+		GLint uniformAlignment = 1, storageAlignment = 1;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+		glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+		buffer->minAlignment = (size_t)std::max(uniformAlignment, storageAlignment);
+
+		// Keep every region start aligned
+		buffer->regionSize = (regionSize + buffer->minAlignment - 1) / buffer->minAlignment * buffer->minAlignment;
+
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glCreateBuffers(1, &buffer->bufferID);
+		glNamedBufferStorage(buffer->bufferID, buffer->regionSize * XE_UPLOAD_BUFFER_FRAMES, nullptr, flags);
+		buffer->mappedMemory = static_cast<uint8_t*>(glMapNamedBufferRange(buffer->bufferID, 0, buffer->regionSize * XE_UPLOAD_BUFFER_FRAMES, flags));
+
+		if (!buffer->mappedMemory) {
+			XE_LOG_ERROR("UPLOAD_BUFFER: Failed to persistently map upload buffer");
+			glDeleteBuffers(1, &buffer->bufferID);
+			delete buffer;
+			return nullptr;
+		}
+
+		return buffer;
+	}
+
+	void destroyUploadRingBuffer(UploadRingBuffer* buffer) {
+		for (GLsync& fence : buffer->fences) {
+			if (fence) {
+				glDeleteSync(fence);
+				fence = nullptr;
+			}
+		}
+		glUnmapNamedBuffer(buffer->bufferID);
+		glDeleteBuffers(1, &buffer->bufferID);
+		delete buffer;
+	}
+
+
+	//----------------------------------------
+	// SECTION: Upload ring buffer functions
+	//----------------------------------------
+
+	void beginUploadFrame(UploadRingBuffer* buffer) {
+		buffer->frameCounters = UploadBufferCounters();
+
+		buffer->currentRegion = (buffer->currentRegion + 1) % XE_UPLOAD_BUFFER_FRAMES;
+		buffer->regionOffset = 0;
+
+		GLsync& fence = buffer->fences[buffer->currentRegion];
+		if (!fence) {
+			return;
+		}
+
+		// Poll first, only a region still in flight counts as a stall
+		GLenum result = glClientWaitSync(fence, 0, 0);
+		if (result == GL_TIMEOUT_EXPIRED) {
+			auto start = std::chrono::high_resolution_clock::now();
+			while (result == GL_TIMEOUT_EXPIRED) {
+				result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1 ms
+			}
+			double waited = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+			++buffer->frameCounters.stalls;
+			++buffer->totalCounters.stalls;
+			buffer->frameCounters.stallTime += waited;
+			buffer->totalCounters.stallTime += waited;
+		}
+		if (result == GL_WAIT_FAILED) {
+			XE_LOG_ERROR("UPLOAD_BUFFER: Failed to wait for upload region fence");
+		}
+
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+
+	void endUploadFrame(UploadRingBuffer* buffer) {
+		GLsync& fence = buffer->fences[buffer->currentRegion];
+		XE_ASSERT(fence == nullptr);
+		fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	UploadAllocation allocateUpload(UploadRingBuffer* buffer, size_t size, size_t alignment) {
+		if (alignment < buffer->minAlignment) {
+			alignment = buffer->minAlignment;
+		}
+
+		size_t offset = (buffer->regionOffset + alignment - 1) / alignment * alignment;
+		if (offset + size > buffer->regionSize) {
+			if (buffer->frameCounters.overflows == 0) {
+				XE_LOG_ERROR_F("UPLOAD_BUFFER: Upload region exhausted ({} bytes)", buffer->regionSize);
+			}
+			++buffer->frameCounters.overflows;
+			++buffer->totalCounters.overflows;
+			return UploadAllocation();
+		}
+		buffer->regionOffset = offset + size;
+
+		++buffer->frameCounters.allocations;
+		++buffer->totalCounters.allocations;
+		buffer->frameCounters.bytesAllocated += size;
+		buffer->totalCounters.bytesAllocated += size;
+		recordBufferUpload(size);
+
+		size_t bufferOffset = buffer->currentRegion * buffer->regionSize + offset;
+		return UploadAllocation{ buffer->bufferID, (GLintptr)bufferOffset, (GLsizeiptr)size, buffer->mappedMemory + bufferOffset };
+	}
+
+	UploadAllocation writeUpload(UploadRingBuffer* buffer, const void* data, size_t size, size_t alignment) {
+		UploadAllocation allocation = allocateUpload(buffer, size, alignment);
+		if (allocation.data) {
+			std::memcpy(allocation.data, data, size);
+		}
+		return allocation;
+	}
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <glad/gl.h>
+
+namespace xe {
+
+	// Number of frame regions in the ring, the CPU can be this many frames ahead of the GPU before stalling
+	#define XE_UPLOAD_BUFFER_FRAMES 3
+
+	//----------------------------------------
+	// SECTION: Upload ring buffer
+	//----------------------------------------
+
+	struct UploadBufferCounters {
+		uint32_t allocations = 0;
+		size_t bytesAllocated = 0;
+		uint32_t overflows = 0;		// Allocations that did not fit in the frame region
+
+		// Stall detection, a stall means the GPU was still reading the region we were about to write
+		uint32_t stalls = 0;
+		double stallTime = 0.0;		// Total time spent waiting on fences (ms)
+	};
+
+	struct UploadRingBuffer {
+		GLuint bufferID = 0;
+		uint8_t* mappedMemory = nullptr;
+
+		size_t regionSize = 0;
+		uint32_t currentRegion = 0;
+		size_t regionOffset = 0;
+		std::array<GLsync, XE_UPLOAD_BUFFER_FRAMES> fences = {};
+
+		// Largest alignment required by the buffer targets we upload to (UBO/SSBO offsets)
+		size_t minAlignment = 1;
+
+		UploadBufferCounters frameCounters;		// Reset every beginUploadFrame
+		UploadBufferCounters totalCounters;
+	};
+
+	struct UploadAllocation {
+		GLuint buffer = 0;
+		GLintptr offset = 0;	// Offset in buffer, usable with glBindBufferRange or as indirect command offset
+		GLsizeiptr size = 0;
+		void* data = nullptr;	// Mapped write pointer, nullptr if the allocation failed
+	};
+
+	// regionSize is the size available to each frame, the buffer is XE_UPLOAD_BUFFER_FRAMES times larger
+	UploadRingBuffer* createUploadRingBuffer(size_t regionSize);
+	void destroyUploadRingBuffer(UploadRingBuffer* buffer);
+
+
+	//----------------------------------------
+	// SECTION: Upload ring buffer functions
+	//----------------------------------------
+
+	// Moves to the next frame region, waits for the GPU if it is still using it
+	void beginUploadFrame(UploadRingBuffer* buffer);
+	// Guards the current frame region with a fence, call after the last command reading this frame's data
+	void endUploadFrame(UploadRingBuffer* buffer);
+
+	UploadAllocation allocateUpload(UploadRingBuffer* buffer, size_t size, size_t alignment = 0);
+	UploadAllocation writeUpload(UploadRingBuffer* buffer, const void* data, size_t size, size_t alignment = 0);
+
+}
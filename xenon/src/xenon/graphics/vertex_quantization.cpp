@@ -0,0 +1,69 @@
+#include "vertex_quantization.h"
+
+#include <cmath>
+
+#include <glm/gtc/packing.hpp>
+
+namespace xe {
+
+	//----------------------------------------
+	// SECTION: Vertex quantization
+	//----------------------------------------
+
+	glm::vec2 encodeOctahedral(glm::vec3 vector) {
+		float length = glm::abs(vector.x) + glm::abs(vector.y) + glm::abs(vector.z);
+		if (length == 0.0f) {
+			return glm::vec2(0.0f);
+		}
+		vector /= length;
+
+		glm::vec2 result = glm::vec2(vector.x, vector.y);
+		if (vector.z < 0.0f) {
+			// Fold the lower hemisphere over the diagonals
+			glm::vec2 signs = glm::vec2(result.x >= 0.0f ? 1.0f : -1.0f, result.y >= 0.0f ? 1.0f : -1.0f);
+			result = (1.0f - glm::abs(glm::vec2(result.y, result.x))) * signs;
+		}
+		return result;
+	}
+
+	void quantizePositions(const float* positions, size_t count, const glm::vec3& offset, const glm::vec3& scale, uint16_t* output) {
+		glm::vec3 inverseScale = glm::vec3(
+			scale.x > 0.0f ? 1.0f / scale.x : 0.0f,
+			scale.y > 0.0f ? 1.0f / scale.y : 0.0f,
+			scale.z > 0.0f ? 1.0f / scale.z : 0.0f);
+
+		for (size_t v = 0; v < count; ++v) {
+			glm::vec3 position = glm::vec3(positions[v * 3 + 0], positions[v * 3 + 1], positions[v * 3 + 2]);
+			glm::vec3 normalized = glm::clamp((position - offset) * inverseScale, 0.0f, 1.0f);
+			output[v * 4 + 0] = (uint16_t)std::lround(normalized.x * 65535.0f);
+			output[v * 4 + 1] = (uint16_t)std::lround(normalized.y * 65535.0f);
+			output[v * 4 + 2] = (uint16_t)std::lround(normalized.z * 65535.0f);
+			output[v * 4 + 3] = 0;
+		}
+	}
+
+	void encodeOctahedralNormals(const float* normals, size_t count, int16_t* output) {
+		for (size_t v = 0; v < count; ++v) {
+			glm::vec2 octahedral = encodeOctahedral(glm::vec3(normals[v * 3 + 0], normals[v * 3 + 1], normals[v * 3 + 2]));
+			output[v * 2 + 0] = (int16_t)glm::packSnorm1x16(octahedral.x);
+			output[v * 2 + 1] = (int16_t)glm::packSnorm1x16(octahedral.y);
+		}
+	}
+
+	void encodeOctahedralTangents(const float* tangents, size_t count, int16_t* output) {
+		for (size_t v = 0; v < count; ++v) {
+			glm::vec2 octahedral = encodeOctahedral(glm::vec3(tangents[v * 4 + 0], tangents[v * 4 + 1], tangents[v * 4 + 2]));
+			long y = std::lround(glm::clamp(octahedral.y, -1.0f, 1.0f) * 16383.0f);
+			output[v * 2 + 0] = (int16_t)glm::packSnorm1x16(octahedral.x);
+			output[v * 2 + 1] = (int16_t)(y * 2 + (tangents[v * 4 + 3] < 0.0f ? 1 : 0));
+		}
+	}
+
+	void encodeHalfTexCoords(const float* texCoords, size_t count, uint16_t* output) {
+		for (size_t v = 0; v < count; ++v) {
+			output[v * 2 + 0] = glm::packHalf1x16(texCoords[v * 2 + 0]);
+			output[v * 2 + 1] = glm::packHalf1x16(texCoords[v * 2 + 1]);
+		}
+	}
+
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+namespace xe {
+
+	//----------------------------------------
+	// SECTION: Vertex quantization
+	//----------------------------------------
+
+	/*
+		Encoders for VertexFormat::QUANTIZED, all inputs are tightly packed float arrays.
+		The matching decoders live in pbr.vert (XE_QUANTIZED_VERTICES).
+	*/
+
+	// Maps a unit vector onto the octahedron unfolded to [-1, 1]^2
+	glm::vec2 encodeOctahedral(glm::vec3 vector);
+
+	// 4x unorm16 per vertex (w is padding), dequantize with offset + scale * unorm
+	void quantizePositions(const float* positions, size_t count, const glm::vec3& offset, const glm::vec3& scale, uint16_t* output);
+	// vec3 input, 2x snorm16 per vertex
+	void encodeOctahedralNormals(const float* normals, size_t count, int16_t* output);
+	// vec4 input (w = handedness), 2x int16 per vertex, y keeps 15 bits and stores the handedness in its lowest bit
+	void encodeOctahedralTangents(const float* tangents, size_t count, int16_t* output);
+	// vec2 input, 2x half float per vertex
+	void encodeHalfTexCoords(const float* texCoords, size_t count, uint16_t* output);
+
+}
@@ -1,10 +1,17 @@
 #include "scene.h"
 
+#include <chrono>
+
 #include <glm/gtx/matrix_decompose.hpp>
 #include <glm/gtx/quaternion.hpp>
 
 #include "xenon/core/assert.h"
+#include "xenon/core/frame_allocator.h"
+#include "xenon/core/profiler.h"
 #include "xenon/graphics/environment.h"
+#include "xenon/graphics/gl_state.h"
+#include "xenon/graphics/render_stats.h"
+#include "xenon/graphics/gpu_profiler.h"
 
 #include "xenon/scripting/script.h"
 
@@ -91,33 +98,133 @@ namespace xe {
 		return glm::inverse(getWorldMatrix(getEntityFromID(entity.scene, transformComponent.parent))) * matrix;
 	}
 
+	float millisecondsSince(std::chrono::high_resolution_clock::time_point& start) {
+		auto now = std::chrono::high_resolution_clock::now();
+		float elapsed = std::chrono::duration<float, std::milli>(now - start).count();
+		start = now;
+		return elapsed;
+	}
+
 	void renderScene(Scene* scene, const Renderer& renderer, const Camera& camera, const Environment& environment) {
+		XE_PROFILE_FUNCTION();
+		SceneRenderTimings& timings = scene->renderTimings;
+		auto phaseStart = std::chrono::high_resolution_clock::now();
+
+		// World matrices of all models
+		struct SceneModel {
+			UUID id;
+			ModelComponent* component;
+			glm::mat4 worldMatrix;
+		};
+		FrameVector<SceneModel> sceneModels;
+
+		auto modelView = scene->registry.view<ModelComponent, IdentityComponent>();
+		for (auto [entity, modelComponent, identityComponent] : modelView.each()) {
+			if (modelComponent.model) {
+				sceneModels.push_back({ identityComponent.uuid, &modelComponent, getWorldMatrix({ entity, scene }) });
+			}
+		}
+		timings.transformTime = millisecondsSince(phaseStart);
+
+		// Collect visible models
+		struct VisibleModel {
+			UUID id;
+			const ModelComponent* component;
+			glm::mat4 worldMatrix;
+		};
+		FrameVector<VisibleModel> visibleModels;
+
+		beginOcclusionFrame(renderer.occlusionCuller, scene->renderSettings.occlusionCulling);
+		for (SceneModel& sceneModel : sceneModels) {
+			ModelComponent& modelComponent = *sceneModel.component;
+			if (!testOcclusion(renderer.occlusionCuller, sceneModel.id, modelComponent.model->bounds, sceneModel.worldMatrix)) {
+				continue;
+			}
+			modelComponent.currentLOD = selectModelLOD(*modelComponent.model, sceneModel.worldMatrix, camera, modelComponent.lodBias, modelComponent.currentLOD);
+			visibleModels.push_back({ sceneModel.id, &modelComponent, sceneModel.worldMatrix });
+		}
+		recordVisibility((uint32_t)visibleModels.size(), (uint32_t)(sceneModels.size() - visibleModels.size()));
+		timings.cullingTime = millisecondsSince(phaseStart);
+
+		// Node matrices of animated models, only needed for the visible ones
+		for (const VisibleModel& visible : visibleModels) {
+			if (!visible.component->model->isStatic) {
+				updateModelMatrices(visible.component->model);
+			}
+		}
+		timings.transformTime += millisecondsSince(phaseStart);
+
 		// Load lights
 		auto lightView = scene->registry.view<PointLightComponent, IdentityComponent, TransformComponent>();
+		LightingBlock lighting = {};
 		int index = 0;
-		bindShader(*renderer.shader);
 		for (const auto [entity, pointLight, identity, transform] : lightView.each()) {
-			loadLight(*renderer.shader, getWorldMatrix(getEntityFromID(scene, identity.uuid))[3], pointLight, index++);
+			if (index == XE_MAX_POINT_LIGHTS) {
+				break;
+			}
+			lighting.pointLights[index].position = getWorldMatrix(getEntityFromID(scene, identity.uuid))[3];
+			lighting.pointLights[index].color = glm::vec4(pointLight.color, 1.0f);
+			++index;
 		}
-		loadInt(*renderer.shader, "pointLightsUsed", index);
-		
-		// Load environment and BRDF
-		glBindTextureUnit(5, environment.irradianceMap->textureID);
-		glBindTextureUnit(6, environment.radianceMap->textureID);
-		glBindTextureUnit(7, renderer.brdfLUT->textureID);
+		lighting.pointLightsUsed = index;
+		for (int i = 0; i < XE_SH_COEFFICIENTS; ++i) {
+			lighting.irradianceSH[i] = glm::vec4(environment.irradianceSH.coefficients[i], 0.0f);
+		}
+		loadLighting(renderer, lighting);
 
-		unbindShader();
+		bindShader(*renderer.shader);
+		
+		// Load environment and BRDF, irradiance is in the lighting block
+		bindGLTextureUnit(6, environment.radianceMap->textureID);
+		bindGLTextureUnit(7, renderer.brdfLUT->textureID);
+
+		// Depth prepass, the main pass then only shades the visible surface of each pixel
+		bool depthPrepass = scene->renderSettings.depthPrepass;
+		if (depthPrepass) {
+			XE_GPU_SCOPE("Depth prepass");
+			setGLColorMask(false);
+			setGLDepthMask(true);
+			setGLDepthFunc(GL_LEQUAL);
+			for (const VisibleModel& visible : visibleModels) {
+				setGLPolygonMode(GL_FRONT, visible.component->wireframe ? GL_LINE : GL_FILL);
+				renderModelDepth(renderer, *visible.component->model, visible.worldMatrix, camera, visible.component->currentLOD);
+			}
+			setGLColorMask(true);
+			setGLDepthMask(false);
+		}
 
 		// Render models
+		{
+			XE_GPU_SCOPE("Opaque");
+			for (const VisibleModel& visible : visibleModels) {
+				setGLPolygonMode(GL_FRONT, visible.component->wireframe ? GL_LINE : GL_FILL);
+				setObjectID(renderer, visible.id);
+				renderModel(renderer, *visible.component->model, visible.worldMatrix, camera, false, visible.component->currentLOD, depthPrepass);
+			}
+			setGLPolygonMode(GL_FRONT, GL_FILL);
+		}
+
+		if (depthPrepass) {
+			setGLDepthMask(true);
+			setGLDepthFunc(GL_LEQUAL);
+		}
+		timings.submissionTime = millisecondsSince(phaseStart);
+	}
+
+	void renderSceneObjectIDs(Scene* scene, const Renderer& renderer, const Camera& camera) {
+		setGLDepthMask(true);
+		setGLDepthFunc(GL_LEQUAL);
+
+		// NOTE: Uses the detail levels selected by renderScene
 		auto modelView = scene->registry.view<ModelComponent, IdentityComponent>();
 		for (auto [entity, modelComponent, identityComponent] : modelView.each()) {
 			if (modelComponent.model) {
-				if(modelComponent.wireframe) glPolygonMode(GL_FRONT, GL_LINE);
+				setGLPolygonMode(GL_FRONT, modelComponent.wireframe ? GL_LINE : GL_FILL);
 				setObjectID(renderer, identityComponent.uuid);
-				renderModel(renderer, *modelComponent.model, getWorldMatrix({ entity, scene }), camera);
-				if (modelComponent.wireframe) glPolygonMode(GL_FRONT, GL_FILL);
+				renderModelDepth(renderer, *modelComponent.model, getWorldMatrix({ entity, scene }), camera, modelComponent.currentLOD, XE_SHADER_PERMUTATION_OBJECT_ID);
 			}
 		}
+		setGLPolygonMode(GL_FRONT, GL_FILL);
 	}
 
 	void copyComponentIdentity(Scene* source, Scene* target) {
@@ -138,6 +245,8 @@ namespace xe {
 	}
 
 	void copyScene(Scene* source, Scene* target) {
+		target->renderSettings = source->renderSettings;
+
 		// Copy entity map
 		auto identityComponents = source->registry.view<IdentityComponent>();
 		for (auto& [entity, identityComponent] : identityComponents.each()) {
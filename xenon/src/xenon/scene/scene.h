@@ -62,10 +62,25 @@ namespace xe {
 	// SECTION: Scene
 	//----------------------------------------
 
+	struct SceneRenderSettings {
+		OcclusionCullingMode occlusionCulling = OcclusionCullingMode::NONE;
+		// Depth only pass before the main pass, removes PBR overdraw at the cost of drawing the geometry twice
+		bool depthPrepass = false;
+	};
+
+	// CPU time of the phases of the last renderScene call in milliseconds
+	struct SceneRenderTimings {
+		float transformTime = 0.0f;		// World matrices and animated model matrices
+		float cullingTime = 0.0f;		// Occlusion tests and LOD selection
+		float submissionTime = 0.0f;	// Lighting, state and draw calls
+	};
+
 	struct Scene {
 		UUID uuid;
 		entt::registry registry;
 		std::unordered_map<UUID, Entity> entityMap;
+		SceneRenderSettings renderSettings;
+		SceneRenderTimings renderTimings;
 	};
 
 	Scene* createScene();
@@ -85,6 +100,8 @@ namespace xe {
 	glm::mat4 toLocalMatrix(glm::mat4 matrix, Entity entity);
 	
 	void renderScene(Scene* scene, const Renderer& renderer, const Camera& camera, const Environment& environment);
+	// Depth tested object IDs only, for framebuffers that keep them separately (see prepareObjectIDFramebuffer)
+	void renderSceneObjectIDs(Scene* scene, const Renderer& renderer, const Camera& camera);
 
 	void copyScene(Scene* source, Scene* target);
 	Scene* createCopy(Scene* scene);
@@ -11,6 +11,7 @@
 
 #include "xenon/core/log.h"
 #include "xenon/core/assert.h"
+#include "xenon/core/profiler.h"
 
 
 namespace xe {
@@ -499,6 +500,7 @@ namespace xe {
 	}
 
 	void updateScriptEntities(ScriptContext* context, float delta) {
+		XE_PROFILE_FUNCTION();
 		auto scripts = context->scene->registry.view<ScriptComponent>();
 		for (auto& [uuid, script] : scripts.each()) {
 			if (context->instanceData.find(context->scene->uuid) == context->instanceData.end()) {
@@ -0,0 +1,105 @@
+#include "bench_report.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+
+namespace xe {
+
+	//----------------------------------------
+	// SECTION: Benchmark report
+	//----------------------------------------
+
+	BenchSummary summarizeBenchSamples(std::vector<float> samples) {
+		BenchSummary summary;
+		if (samples.empty()) {
+			return summary;
+		}
+
+		std::sort(samples.begin(), samples.end());
+		double sum = 0.0;
+		for (float sample : samples) {
+			sum += sample;
+		}
+		summary.mean = (float)(sum / samples.size());
+		summary.median = samples[samples.size() / 2];
+		summary.p95 = samples[std::min(samples.size() - 1, (size_t)(samples.size() * 0.95f))];
+		summary.min = samples.front();
+		summary.max = samples.back();
+		return summary;
+	}
+
+	// Control characters are not allowed inside JSON strings, renderer names and paths can hold tabs or newlines
+	std::string escapeJSON(const std::string& text) {
+		std::string escaped;
+		for (char c : text) {
+			switch (c) {
+			case '"': escaped += "\\\""; break;
+			case '\\': escaped += "\\\\"; break;
+			case '\n': escaped += "\\n"; break;
+			case '\r': escaped += "\\r"; break;
+			case '\t': escaped += "\\t"; break;
+			default:
+				if ((unsigned char)c < 0x20) {
+					char code[8];
+					std::snprintf(code, sizeof(code), "\\u%04x", (unsigned int)(unsigned char)c);
+					escaped += code;
+				}
+				else {
+					escaped += c;
+				}
+				break;
+			}
+		}
+		return escaped;
+	}
+
+	void writeMetricsJSON(std::ostringstream& out, const std::map<std::string, std::vector<float>>& metrics, const char* indent) {
+		out << "{";
+		bool first = true;
+		for (const auto& [name, samples] : metrics) {
+			BenchSummary summary = summarizeBenchSamples(samples);
+			out << (first ? "\n" : ",\n") << indent << "\"" << escapeJSON(name) << "\": { "
+				<< "\"mean\": " << summary.mean << ", \"median\": " << summary.median << ", \"p95\": " << summary.p95
+				<< ", \"min\": " << summary.min << ", \"max\": " << summary.max << " }";
+			first = false;
+		}
+		out << "\n" << std::string(indent).substr(1) << "}";
+	}
+
+	std::string writeBenchReportJSON(const BenchReport& report) {
+		std::ostringstream out;
+		out << "{\n";
+		out << "\t\"version\": 1,\n";
+		out << "\t\"renderer\": \"" << escapeJSON(report.renderer) << "\",\n";
+		out << "\t\"glVersion\": \"" << escapeJSON(report.glVersion) << "\",\n";
+		out << "\t\"width\": " << report.width << ",\n";
+		out << "\t\"height\": " << report.height << ",\n";
+		out << "\t\"warmupFrames\": " << report.warmupFrames << ",\n";
+		out << "\t\"frames\": " << report.frames << ",\n";
+		out << "\t\"scenes\": [";
+
+		for (size_t i = 0; i < report.scenes.size(); ++i) {
+			const BenchSceneResult& scene = report.scenes[i];
+			out << (i == 0 ? "\n" : ",\n") << "\t\t{\n";
+			out << "\t\t\t\"name\": \"" << escapeJSON(scene.desc.name) << "\",\n";
+			out << "\t\t\t\"entities\": " << scene.desc.entities << ",\n";
+			out << "\t\t\t\"models\": " << scene.desc.models << ",\n";
+			out << "\t\t\t\"hierarchyDepth\": " << scene.desc.hierarchyDepth << ",\n";
+			out << "\t\t\t\"pointLights\": " << scene.desc.pointLights << ",\n";
+			out << "\t\t\t\"scriptedEntities\": " << scene.desc.scriptedEntities << ",\n";
+			out << "\t\t\t\"cpu\": ";
+			writeMetricsJSON(out, scene.cpuTimes, "\t\t\t\t");
+			out << ",\n\t\t\t\"gpu\": ";
+			writeMetricsJSON(out, scene.gpuTimes, "\t\t\t\t");
+			out << ",\n\t\t\t\"counters\": ";
+			writeMetricsJSON(out, scene.counters, "\t\t\t\t");
+			out << "\n\t\t}";
+		}
+
+		out << "\n\t]\n";
+		out << "}\n";
+		return out.str();
+	}
+
+}
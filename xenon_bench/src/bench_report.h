@@ -0,0 +1,43 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "bench_scene.h"
+
+namespace xe {
+
+	//----------------------------------------
+	// SECTION: Benchmark report
+	//----------------------------------------
+
+	struct BenchSummary {
+		float mean = 0.0f;
+		float median = 0.0f;
+		float p95 = 0.0f;
+		float min = 0.0f;
+		float max = 0.0f;
+	};
+
+	// One sample per measured frame for each metric, by metric name
+	struct BenchSceneResult {
+		BenchSceneDesc desc;
+		std::map<std::string, std::vector<float>> cpuTimes;	// Milliseconds
+		std::map<std::string, std::vector<float>> gpuTimes;	// Milliseconds
+		std::map<std::string, std::vector<float>> counters;
+	};
+
+	struct BenchReport {
+		std::string renderer;
+		std::string glVersion;
+		int width = 0, height = 0;
+		uint32_t warmupFrames = 0;
+		uint32_t frames = 0;
+		std::vector<BenchSceneResult> scenes;
+	};
+
+	BenchSummary summarizeBenchSamples(std::vector<float> samples);
+	std::string writeBenchReportJSON(const BenchReport& report);
+
+}
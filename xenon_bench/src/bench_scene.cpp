@@ -0,0 +1,148 @@
+#include "bench_scene.h"
+
+#include <cmath>
+#include <random>
+
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace xe {
+
+	// Width of the area the root entities are spread over
+	#define XE_BENCH_SCENE_EXTENT 60.0f
+
+	//----------------------------------------
+	// SECTION: Benchmark scene
+	//----------------------------------------
+
+	std::vector<BenchSceneDesc> getDefaultBenchScenes() {
+		std::vector<BenchSceneDesc> scenes;
+
+		BenchSceneDesc small;
+		small.name = "flat_1k";
+		small.entities = 1000;
+		scenes.push_back(small);
+
+		BenchSceneDesc large;
+		large.name = "flat_10k";
+		large.entities = 10000;
+		large.models = 32;
+		scenes.push_back(large);
+
+		BenchSceneDesc unique;
+		unique.name = "unique_models_1k";
+		unique.entities = 1000;
+		unique.models = 1000;
+		scenes.push_back(unique);
+
+		BenchSceneDesc shallow;
+		shallow.name = "hierarchy_depth_4";
+		shallow.entities = 4000;
+		shallow.hierarchyDepth = 4;
+		scenes.push_back(shallow);
+
+		BenchSceneDesc deep;
+		deep.name = "hierarchy_depth_16";
+		deep.entities = 4000;
+		deep.hierarchyDepth = 16;
+		scenes.push_back(deep);
+
+		BenchSceneDesc lights;
+		lights.name = "lights_64";
+		lights.entities = 1000;
+		lights.pointLights = 64;
+		scenes.push_back(lights);
+
+		return scenes;
+	}
+
+	BenchScene* createBenchScene(const BenchSceneDesc& desc, const std::vector<Model*>& loadedModels) {
+		BenchScene* bench = new BenchScene();
+		bench->desc = desc;
+		bench->scene = createScene();
+
+		std::mt19937 random(desc.seed);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+		// Models, alternating cubes and planes of different sizes so every one is a separate mesh
+		for (uint32_t i = 0; i < desc.models; ++i) {
+			float size = 0.3f + 0.7f * unit(random);
+			Model* model = i % 2 == 0
+				? generateCubeModel(glm::vec3(size, size * (0.5f + unit(random)), size))
+				: generatePlaneModel(size, size, GeneratorDirection::UP);
+			bench->generatedModels.push_back(model);
+			bench->models.push_back(model);
+		}
+		bench->models.insert(bench->models.end(), loadedModels.begin(), loadedModels.end());
+		if (bench->models.empty()) {
+			XE_LOG_ERROR_F("BENCH: Scene {} has no models", desc.name);
+			return bench;
+		}
+
+		// Entities, chains of hierarchyDepth entities with the root placed on a grid
+		uint32_t depth = glm::max(desc.hierarchyDepth, 1u);
+		uint32_t roots = (desc.entities + depth - 1) / depth;
+		uint32_t side = (uint32_t)std::ceil(std::sqrt((float)roots));
+		float spacing = XE_BENCH_SCENE_EXTENT / glm::max(side, 1u);
+
+		UUID parent = UUID::None();
+		for (uint32_t i = 0; i < desc.entities; ++i) {
+			Entity entity = createEntity(bench->scene, "Entity " + std::to_string(i));
+			TransformComponent& transform = entity.getComponent<TransformComponent>();
+
+			uint32_t chainIndex = i % depth;
+			if (chainIndex == 0) {
+				uint32_t root = i / depth;
+				glm::vec3 position = glm::vec3((root % side + 0.5f) * spacing, 0.0f, (root / side + 0.5f) * spacing);
+				position -= glm::vec3(XE_BENCH_SCENE_EXTENT * 0.5f, 0.0f, XE_BENCH_SCENE_EXTENT * 0.5f);
+				transform.matrix = glm::translate(glm::mat4(1.0f), position);
+				transform.matrix = glm::scale(transform.matrix, glm::vec3(spacing * 0.4f));
+			}
+			else {
+				// Children stack up on their parent, rotated so every level has its own matrix
+				transform.matrix = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+				transform.matrix = glm::rotate(transform.matrix, unit(random) * glm::pi<float>(), glm::vec3(0, 1, 0));
+				transform.matrix = glm::scale(transform.matrix, glm::vec3(0.9f));
+				transform.parent = parent;
+			}
+
+			ModelComponent& modelComponent = entity.addComponent<ModelComponent>();
+			modelComponent.model = bench->models[random() % bench->models.size()];
+
+			if (i < desc.scriptedEntities && !desc.scriptModule.empty()) {
+				entity.addComponent<ScriptComponent>(ScriptComponent{ desc.scriptModule });
+			}
+
+			parent = getEntityID(entity);
+		}
+
+		// Point lights above the scene, the renderer uses the first XE_MAX_POINT_LIGHTS
+		for (uint32_t i = 0; i < desc.pointLights; ++i) {
+			Entity light = createEntity(bench->scene, "Light " + std::to_string(i));
+			glm::vec3 position = glm::vec3(unit(random) - 0.5f, 0.2f, unit(random) - 0.5f) * XE_BENCH_SCENE_EXTENT;
+			setTransformPosition(light.getComponent<TransformComponent>(), position);
+			light.addComponent<PointLightComponent>(PointLightComponent{ glm::vec3(unit(random), unit(random), unit(random)) * 50.0f });
+		}
+
+		return bench;
+	}
+
+	void destroyBenchScene(BenchScene* scene) {
+		destroyScene(scene->scene);
+		for (Model* model : scene->generatedModels) {
+			destroyModel(model);
+		}
+		delete scene;
+	}
+
+	Camera createBenchCamera(int width, int height) {
+		Camera camera;
+		camera.near = 0.1f;
+		camera.far = 1000.0f;
+		camera.projection = glm::perspectiveFov(glm::radians(60.0f), (float)width, (float)height, camera.near, camera.far);
+		camera.inverseTransform = glm::lookAt(glm::vec3(0.0f, XE_BENCH_SCENE_EXTENT * 0.5f, XE_BENCH_SCENE_EXTENT), glm::vec3(0.0f), glm::vec3(0, 1, 0));
+		camera.transform = glm::inverse(camera.inverseTransform);
+		return camera;
+	}
+
+}
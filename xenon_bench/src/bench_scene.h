@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <xenon.h>
+
+namespace xe {
+
+	//----------------------------------------
+	// SECTION: Benchmark scene
+	//----------------------------------------
+
+	struct BenchSceneDesc {
+		std::string name;
+		uint32_t entities = 1000;
+		// Unique generated models, glTF models are added on top
+		uint32_t models = 8;
+		// Length of the parent chains, 1 means every entity is a root
+		uint32_t hierarchyDepth = 1;
+		uint32_t pointLights = 4;
+		// Entities with a ScriptComponent of scriptModule, needs a script context
+		uint32_t scriptedEntities = 0;
+		std::string scriptModule;
+		// Random seed of the placement, the same description always builds the same scene
+		uint32_t seed = 1;
+	};
+
+	struct BenchScene {
+		BenchSceneDesc desc;
+		Scene* scene = nullptr;
+		std::vector<Model*> models;
+		// Models owned by the benchmark, loaded glTF models are shared between scenes
+		std::vector<Model*> generatedModels;
+	};
+
+	// Fixed set of scenes covering entity counts, model variety, hierarchy depth and lights
+	std::vector<BenchSceneDesc> getDefaultBenchScenes();
+
+	BenchScene* createBenchScene(const BenchSceneDesc& desc, const std::vector<Model*>& loadedModels);
+	void destroyBenchScene(BenchScene* scene);
+
+	// Camera looking at the whole scene
+	Camera createBenchCamera(int width, int height);
+
+}
@@ -0,0 +1,300 @@
+#include <xenon.h>
+#include <xenon/core/filesystem.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "bench_scene.h"
+#include "bench_report.h"
+
+namespace xe {
+
+	struct BenchOptions {
+		int width = 1280, height = 720;
+		uint32_t warmupFrames = 30;
+		uint32_t frames = 300;
+		std::string outputPath = "xenon_bench.json";
+		std::string imagePath;
+		std::vector<std::string> gltfPaths;
+		std::string scriptAssembly;
+		std::string scriptModule;
+		uint32_t scriptedEntities = 0;
+		// A single scene from the command line instead of the default set
+		bool customScene = false;
+		BenchSceneDesc scene;
+	};
+
+	void printUsage() {
+		std::printf(
+			"Usage: xenon_bench [options]\n"
+			"  --width <px> --height <px>   Render size (1280x720)\n"
+			"  --frames <n>                 Measured frames per scene (300)\n"
+			"  --warmup <n>                 Frames before measuring (30)\n"
+			"  --entities <n>               Run one scene with n entities instead of the default set\n"
+			"  --models <n>                 Unique generated models of the scene (8)\n"
+			"  --depth <n>                  Hierarchy depth of the scene (1)\n"
+			"  --lights <n>                 Point lights of the scene (4)\n"
+			"  --gltf <path>                Add a glTF model to every scene, repeatable\n"
+			"  --scripts <assembly> <module> <n>  Give n entities a script of module\n"
+			"  --output <path>              JSON report (xenon_bench.json)\n"
+			"  --image <path>               Save the last frame of each scene, the scene name is appended\n");
+	}
+
+	bool parseBenchOptions(int argc, char** argv, BenchOptions& options) {
+		for (int i = 1; i < argc; ++i) {
+			std::string arg = argv[i];
+			auto next = [&]() -> const char* { return i + 1 < argc ? argv[++i] : ""; };
+
+			if (arg == "--width") options.width = std::atoi(next());
+			else if (arg == "--height") options.height = std::atoi(next());
+			else if (arg == "--frames") options.frames = std::atoi(next());
+			else if (arg == "--warmup") options.warmupFrames = std::atoi(next());
+			else if (arg == "--entities") { options.scene.entities = std::atoi(next()); options.customScene = true; }
+			else if (arg == "--models") { options.scene.models = std::atoi(next()); options.customScene = true; }
+			else if (arg == "--depth") { options.scene.hierarchyDepth = std::atoi(next()); options.customScene = true; }
+			else if (arg == "--lights") { options.scene.pointLights = std::atoi(next()); options.customScene = true; }
+			else if (arg == "--gltf") options.gltfPaths.push_back(next());
+			else if (arg == "--scripts") {
+				options.scriptAssembly = next();
+				options.scriptModule = next();
+				options.scriptedEntities = std::atoi(next());
+			}
+			else if (arg == "--output") options.outputPath = next();
+			else if (arg == "--image") options.imagePath = next();
+			else {
+				printUsage();
+				return false;
+			}
+		}
+		return options.width > 0 && options.height > 0 && options.frames > 0;
+	}
+
+	// Local to the bench, scene.cpp has its own that also restarts the timer
+	static float millisecondsSince(std::chrono::high_resolution_clock::time_point start) {
+		return std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	BenchSceneResult runBenchScene(Application* application, Renderer* renderer, ScriptContext* scriptContext, Framebuffer* framebuffer,
+		const Environment& environment, const BenchOptions& options, const BenchSceneDesc& desc, const std::vector<Model*>& loadedModels) {
+
+		BenchSceneResult result;
+		result.desc = desc;
+
+		BenchScene* bench = createBenchScene(desc, loadedModels);
+		Camera camera = createBenchCamera(options.width, options.height);
+
+		if (scriptContext && desc.scriptedEntities > 0) {
+			scriptContext->scene = bench->scene;
+			loadSceneScriptEntities(scriptContext, bench->scene);
+			initSceneScriptEntities(scriptContext, bench->scene);
+			startScriptEntities(scriptContext);
+		}
+
+		// GPU scope results arrive XE_GPU_PROFILER_FRAMES frames late, frames are matched by the profiler frame
+		GPUProfiler* profiler = renderer->gpuProfiler;
+		uint64_t firstMeasuredFrame = profiler->frame + options.warmupFrames;
+		uint64_t lastResultsFrame = profiler->resultsFrame;
+		auto collectGPUTimes = [&]() {
+			if (profiler->resultsFrame == lastResultsFrame) {
+				return;
+			}
+			lastResultsFrame = profiler->resultsFrame;
+			if (lastResultsFrame < firstMeasuredFrame) {
+				return;
+			}
+			for (const GPUScopeResult& scope : profiler->results) {
+				result.gpuTimes[scope.name].push_back(scope.time);
+			}
+		};
+		uint32_t droppedFrames = profiler->droppedFrames;
+
+		uint32_t totalFrames = options.warmupFrames + options.frames;
+		for (uint32_t frame = 0; frame < totalFrames; ++frame) {
+			bool measured = frame >= options.warmupFrames;
+			auto frameStart = std::chrono::high_resolution_clock::now();
+
+			updateApplication(application);
+
+			float scriptTime = 0.0f;
+			if (scriptContext && desc.scriptedEntities > 0) {
+				auto scriptStart = std::chrono::high_resolution_clock::now();
+				updateScriptEntities(scriptContext, 1.0f / 60.0f);
+				scriptTime = millisecondsSince(scriptStart);
+			}
+
+			beginRenderFrame(renderer);
+			collectGPUTimes();
+			{
+				XE_GPU_SCOPE("frame");
+				bindFramebuffer(*framebuffer);
+				clearFramebuffer(*framebuffer, *renderer->shader);
+				setTextureStreamingViewport(renderer->textureStreamer, framebuffer->viewportHeight);
+				renderScene(bench->scene, *renderer, camera, environment);
+				unbindFramebuffer();
+			}
+			endRenderFrame(renderer);
+
+			swapBuffers(application);
+
+			if (measured) {
+				const SceneRenderTimings& timings = bench->scene->renderTimings;
+				const RenderStats& stats = getRenderStats(*renderer);
+				result.cpuTimes["frame"].push_back(millisecondsSince(frameStart));
+				result.cpuTimes["transform"].push_back(timings.transformTime);
+				result.cpuTimes["culling"].push_back(timings.cullingTime);
+				result.cpuTimes["submission"].push_back(timings.submissionTime);
+				result.cpuTimes["scripts"].push_back(scriptTime);
+				result.counters["drawCalls"].push_back((float)stats.drawCalls);
+				result.counters["triangles"].push_back((float)stats.triangles);
+				result.counters["shaderBinds"].push_back((float)stats.shaderBinds);
+				result.counters["textureBinds"].push_back((float)stats.textureBinds);
+				result.counters["uniformUploads"].push_back((float)stats.uniformUploads);
+				result.counters["visibleObjects"].push_back((float)stats.visibleObjects);
+				result.counters["culledObjects"].push_back((float)stats.culledObjects);
+			}
+		}
+
+		// Results of the last frames, empty frames only read back the pending ones
+		glFinish();
+		for (uint32_t frame = 0; frame < XE_GPU_PROFILER_FRAMES; ++frame) {
+			beginRenderFrame(renderer);
+			collectGPUTimes();
+			endRenderFrame(renderer);
+		}
+		droppedFrames = profiler->droppedFrames - droppedFrames;
+		if (droppedFrames > 0) {
+			XE_LOG_WARN_F("BENCH: {} GPU frames of {} were not ready in time and have no GPU times", droppedFrames, desc.name);
+		}
+
+		if (!options.imagePath.empty()) {
+			std::string path = options.imagePath;
+			size_t extension = path.find_last_of('.');
+			std::string suffix = "_" + desc.name;
+			path.insert(extension == std::string::npos ? path.size() : extension, suffix);
+			saveFramebufferImage(*framebuffer, path);
+		}
+
+		destroyBenchScene(bench);
+		XE_LOG_INFO_F("BENCH: Finished scene {}", desc.name);
+		return result;
+	}
+
+	Texture* createBlackCubemap() {
+		Texture* texture = createEmptyCubemapTexture(4, TextureFormat::RGB_FLOAT, TextureParameters{ GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE });
+		glClearTexImage(texture->textureID, 0, GL_RGB, GL_FLOAT, nullptr);
+		return texture;
+	}
+
+	void destroyBlackCubemap(Texture* texture) {
+		forgetGLTexture(texture->textureID);
+		glDeleteTextures(1, &texture->textureID);
+		delete texture;
+	}
+
+}
+
+int main(int argc, char** argv) {
+	using namespace xe;
+
+	BenchOptions options;
+	if (!parseBenchOptions(argc, argv, options)) {
+		return 1;
+	}
+
+	XE_SET_LOG_LEVEL(XE_LOG_LEVEL_INFO);
+
+	Application* application = createHeadlessApplication("Xenon benchmark", options.width, options.height);
+	if (!application) {
+		return 1;
+	}
+
+	//----------------------------------------
+	// SECTION: Renderer
+	//----------------------------------------
+
+	Shader* pbrShader = loadShader("assets/shaders/pbr.vert", "assets/shaders/pbr.frag");
+	Shader* pbrQuantizedShader = loadShader("assets/shaders/pbr.vert", "assets/shaders/pbr.frag", XE_SHADER_PERMUTATION_QUANTIZED_VERTICES);
+	Shader* envShader = loadShader("assets/shaders/env.vert", "assets/shaders/env.frag");
+	Renderer* renderer = createRenderer(pbrShader, envShader, pbrQuantizedShader);
+
+	Framebuffer* framebuffer = createFramebuffer(options.width, options.height, 1, renderer->renderTargetPool);
+	framebuffer->attachments.insert(createDefaultFramebufferAttachment(DefaultAttachmentType::COLOR, 0));
+	framebuffer->attachments.insert(createDefaultFramebufferAttachment(DefaultAttachmentType::DEPTH, 0));
+	framebuffer->attachments.insert(createDefaultFramebufferAttachment(DefaultAttachmentType::INTEGER, 1));
+	buildFramebuffer(framebuffer);
+
+	// Image based lighting does not change the cost of the frame, black maps avoid depending on environment assets
+	Environment environment;
+	environment.environmentCubemap = createBlackCubemap();
+	environment.radianceMap = createBlackCubemap();
+
+	std::vector<Model*> loadedModels;
+	for (const std::string& path : options.gltfPaths) {
+		Model* model = loadModel(path);
+		if (model) {
+			loadedModels.push_back(model);
+		}
+	}
+
+	ScriptContext* scriptContext = nullptr;
+	if (!options.scriptAssembly.empty()) {
+		scriptContext = createScriptContext("XenonBenchDomain");
+		loadScriptAssembly(scriptContext, options.scriptAssembly);
+	}
+
+	//----------------------------------------
+	// SECTION: Benchmark
+	//----------------------------------------
+
+	std::vector<BenchSceneDesc> scenes;
+	if (options.customScene) {
+		options.scene.name = "custom";
+		scenes.push_back(options.scene);
+	}
+	else {
+		scenes = getDefaultBenchScenes();
+	}
+
+	BenchReport report;
+	report.renderer = (const char*)glGetString(GL_RENDERER);
+	report.glVersion = (const char*)glGetString(GL_VERSION);
+	report.width = options.width;
+	report.height = options.height;
+	report.warmupFrames = options.warmupFrames;
+	report.frames = options.frames;
+
+	for (BenchSceneDesc& desc : scenes) {
+		if (scriptContext) {
+			desc.scriptModule = options.scriptModule;
+			desc.scriptedEntities = glm::min(options.scriptedEntities, desc.entities);
+		}
+		report.scenes.push_back(runBenchScene(application, renderer, scriptContext, framebuffer, environment, options, desc, loadedModels));
+	}
+
+	// NOTE: Written to a file, the log shares stdout
+	if (saveTextResource(options.outputPath, writeBenchReportJSON(report))) {
+		XE_LOG_INFO_F("BENCH: Report written to {}", options.outputPath);
+	}
+
+	//----------------------------------------
+	// SECTION: Cleanup
+	//----------------------------------------
+
+	if (scriptContext) {
+		destroyScriptContext(scriptContext);
+	}
+	for (Model* model : loadedModels) {
+		destroyModel(model);
+	}
+	destroyBlackCubemap(environment.environmentCubemap);
+	destroyBlackCubemap(environment.radianceMap);
+	destroyFramebuffer(framebuffer);
+	destroyRenderer(renderer);
+	destroyShader(envShader);
+	destroyShader(pbrQuantizedShader);
+	destroyShader(pbrShader);
+	destroyApplication(application);
+
+	return 0;
+}
@@ -73,22 +73,26 @@ int main() {
 	TextureParameters radianceParams = TextureParameters{ GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE };
 	Environment environment;
 	environment.environmentCubemap = loadKTXTexture("assets/environments/output_skybox.ktx", textureParams);
-	environment.irradianceMap = loadKTXTexture("assets/environments/output_iem.ktx", textureParams);
+	environment.irradianceSH = computeIrradianceSH(*environment.environmentCubemap);
 	environment.radianceMap = loadKTXTexture("assets/environments/output_pmrem.ktx", radianceParams);
 	environments.push_back(EnvironmentAsset{ "Meadow" , environment, true });
 
 	Environment darkEnv;
 	darkEnv.environmentCubemap = loadKTXTexture("assets/environments/dark_skybox.ktx", textureParams);
-	darkEnv.irradianceMap = loadKTXTexture("assets/environments/dark_iem.ktx", textureParams);
+	darkEnv.irradianceSH = computeIrradianceSH(*darkEnv.environmentCubemap);
 	darkEnv.radianceMap = loadKTXTexture("assets/environments/dark_pmrem.ktx", radianceParams);
 	environments.push_back(EnvironmentAsset{ "Dark" , darkEnv, true });
 
 	Environment nightEnv;
 	nightEnv.environmentCubemap = loadKTXTexture("assets/environments/night_skybox.ktx", textureParams);
-	nightEnv.irradianceMap = loadKTXTexture("assets/environments/night_iem.ktx", textureParams);
+	nightEnv.irradianceSH = computeIrradianceSH(*nightEnv.environmentCubemap);
 	nightEnv.radianceMap = loadKTXTexture("assets/environments/night_pmrem.ktx", radianceParams);
 	environments.push_back(EnvironmentAsset{ "Night" , darkEnv, true });
 
+	// Environments baked from HDR images at runtime
+	IBLBaker* iblBaker = createIBLBaker();
+	IBLBake* environmentBake = nullptr;
+	std::string environmentBakePath;
 
 
 	//----------------------------------------
@@ -128,19 +132,92 @@ int main() {
 		// SECTION: Render
 		//----------------------------------------
 
-		bindFramebuffer(*editorData->framebuffer);
-		clearFramebuffer(*editorData->framebuffer, *editorData->renderer->shader);
-		renderScene(getActiveScene(editorData), *editorData->renderer, editorData->camera, environments[currentEnvironment].environment);
-		// TODO: Make this nicer
-		// Disable rendering to objectID attachment
-		glNamedFramebufferDrawBuffer(editorData->framebuffer->frambufferID, GL_COLOR_ATTACHMENT0);
-		//renderEnvironment(editorData->renderer, environments[currentEnvironment].environment, editorData->camera);
-		renderGrid(editorData->gridShader, editorData->gridModel, editorData->camera);
-		// Re-enable rendering to objectID attachment
-		glNamedFramebufferDrawBuffers(editorData->framebuffer->frambufferID, editorData->framebuffer->colorBuffers.size(), editorData->framebuffer->colorBuffers.data());
+		beginRenderFrame(editorData->renderer);
+
+		// One step of the environment bake per frame
+		if (environmentBake && updateIBLBake(iblBaker, environmentBake)) {
+			if (environmentBake->stage == IBLBakeStage::DONE) {
+				environments.push_back(EnvironmentAsset{ environmentBake->path, environmentBake->environment, true });
+				currentEnvironment = (int)environments.size() - 1;
+			}
+			destroyIBLBake(environmentBake);
+			environmentBake = nullptr;
+		}
+
+		beginDynamicResolutionFrame(editorData->dynamicResolution, editorData->framebuffer);
+		beginAntiAliasingFrame(editorData->antiAliasing, *editorData->framebuffer, editorData->camera);
+
+		// Scene viewport passes, the graph orders them and culls the ones nothing depends on
+		FrameGraph* frameGraph = editorData->frameGraph;
+		resetFrameGraph(frameGraph);
+
+		Framebuffer* framebuffer = editorData->framebuffer;
+		Framebuffer* displayedFramebuffer = editorData->displayedFramebuffer;
+		// Multisampled framebuffers keep the object IDs single sampled, rendered in a separate pass
+		Framebuffer* objectIDFramebuffer = editorData->antiAliasing->objectIDFramebuffer;
+
+		FrameGraphResource sceneTarget = importFramebuffer(frameGraph, "Scene framebuffer", framebuffer);
+		FrameGraphResource displayedTarget = importFramebuffer(frameGraph, "Displayed framebuffer", displayedFramebuffer);
+		FrameGraphResource objectIDTarget = objectIDFramebuffer ? importFramebuffer(frameGraph, "Object IDs", objectIDFramebuffer) : XE_FRAME_GRAPH_INVALID;
+
+		uint32_t scenePass = addFrameGraphPass(frameGraph, "Scene", [&](const FrameGraph&, const FrameGraphPass&) {
+			bindFramebuffer(*framebuffer);
+			clearFramebuffer(*framebuffer, *editorData->renderer->shader);
+			setTextureStreamingViewport(editorData->renderer->textureStreamer, framebuffer->viewportHeight);
+			renderScene(getActiveScene(editorData), *editorData->renderer, editorData->camera, environments[currentEnvironment].environment);
+		});
+		sceneTarget = writeResource(frameGraph, scenePass, sceneTarget, FrameGraphAccess::ATTACHMENT);
+
+		// Depth pyramid for occlusion culling of the next frames, before the grid writes depth
+		uint32_t occlusionPass = addFrameGraphPass(frameGraph, "Occlusion pyramid", [&](const FrameGraph&, const FrameGraphPass&) {
+			endOcclusionFrame(editorData->renderer->occlusionCuller, *framebuffer, editorData->camera);
+		}, true);
+		readResource(frameGraph, occlusionPass, sceneTarget, FrameGraphAccess::SAMPLED);
+
+		uint32_t gridPass = addFrameGraphPass(frameGraph, "Grid", [&](const FrameGraph&, const FrameGraphPass&) {
+			// TODO: Make this nicer
+			// Disable rendering to objectID attachment
+			glNamedFramebufferDrawBuffer(framebuffer->frambufferID, GL_COLOR_ATTACHMENT0);
+			//renderEnvironment(editorData->renderer, environments[currentEnvironment].environment, editorData->camera);
+			renderGrid(editorData->gridShader, editorData->gridModel, editorData->camera);
+			// Re-enable rendering to objectID attachment
+			glNamedFramebufferDrawBuffers(framebuffer->frambufferID, framebuffer->colorBuffers.size(), framebuffer->colorBuffers.data());
+		});
+		sceneTarget = writeResource(frameGraph, gridPass, sceneTarget, FrameGraphAccess::ATTACHMENT);
+
+		if (objectIDFramebuffer) {
+			uint32_t objectIDPass = addFrameGraphPass(frameGraph, "Object IDs", [&](const FrameGraph&, const FrameGraphPass&) {
+				prepareObjectIDFramebuffer(editorData->antiAliasing, *framebuffer);
+				renderSceneObjectIDs(getActiveScene(editorData), *editorData->renderer, editorData->camera);
+			});
+			objectIDTarget = writeResource(frameGraph, objectIDPass, objectIDTarget, FrameGraphAccess::ATTACHMENT);
+		}
+
+		// Post process AA, restores the unjittered projection
+		uint32_t antiAliasingPass = addFrameGraphPass(frameGraph, "Anti-aliasing", [&](const FrameGraph&, const FrameGraphPass&) {
+			unbindFramebuffer();
+			resolveAntiAliasing(editorData->antiAliasing, framebuffer, editorData->camera);
+		});
+		readResource(frameGraph, antiAliasingPass, sceneTarget, FrameGraphAccess::SAMPLED);
+		sceneTarget = writeResource(frameGraph, antiAliasingPass, sceneTarget, FrameGraphAccess::TRANSFER);
+
+		// Resolve MSAA data and upscale framebuffer into displayedFramebuffer
+		uint32_t resolvePass = addFrameGraphPass(frameGraph, "Resolve", [&](const FrameGraph&, const FrameGraphPass&) {
+			resolveDynamicResolution(editorData->dynamicResolution, framebuffer, displayedFramebuffer);
+			if (objectIDFramebuffer) {
+				blitFramebuffers(objectIDFramebuffer, displayedFramebuffer);
+			}
+		});
+		readResource(frameGraph, resolvePass, sceneTarget, FrameGraphAccess::TRANSFER);
+		if (objectIDFramebuffer) {
+			readResource(frameGraph, resolvePass, objectIDTarget, FrameGraphAccess::TRANSFER);
+		}
+		writeResource(frameGraph, resolvePass, displayedTarget, FrameGraphAccess::TRANSFER);
+
+		if (compileFrameGraph(frameGraph)) {
+			executeFrameGraph(frameGraph);
+		}
 		unbindFramebuffer();
-		// Blit framebuffer data into displayedFramebuffer (resolve AA data)
-		blitFramebuffers(editorData->framebuffer, editorData->displayedFramebuffer);
 		
 
 		//----------------------------------------
@@ -160,28 +237,38 @@ int main() {
 		// SECTION: Test components (components without a proper home yet)
 		//----------------------------------------
 
-		/*
 		// Environment selector
 		if (ImGui::Begin("Environment")) {
 			for (size_t i = 0; i < environments.size(); ++i) {
-				if (ImGui::Button(environments[i].path.c_str())) {
-					currentEnvironment = i;
-					if (!environments[i].loaded) {
-						environments[i].environment = loadIBLCubemap(environments[i].path);
-						environments[i].loaded = true;
-					}
+				if (ImGui::RadioButton(environments[i].path.c_str(), currentEnvironment == (int)i)) {
+					currentEnvironment = (int)i;
 				}
 			}
+
+			ImGui::Separator();
+			ImGui::InputText("HDR image", &environmentBakePath);
+			if (environmentBake) {
+				ImGui::ProgressBar(getIBLBakeProgress(*environmentBake));
+			}
+			else if (ImGui::Button("Bake") && !environmentBakePath.empty()) {
+				environmentBake = startIBLBake(environmentBakePath);
+			}
 		}
 		ImGui::End();
-		*/
 
 		//----------------------------------------
 		// SECTION: Render UI
 		//----------------------------------------
 
 		ImGui::Render();
-		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+		{
+			XE_GPU_SCOPE("ImGui");
+			ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+		}
+		// ImGui changes GL state without going through the state cache
+		invalidateGLState();
+
+		endRenderFrame(editorData->renderer);
 		
 		//----------------------------------------
 		// SECTION: Update framebuffer size and swap buffers
@@ -204,6 +291,10 @@ int main() {
 	// SECTION: Clean-up
 	//----------------------------------------
 
+	if (environmentBake) {
+		destroyIBLBake(environmentBake);
+	}
+	destroyIBLBaker(iblBaker);
 	ImGui::DestroyContext(imguiContext);
 	destroyEditor(editorData);
 	destroyApplication(application);
@@ -11,6 +11,8 @@
 #include "ui/scene_hierarchy.h"
 #include "ui/inspector.h"
 #include "ui/asset_viewer.h"
+#include "ui/render_settings.h"
+#include "ui/render_stats_panel.h"
 
 namespace xe {
 
@@ -21,9 +23,10 @@ namespace xe {
 
 		// Create PBR renderer and shader
 		editor->pbrShader = loadShader("assets/shaders/pbr.vert", "assets/shaders/pbr.frag");
+		editor->pbrQuantizedShader = loadShader("assets/shaders/pbr.vert", "assets/shaders/pbr.frag", XE_SHADER_PERMUTATION_QUANTIZED_VERTICES);
 		editor->envShader = loadShader("assets/shaders/env.vert", "assets/shaders/env.frag");
 		editor->gridShader = loadShader("assets/shaders/grid.vert", "assets/shaders/grid.frag");
-		editor->renderer = createRenderer(editor->pbrShader, editor->envShader);
+		editor->renderer = createRenderer(editor->pbrShader, editor->envShader, editor->pbrQuantizedShader);
 
 		/* NOTE: Only needed for runtime rendering. Only included for reference.
 		// Create framebuffer renderer and shader
@@ -31,19 +34,26 @@ namespace xe {
 		FramebufferRenderer* framebufferRenderer = createFramebufferRenderer(framebufferShader);
 		*/
 
-		// Create framebuffer to render to (multi sampled)
-		editor->framebuffer = createFramebuffer(1920, 1080, 16);
+		// Create framebuffer to render to, built with the sample count of the anti-aliasing mode
+		editor->framebuffer = createFramebuffer(1920, 1080, 1, editor->renderer->renderTargetPool);
 		editor->framebuffer->attachments.insert(createDefaultFramebufferAttachment(DefaultAttachmentType::COLOR, 0));
 		editor->framebuffer->attachments.insert(createDefaultFramebufferAttachment(DefaultAttachmentType::DEPTH, 0));
 		editor->framebuffer->attachments.insert(createDefaultFramebufferAttachment(DefaultAttachmentType::INTEGER, 1));
-		buildFramebuffer(editor->framebuffer);
+		editor->antiAliasing = createAntiAliasing();
+		setAntiAliasingMode(editor->antiAliasing, editor->framebuffer, AntiAliasingMode::MSAA_4X);
 
 		// Create framebuffer to blit to (resolved multi sample)
-		editor->displayedFramebuffer = createFramebuffer(1920, 1080, 1); // No AA
+		editor->displayedFramebuffer = createFramebuffer(1920, 1080, 1, editor->renderer->renderTargetPool); // No AA
 		editor->displayedFramebuffer->attachments.insert(createDefaultFramebufferAttachment(DefaultAttachmentType::COLOR, 0));
 		editor->displayedFramebuffer->attachments.insert(createDefaultFramebufferAttachment(DefaultAttachmentType::INTEGER, 1));
 		buildFramebuffer(editor->displayedFramebuffer);
 
+		// Render resolution of framebuffer, upscaled into displayedFramebuffer
+		editor->dynamicResolution = createDynamicResolution();
+
+		// Passes of the scene viewport, declared every frame
+		editor->frameGraph = createFrameGraph(editor->renderer->renderTargetPool);
+
 		// Grid model
 		editor->gridModel = generatePlaneModel(1, 1, GeneratorDirection::FRONT);
 
@@ -75,12 +85,16 @@ namespace xe {
 
 		destroyModel(data->gridModel);
 
+		destroyFrameGraph(data->frameGraph);
+		destroyDynamicResolution(data->dynamicResolution);
+		destroyAntiAliasing(data->antiAliasing);
 		destroyFramebuffer(data->displayedFramebuffer);
 		destroyFramebuffer(data->framebuffer);
 
 		destroyRenderer(data->renderer);
 		destroyShader(data->gridShader);
 		destroyShader(data->envShader);
+		destroyShader(data->pbrQuantizedShader);
 		destroyShader(data->pbrShader);
 
 		destroyAssetManager(data->assetManager);
@@ -215,7 +229,10 @@ namespace xe {
 			const ImVec2 viewportEnd = data->sceneViewportPos + data->sceneViewportSize;
 
 			// Draw framebuffer
-			ImGui::Image((ImTextureID)data->displayedFramebuffer->attachments.at(GL_COLOR_ATTACHMENT0).texture->textureID, data->sceneViewportSize, ImVec2(0, 1), ImVec2(1, 0));
+			// The pooled texture can be larger than the framebuffer, only show the rendered region
+			const Framebuffer* displayed = data->displayedFramebuffer;
+			ImVec2 regionUV = ImVec2((float)displayed->viewportWidth / displayed->textureWidth, (float)displayed->viewportHeight / displayed->textureHeight);
+			ImGui::Image((ImTextureID)displayed->attachments.at(GL_COLOR_ATTACHMENT0).texture->textureID, data->sceneViewportSize, ImVec2(0, regionUV.y), ImVec2(regionUV.x, 0));
 			
 			// Create hole for inputs
 			ImGui::SetWindowHitTestHole(ImGui::GetCurrentWindow(), data->sceneViewportPos, data->sceneViewportSize);
@@ -283,6 +300,8 @@ namespace xe {
 		drawHierarchy(getActiveScene(data), data->selectedEntityID);
 		drawInspector(data);
 		drawAssetViewer(data);
+		drawRenderSettings(data);
+		drawRenderStatsPanel(data);
 		drawStatusBar(data);
 		drawViewport(data);
 	}
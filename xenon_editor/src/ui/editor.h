@@ -20,12 +20,16 @@ namespace xe {
 
 		// SECTION: Rendering (initialized)
 		Shader* pbrShader = nullptr;
+		Shader* pbrQuantizedShader = nullptr;
 		Shader* envShader = nullptr;
 		Shader* gridShader = nullptr;
 		Renderer* renderer = nullptr;
 
 		Framebuffer* framebuffer = nullptr;
 		Framebuffer* displayedFramebuffer = nullptr;
+		DynamicResolution* dynamicResolution = nullptr;
+		AntiAliasing* antiAliasing = nullptr;
+		FrameGraph* frameGraph = nullptr;
 
 		Model* gridModel = nullptr;
 
@@ -155,9 +155,20 @@ namespace xe {
 			if (ImGui::InputAsset("###modelPath", manager, AssetType::Model, &asset)) {
 				destroyModel(modelComponent.model);
 				modelComponent.model = static_cast<Model*>(asset);
+				modelComponent.currentLOD = 0;
 			}
 			endField();
 
+			beginField("LOD bias");
+			ImGui::DragFloat("###LOD bias", &modelComponent.lodBias, 0.05f, -4.0f, 4.0f);
+			endField();
+
+			if (modelComponent.model) {
+				beginField("LOD");
+				ImGui::Text("%i / %i", modelComponent.currentLOD, modelComponent.model->lodCount);
+				endField();
+			}
+
 			// Material
 			if (modelComponent.model) {
 				for (auto& material : modelComponent.model->materials) {
@@ -31,6 +31,10 @@ namespace xe {
 							ImGui::Text(("Count: " + std::to_string(primitive.count)).c_str());
 							ImGui::Text(("EBO: " + std::to_string(primitive.ebo)).c_str());
 							ImGui::Text(("IndexType: " + std::to_string(primitive.indexType)).c_str());
+							ImGui::Text("VertexFormat: %s", primitive.vertexFormat == VertexFormat::QUANTIZED ? "Quantized" : "Float");
+							for (uint8_t level = 0; level < primitive.lodCount; ++level) {
+								ImGui::Text("LOD %i: %i indices, error %f", level, primitive.lods[level].count, primitive.lods[level].error);
+							}
 
 							ImGui::TreePop();
 						}
@@ -0,0 +1,98 @@
+#include "render_settings.h"
+
+#include <imgui.h>
+
+namespace xe {
+
+	void drawOcclusionSettings(EditorData* data, Scene* scene) {
+		const char* modes[] = { "None", "CPU readback", "GPU compute" };
+		int mode = (int)scene->renderSettings.occlusionCulling;
+		if (ImGui::Combo("Occlusion culling", &mode, modes, IM_ARRAYSIZE(modes))) {
+			scene->renderSettings.occlusionCulling = (OcclusionCullingMode)mode;
+		}
+
+		const OcclusionCuller* culler = data->renderer->occlusionCuller;
+		if (culler && culler->mode != OcclusionCullingMode::NONE) {
+			ImGui::Text("Culled %u / %u", culler->lastFrameStats.culled, culler->lastFrameStats.tested);
+		}
+	}
+
+	void drawDepthPrepassSettings(EditorData* data, Scene* scene) {
+		ImGui::Checkbox("Depth prepass", &scene->renderSettings.depthPrepass);
+	}
+
+	void drawAntiAliasingSettings(EditorData* data) {
+		const char* modes[] = { "None", "MSAA 2x", "MSAA 4x", "MSAA 8x", "FXAA", "TAA" };
+		int mode = (int)data->antiAliasing->mode;
+		if (ImGui::Combo("Anti-aliasing", &mode, modes, IM_ARRAYSIZE(modes))) {
+			setAntiAliasingMode(data->antiAliasing, data->framebuffer, (AntiAliasingMode)mode);
+		}
+	}
+
+	void drawDynamicResolutionSettings(EditorData* data) {
+		DynamicResolution* resolution = data->dynamicResolution;
+		DynamicResolutionSettings& settings = resolution->settings;
+
+		if (ImGui::TreeNodeEx("Dynamic resolution", ImGuiTreeNodeFlags_DefaultOpen)) {
+			ImGui::Checkbox("Enabled", &settings.enabled);
+			ImGui::DragFloat("Target GPU time (ms)", &settings.targetGPUTime, 0.1f, 1.0f, 100.0f);
+			ImGui::DragFloatRange2("Scale", &settings.minScale, &settings.maxScale, 0.01f, XE_DYNAMIC_RESOLUTION_STEP, 1.0f);
+
+			const char* filters[] = { "Bilinear", "Sharpen" };
+			int filter = (int)settings.filter;
+			if (ImGui::Combo("Upscale filter", &filter, filters, IM_ARRAYSIZE(filters))) {
+				settings.filter = (UpscaleFilter)filter;
+			}
+			if (settings.filter == UpscaleFilter::SHARPEN) {
+				ImGui::SliderFloat("Sharpness", &settings.sharpness, 0.0f, 1.0f);
+			}
+
+			const Framebuffer* framebuffer = data->framebuffer;
+			ImGui::Text("GPU time %.2f ms", resolution->gpuTime);
+			ImGui::Text("Render size %ux%u (%.0f%%)", framebuffer->viewportWidth, framebuffer->viewportHeight, resolution->scale * 100.0f);
+			ImGui::TreePop();
+		}
+	}
+
+	void drawRenderTargetPoolStats(EditorData* data) {
+		const RenderTargetPoolStats& stats = data->renderer->renderTargetPool->stats;
+		if (ImGui::TreeNode("Render targets")) {
+			ImGui::Text("Targets %u (%u idle)", stats.targets, stats.idleTargets);
+			ImGui::Text("Memory %.1f MB (%.1f MB idle)", stats.memory / (1024.0f * 1024.0f), stats.idleMemory / (1024.0f * 1024.0f));
+			ImGui::Text("Allocations %u, reuses %u, evictions %u", stats.allocations, stats.reuses, stats.evictions);
+			ImGui::TreePop();
+		}
+	}
+
+	void drawFrameGraph(EditorData* data) {
+		if (ImGui::TreeNode("Frame graph")) {
+			// The graph of the last frame stays compiled until the next frame declares its passes
+			std::string dump = dumpFrameGraph(*data->frameGraph);
+			if (ImGui::Button("Log")) {
+				XE_LOG_INFO_F("{}", dump);
+			}
+			ImGui::SameLine();
+			if (ImGui::Button("Export DOT")) {
+				writeFrameGraphDot(*data->frameGraph, "frame_graph.dot");
+			}
+			ImGui::TextUnformatted(dump.c_str());
+			ImGui::TreePop();
+		}
+	}
+
+	void drawRenderSettings(EditorData* data) {
+		if (ImGui::Begin("Render settings")) {
+			Scene* scene = getActiveScene(data);
+			if (scene) {
+				drawOcclusionSettings(data, scene);
+				drawDepthPrepassSettings(data, scene);
+			}
+			drawAntiAliasingSettings(data);
+			drawDynamicResolutionSettings(data);
+			drawRenderTargetPoolStats(data);
+			drawFrameGraph(data);
+		}
+		ImGui::End();
+	}
+
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <xenon.h>
+#include "editor.h"
+
+namespace xe {
+
+	void drawRenderSettings(EditorData* data);
+
+}
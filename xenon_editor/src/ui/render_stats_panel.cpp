@@ -0,0 +1,129 @@
+#include "render_stats_panel.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <string>
+
+#include <imgui.h>
+
+namespace xe {
+
+	// Plots one counter over the frames of the history, oldest frame first
+	template<typename T>
+	void plotRenderStat(const char* label, const RenderStatsHistory& history, T RenderStats::* member) {
+		struct PlotData {
+			const RenderStatsHistory* history;
+			T RenderStats::* member;
+		} plotData = { &history, member };
+
+		auto getter = [](void* data, int index) -> float {
+			const PlotData& plot = *(const PlotData*)data;
+			uint32_t age = plot.history->count - 1 - index;
+			return (float)(getRenderStatsHistoryFrame(*plot.history, age).*plot.member);
+		};
+
+		const RenderStats& newest = getRenderStatsHistoryFrame(history, 0);
+		std::string overlay = std::to_string(newest.*member);
+		ImGui::PlotLines(label, getter, &plotData, history.count, 0, overlay.c_str(), 0.0f, FLT_MAX, ImVec2(0, 40));
+	}
+
+	void drawRenderStatsPanel(EditorData* data) {
+		if (ImGui::Begin("Render stats")) {
+			const RenderStats& stats = getRenderStats(*data->renderer);
+			const RenderStatsHistory& history = getRenderStatsHistory(*data->renderer);
+
+			if (ImGui::BeginTable("Counters", 2, ImGuiTableFlags_RowBg)) {
+				auto row = [](const char* name, uint64_t value) {
+					ImGui::TableNextRow();
+					ImGui::TableNextColumn();
+					ImGui::TextUnformatted(name);
+					ImGui::TableNextColumn();
+					ImGui::Text("%llu", (unsigned long long)value);
+				};
+				row("Draw calls", stats.drawCalls);
+				row("Instanced draw calls", stats.instancedDrawCalls);
+				row("Triangles", stats.triangles);
+				row("Vertices", stats.vertices);
+				row("Shader binds", stats.shaderBinds);
+				row("VAO binds", stats.vertexArrayBinds);
+				row("Texture binds", stats.textureBinds);
+				row("Uniform uploads", stats.uniformUploads);
+				row("Buffer bytes uploaded", stats.bufferBytesUploaded);
+				row("Visible objects", stats.visibleObjects);
+				row("Culled objects", stats.culledObjects);
+				row("Framebuffer blits", stats.framebufferBlits);
+				ImGui::EndTable();
+			}
+
+			const GPUProfiler* profiler = data->renderer->gpuProfiler;
+			if (profiler && ImGui::TreeNode("GPU time")) {
+				if (ImGui::BeginTable("GPU scopes", 3, ImGuiTableFlags_RowBg)) {
+					ImGui::TableSetupColumn("Scope");
+					ImGui::TableSetupColumn("ms");
+					ImGui::TableSetupColumn("Average ms");
+					ImGui::TableHeadersRow();
+					for (const GPUScopeResult& result : profiler->results) {
+						ImGui::TableNextRow();
+						ImGui::TableNextColumn();
+						// Nested scopes indented by their depth
+						ImGui::Text("%*s%s", result.depth * 2, "", result.name.c_str());
+						ImGui::TableNextColumn();
+						ImGui::Text("%.3f", result.time);
+						ImGui::TableNextColumn();
+						ImGui::Text("%.3f", result.averageTime);
+					}
+					ImGui::EndTable();
+				}
+				ImGui::Text("Dropped frames %u", profiler->droppedFrames);
+				ImGui::TreePop();
+			}
+
+			TextureStreamer* streamer = data->renderer->textureStreamer;
+			if (streamer && ImGui::TreeNode("Texture streaming")) {
+				const float megabyte = 1024.0f * 1024.0f;
+				int budget = (int)(streamer->budget / (1024 * 1024));
+				if (ImGui::SliderInt("Budget (MB)", &budget, 16, 4096)) {
+					streamer->budget = (uint64_t)budget * 1024 * 1024;
+				}
+				ImGui::Text("Resident %.1f MB, loading %.1f MB", streamer->residentBytes / megabyte, streamer->pendingBytes / megabyte);
+				ImGui::Text("%zu textures, %u loads in flight", streamer->textures.size(), streamer->loadsInFlight);
+				ImGui::Text("Levels streamed %llu, evicted %llu", (unsigned long long)streamer->streamedLevels, (unsigned long long)streamer->evictedLevels);
+				ImGui::TreePop();
+			}
+
+			if (ImGui::TreeNode("CPU capture")) {
+#ifndef XE_NO_PROFILE
+				static int captureFrames = XE_PROFILER_DEFAULT_CAPTURE_FRAMES;
+				const ProfilerCaptureInfo& capture = getProfilerCaptureInfo();
+				ImGui::InputInt("Frames", &captureFrames);
+				captureFrames = std::clamp(captureFrames, 1, 1000);
+				if (capture.capturing || capture.pending) {
+					ImGui::Text("Capturing frame %u of %u", capture.capturedFrames, capture.requestedFrames);
+				}
+				else if (ImGui::Button("Capture")) {
+					startProfilerCapture("xenon_trace.json", (uint32_t)captureFrames);
+				}
+				if (!capture.path.empty() && !capture.capturing && !capture.pending) {
+					ImGui::Text("%zu events in %s, %zu overwritten", capture.lastEventCount, capture.path.c_str(), capture.lastDroppedEvents);
+				}
+#else
+				ImGui::TextUnformatted("Profiling is compiled out of this build");
+#endif
+				ImGui::TreePop();
+			}
+
+			if (history.count > 0 && ImGui::TreeNode("History")) {
+				plotRenderStat("Draw calls", history, &RenderStats::drawCalls);
+				plotRenderStat("Triangles", history, &RenderStats::triangles);
+				plotRenderStat("Shader binds", history, &RenderStats::shaderBinds);
+				plotRenderStat("Texture binds", history, &RenderStats::textureBinds);
+				plotRenderStat("Uniform uploads", history, &RenderStats::uniformUploads);
+				plotRenderStat("Bytes uploaded", history, &RenderStats::bufferBytesUploaded);
+				plotRenderStat("Visible objects", history, &RenderStats::visibleObjects);
+				ImGui::TreePop();
+			}
+		}
+		ImGui::End();
+	}
+
+}
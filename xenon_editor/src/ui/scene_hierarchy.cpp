@@ -10,7 +10,10 @@ namespace xe {
 		UUID target;
 	};
 
-	void drawHierarchyItemPayloadTarget(UUID id, std::vector<MoveAction>& moveActions) {
+	// NOTE: Hierarchy data is rebuilt every frame and lives in frame memory
+	using HierarchyChildren = FrameMap<UUID, FrameVector<UUID>>;
+
+	void drawHierarchyItemPayloadTarget(UUID id, FrameVector<MoveAction>& moveActions) {
 		if (ImGui::BeginDragDropTarget()) {
 			auto data = ImGui::AcceptDragDropPayload("hierarchyItem");
 			if (data) {
@@ -47,7 +50,7 @@ namespace xe {
 		}
 	}
 
-	void drawHierarchyItem(Scene* scene, UUID id, const std::map<UUID, std::vector<UUID>>& children, std::vector<MoveAction>& moveActions, UUID& selectedItem, bool isRoot = false) {
+	void drawHierarchyItem(Scene* scene, UUID id, const HierarchyChildren& children, FrameVector<MoveAction>& moveActions, UUID& selectedItem, bool isRoot = false) {
 		ImGui::PushID(id); // Avoid colliding names
 
 		IdentityComponent& identity = getEntityFromID(scene, id).getComponent<IdentityComponent>();
@@ -115,10 +118,10 @@ namespace xe {
 		if (ImGui::Begin("Scene heirarchy")) {
 			auto view = scene->registry.view<IdentityComponent, TransformComponent>();
 
-			std::map<UUID, std::vector<UUID>> children;
-			std::vector<UUID> roots;
+			HierarchyChildren children;
+			FrameVector<UUID> roots;
 
-			std::vector<MoveAction> moveActions;
+			FrameVector<MoveAction> moveActions;
 
 			for (const auto [entity, identity, transform] : view.each()) {
 				if (transform.parent.isValid()) {